@@ -0,0 +1,250 @@
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "api/extension_support.h"
+#include "common/config.h"
+#include "common/settings.h"
+#include "extension/extension.h"
+#include "extension/extension_support_internal.h"
+
+#include <benchmark/benchmark.h>
+#include <jsoncons/json.hpp>
+
+namespace
+{
+    std::vector<double>  payload;
+    quasar_settings_t*   extSettings = nullptr;
+
+    quasar_data_source_t sources[] = {
+        { "array", QUASAR_POLLING_CLIENT,     0, 0},
+        {"cached", QUASAR_POLLING_CLIENT, 60000, 0}
+    };
+
+    bool bench_init(quasar_ext_handle handle)
+    {
+        return true;
+    }
+
+    bool bench_shutdown(quasar_ext_handle handle)
+    {
+        return true;
+    }
+
+    bool bench_get_data(size_t srcUid, quasar_data_handle hData, char* args)
+    {
+        quasar_set_data_double_array(hData, payload.data(), payload.size());
+        return true;
+    }
+
+    quasar_settings_t* bench_create_settings(quasar_ext_handle handle)
+    {
+        quasar_settings_t* settings = quasar_create_settings(handle);
+
+        quasar_add_int_setting(handle, settings, "count", "Count", 1, 10000, 1, 64);
+        quasar_add_double_setting(handle, settings, "scale", "Scale", 0.0, 100.0, 0.1, 1.0);
+        quasar_add_bool_setting(handle, settings, "enabled", "Enabled", true);
+
+        return settings;
+    }
+
+    void bench_update_settings(quasar_settings_t* settings)
+    {
+        extSettings = settings;
+    }
+
+    quasar_ext_info_fields_t fields = {"bench", "Benchmark", "1.0", "r52", "Data path benchmark extension", "https://github.com/r52/quasar"};
+
+    quasar_ext_info_t        info   = {
+        QUASAR_API_VERSION,
+        &fields,
+
+        std::size(sources),
+        sources,
+
+        bench_init,             // init
+        bench_shutdown,         // shutdown
+        bench_get_data,         // data
+        bench_create_settings,  // create setting
+        bench_update_settings   // update setting
+    };
+
+    quasar_ext_info_t* bench_load(void)
+    {
+        return &info;
+    }
+
+    void bench_destroy(quasar_ext_info_t* info) {}
+
+    //! Owns the benchmark extension. Config outlives the Extension as its destructor writes settings.
+    struct BenchHost
+    {
+        std::shared_ptr<Config>    config = std::make_shared<Config>();
+        std::unique_ptr<Extension> extension;
+
+        BenchHost() : extension{Extension::LoadInternal("bench", bench_load, bench_destroy, config, nullptr)} { extension->Initialize(); }
+    };
+
+    Extension& GetExtension()
+    {
+        static BenchHost host;
+        return *host.extension;
+    }
+
+    void FillPayload(size_t count)
+    {
+        payload.resize(count);
+        std::iota(payload.begin(), payload.end(), 0.5);
+    }
+
+    template<typename T>
+    std::vector<T> MakeArray(size_t count)
+    {
+        std::vector<T> arr(count);
+        std::iota(arr.begin(), arr.end(), T{});
+        return arr;
+    }
+}  // namespace
+
+static void BM_SetDataIntArray(benchmark::State& state)
+{
+    auto arr = MakeArray<int>(state.range(0));
+
+    for (auto _ : state)
+    {
+        quasar_return_data_t ret;
+        quasar_set_data_int_array(&ret, arr.data(), arr.size());
+        benchmark::DoNotOptimize(ret.val);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetDataIntArray)->Arg(64)->Arg(1024)->Arg(8192);
+
+static void BM_SetDataFloatArray(benchmark::State& state)
+{
+    auto arr = MakeArray<float>(state.range(0));
+
+    for (auto _ : state)
+    {
+        quasar_return_data_t ret;
+        quasar_set_data_float_array(&ret, arr.data(), arr.size());
+        benchmark::DoNotOptimize(ret.val);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetDataFloatArray)->Arg(64)->Arg(1024)->Arg(8192);
+
+static void BM_SetDataDoubleArray(benchmark::State& state)
+{
+    auto arr = MakeArray<double>(state.range(0));
+
+    for (auto _ : state)
+    {
+        quasar_return_data_t ret;
+        quasar_set_data_double_array(&ret, arr.data(), arr.size());
+        benchmark::DoNotOptimize(ret.val);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetDataDoubleArray)->Arg(64)->Arg(1024)->Arg(8192);
+
+static void BM_SetDataStringArray(benchmark::State& state)
+{
+    std::vector<std::string> strings(state.range(0));
+    std::vector<char*>       arr;
+
+    for (size_t i = 0; i < strings.size(); i++)
+    {
+        strings[i] = "string" + std::to_string(i);
+        arr.push_back(strings[i].data());
+    }
+
+    for (auto _ : state)
+    {
+        quasar_return_data_t ret;
+        quasar_set_data_string_array(&ret, arr.data(), arr.size());
+        benchmark::DoNotOptimize(ret.val);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SetDataStringArray)->Arg(64)->Arg(1024)->Arg(8192);
+
+// Full client poll path: PollDataForSending -> getDataFromSource -> get_data -> array conversion
+static void BM_PollData(benchmark::State& state)
+{
+    auto&                          ext = GetExtension();
+    const std::vector<std::string> topics{"bench/array"};
+
+    FillPayload(state.range(0));
+
+    for (auto _ : state)
+    {
+        jsoncons::json j{jsoncons::json_object_arg};
+        ext.PollDataForSending(j, topics, {}, nullptr);
+        benchmark::DoNotOptimize(j);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PollData)->Arg(64)->Arg(1024)->Arg(8192);
+
+// Client poll served from the data cache
+static void BM_PollDataCached(benchmark::State& state)
+{
+    auto&                          ext = GetExtension();
+    const std::vector<std::string> topics{"bench/cached"};
+
+    FillPayload(state.range(0));
+
+    // prime the cache
+    {
+        jsoncons::json j{jsoncons::json_object_arg};
+        ext.PollDataForSending(j, topics, {}, nullptr);
+    }
+
+    for (auto _ : state)
+    {
+        jsoncons::json j{jsoncons::json_object_arg};
+        ext.PollDataForSending(j, topics, {}, nullptr);
+        benchmark::DoNotOptimize(j);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_PollDataCached)->Arg(64)->Arg(1024)->Arg(8192);
+
+static void BM_GetIntSetting(benchmark::State& state)
+{
+    auto& ext = GetExtension();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(quasar_get_int_setting(&ext, extSettings, "count"));
+    }
+}
+BENCHMARK(BM_GetIntSetting);
+
+static void BM_GetDoubleSetting(benchmark::State& state)
+{
+    auto& ext = GetExtension();
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(quasar_get_double_setting(&ext, extSettings, "scale"));
+    }
+}
+BENCHMARK(BM_GetDoubleSetting);
+
+static void BM_GetInternalSetting(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(Settings::internal.port.GetValue());
+    }
+}
+BENCHMARK(BM_GetInternalSetting);
@@ -0,0 +1,205 @@
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "common/flightrecorder.h"
+#include "common/threadpool.h"
+#include "common/timer.h"
+#include "common/util.h"
+#include "server/protocol.h"
+
+#include <benchmark/benchmark.h>
+#include <jsoncons/json.hpp>
+
+// Builds and dumps a frame the way Extension::sendDataToSubscribers does
+static void BM_FrameSerialize(benchmark::State& state)
+{
+    std::vector<double> data(state.range(0));
+    std::iota(data.begin(), data.end(), 0.5);
+
+    const std::string topic = "bench/array";
+    std::string       buffer;
+
+    for (auto _ : state)
+    {
+        buffer.clear();
+
+        jsoncons::json j{
+            jsoncons::json_object_arg,
+            {{topic, jsoncons::json{jsoncons::json_array_arg, data.begin(), data.end()}}, {"errors", jsoncons::json{jsoncons::json_array_arg}}}
+        };
+
+        if (j["errors"].empty())
+        {
+            j.erase("errors");
+        }
+
+        j.dump(buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_FrameSerialize)->Arg(64)->Arg(1024)->Arg(8192);
+
+// Dump only, on an already built frame
+static void BM_FrameDump(benchmark::State& state)
+{
+    std::vector<double> data(state.range(0));
+    std::iota(data.begin(), data.end(), 0.5);
+
+    jsoncons::json j{
+        jsoncons::json_object_arg,
+        {{"bench/array", jsoncons::json{jsoncons::json_array_arg, data.begin(), data.end()}}}
+    };
+    std::string buffer;
+
+    for (auto _ : state)
+    {
+        buffer.clear();
+        j.dump(buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_FrameDump)->Arg(64)->Arg(1024)->Arg(8192);
+
+// Quantizes and writes a frame the way the u8/u16 subscription variants do
+static void BM_FrameQuantize(benchmark::State& state)
+{
+    std::vector<double> data(state.range(0));
+
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (double) i / data.size();
+    }
+
+    const auto            max = (uint16_t) state.range(1);
+    std::vector<uint16_t> quantized(data.size());
+    std::string           buffer;
+
+    for (auto _ : state)
+    {
+        Util::QuantizeUnit(data.data(), data.size(), max, quantized.data());
+
+        buffer.clear();
+        buffer += R"({"bench/array":[)";
+        Util::AppendIntegers(buffer, quantized.data(), quantized.size());
+        buffer += "]}";
+
+        benchmark::DoNotOptimize(buffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_FrameQuantize)->ArgsProduct({{64, 1024, 8192}, {255, 65535}});
+
+// First step of Server::processMessage
+static void BM_ParseSubscribe(benchmark::State& state)
+{
+    const std::string msg = R"({"method":"subscribe","params":{"topics":["win_simple_perf/sysinfo","win_audio_viz/fft"]}})";
+
+    for (auto _ : state)
+    {
+        auto doc = jsoncons::decode_json<ClientMessage>(msg);
+        benchmark::DoNotOptimize(doc);
+    }
+
+    state.SetBytesProcessed(state.iterations() * msg.size());
+}
+BENCHMARK(BM_ParseSubscribe);
+
+static void BM_ParseQuery(benchmark::State& state)
+{
+    const std::string msg = R"({"method":"query","params":{"topics":["applauncher/launch"],"args":"chrome"}})";
+
+    for (auto _ : state)
+    {
+        auto doc = jsoncons::decode_json<ClientMessage>(msg);
+        benchmark::DoNotOptimize(doc);
+    }
+
+    state.SetBytesProcessed(state.iterations() * msg.size());
+}
+BENCHMARK(BM_ParseQuery);
+
+// Timer tick dispatch, reports how late ticks are relative to their scheduled time
+static void BM_TimerDispatch(benchmark::State& state)
+{
+    using namespace std::chrono;
+
+    const auto            interval = (int) state.range(0);
+    std::atomic<uint64_t> ticks{};
+    std::atomic<int64_t>  lateness{};
+
+    Timer                 timer{"bench"};
+
+    timer.setInterval(
+        [&, period = microseconds(interval)](steady_clock::time_point deadline) {
+            lateness.fetch_add(duration_cast<nanoseconds>(steady_clock::now() - (deadline - period)).count(), std::memory_order_relaxed);
+            ticks.fetch_add(1, std::memory_order_release);
+            ticks.notify_one();
+        },
+        interval);
+
+    for (auto _ : state)
+    {
+        auto seen = ticks.load(std::memory_order_acquire);
+        ticks.wait(seen, std::memory_order_acquire);
+    }
+
+    timer.stop();
+
+    const auto n              = std::max<uint64_t>(ticks.load(), 1);
+    state.counters["late_us"] = benchmark::Counter((double) lateness.load() / n / 1000.0);
+}
+BENCHMARK(BM_TimerDispatch)->Arg(1000)->Arg(10000)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// Round trip of a task through the worker pool
+static void BM_PoolDispatch(benchmark::State& state)
+{
+    const auto            priority = static_cast<TaskPriority>(state.range(0));
+
+    ThreadPool            pool;
+    std::atomic<uint64_t> done{};
+
+    for (auto _ : state)
+    {
+        auto seen = done.load(std::memory_order_acquire);
+
+        pool.Push(
+            [&done] {
+                done.fetch_add(1, std::memory_order_release);
+                done.notify_one();
+            },
+            priority);
+
+        done.wait(seen, std::memory_order_acquire);
+    }
+
+    state.SetLabel(ThreadPool::PriorityName(priority));
+}
+BENCHMARK(BM_PoolDispatch)
+    ->Arg(static_cast<int>(TaskPriority::Realtime))
+    ->Arg(static_cast<int>(TaskPriority::Normal))
+    ->Arg(static_cast<int>(TaskPriority::Background))
+    ->UseRealTime();
+
+// Cost of a single flight recorder event, including its timestamp
+static void BM_FlightRecorderRecord(benchmark::State& state)
+{
+    const auto name = FlightRecorder::RegisterName("bench/record");
+
+    for (auto _ : state)
+    {
+        FlightRecorder::Record(FlightRecorder::EventType::Publish, name, FlightRecorder::Now(), 1024);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FlightRecorderRecord)->ThreadRange(1, 4);
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QSettings>
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+// Results are always written as JSON for comparison between builds, unless an output file is given explicitly
+constexpr auto DefaultOutput = "--benchmark_out=quasar_bench.json";
+constexpr auto DefaultFormat = "--benchmark_out_format=json";
+
+int main(int argc, char* argv[])
+{
+    // Keep benchmark settings away from the real configuration
+    QCoreApplication::setOrganizationName("quasar");
+    QCoreApplication::setApplicationName("quasar_bench");
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+
+    QCoreApplication  app(argc, argv);
+
+    std::vector<char*> args(argv, argv + argc);
+
+    const bool         hasOutput = std::any_of(args.begin(), args.end(), [](const char* arg) {
+        return std::string_view{arg}.starts_with("--benchmark_out=");
+    });
+
+    if (!hasOutput)
+    {
+        args.push_back(const_cast<char*>(DefaultOutput));
+        args.push_back(const_cast<char*>(DefaultFormat));
+    }
+
+    spdlog::set_level(spdlog::level::warn);
+
+    int benchArgc = (int) args.size();
+
+    benchmark::Initialize(&benchArgc, args.data());
+
+    if (benchmark::ReportUnrecognizedArguments(benchArgc, args.data()))
+    {
+        return 1;
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
@@ -0,0 +1,308 @@
+#include "capture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "pulse_viz.h"
+
+namespace
+{
+    constexpr int PollTimeoutMs = 100;  // how often a blocked read checks for stop requests
+
+    uint16_t      readLE16(const std::byte* p)
+    {
+        return (uint16_t) ((unsigned) p[0] | ((unsigned) p[1] << 8));
+    }
+
+    uint32_t readLE32(const std::byte* p)
+    {
+        return (uint32_t) readLE16(p) | ((uint32_t) readLE16(p + 2) << 16);
+    }
+
+    bool hasId(const std::byte* p, const char* id)
+    {
+        return std::memcmp(p, id, 4) == 0;
+    }
+}  // namespace
+
+std::unique_ptr<Capture> Capture::Create(const CaptureOptions& options)
+{
+    if (options.backend == "pulse")
+    {
+        return std::make_unique<PulseCapture>(options);
+    }
+
+    if (options.backend == "file" or options.backend == "stdin")
+    {
+        return std::make_unique<StreamCapture>(options);
+    }
+
+    warn("Unknown capture backend {}", options.backend);
+    return nullptr;
+}
+
+// Reads up to size bytes, returning less only at the end of input or when stopped
+size_t StreamCapture::read(std::byte* dest, size_t size, const std::stop_token& token)
+{
+    size_t total = 0;
+
+    while (total < size and !token.stop_requested())
+    {
+        pollfd pfd{.fd = fd, .events = POLLIN, .revents = 0};
+
+        const int ready = ::poll(&pfd, 1, PollTimeoutMs);
+
+        if (ready == 0 or (ready < 0 and errno == EINTR))
+        {
+            continue;
+        }
+
+        if (ready < 0)
+        {
+            // not readable without blocking past a stop request, treat as the end of input
+            warn("Capture input poll failed: {}", std::strerror(errno));
+            break;
+        }
+
+        const auto n = ::read(fd, dest + total, size - total);
+
+        if (n < 0 and errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n <= 0)
+        {
+            break;
+        }
+
+        total += n;
+    }
+
+    return total;
+}
+
+bool StreamCapture::skip(size_t size, const std::stop_token& token)
+{
+    std::byte scratch[4096];
+
+    while (size)
+    {
+        const auto n = read(scratch, std::min(size, sizeof(scratch)), token);
+
+        if (!n)
+        {
+            return false;
+        }
+
+        size -= n;
+    }
+
+    return true;
+}
+
+bool StreamCapture::readHeader(const std::stop_token& token)
+{
+    std::byte  riff[12];
+    const auto n = read(riff, sizeof(riff), token);
+
+    if (token.stop_requested())
+    {
+        return false;
+    }
+
+    if (n < sizeof(riff) or !hasId(riff, "RIFF") or !hasId(riff + 8, "WAVE"))
+    {
+        // raw PCM, keep what was read
+        pending.assign(riff, riff + n);
+        info("Reading raw {} {} Hz {} channel input", pa_sample_format_to_string(options.spec.format), options.spec.rate, options.spec.channels);
+        return true;
+    }
+
+    bool haveFormat = false;
+
+    for (;;)
+    {
+        std::byte chunk[8];
+
+        if (read(chunk, sizeof(chunk), token) < sizeof(chunk))
+        {
+            if (token.stop_requested())
+            {
+                return false;
+            }
+
+            warn("WAV input has no data chunk");
+            return false;
+        }
+
+        const uint32_t size = readLE32(chunk + 4);
+
+        if (hasId(chunk, "fmt "))
+        {
+            std::vector<std::byte> body(size + (size & 1));
+
+            if (size < 16 or read(body.data(), body.size(), token) < body.size())
+            {
+                warn("Invalid WAV fmt chunk");
+                return false;
+            }
+
+            const auto format   = readLE16(body.data());
+            const auto channels = readLE16(body.data() + 2);
+            const auto rate     = readLE32(body.data() + 4);
+            const auto bits     = readLE16(body.data() + 14);
+
+            // WAVE_FORMAT_EXTENSIBLE stores the actual format in its sub format GUID
+            const auto tag = (format == 0xFFFE and size >= 26) ? readLE16(body.data() + 24) : format;
+
+            // 1 is WAVE_FORMAT_PCM, 3 is WAVE_FORMAT_IEEE_FLOAT
+            const bool match = (options.spec.format == PA_SAMPLE_S16LE) ? (tag == 1 and bits == 16) : (tag == 3 and bits == 32);
+
+            if (!match or channels != options.spec.channels or rate != options.spec.rate)
+            {
+                warn("Unsupported WAV format {} with {} bits, {} channels, {} Hz: expected {}, {} channels, {} Hz",
+                    format,
+                    bits,
+                    channels,
+                    rate,
+                    pa_sample_format_to_string(options.spec.format),
+                    options.spec.channels,
+                    options.spec.rate);
+                return false;
+            }
+
+            haveFormat = true;
+        }
+        else if (hasId(chunk, "data"))
+        {
+            if (!haveFormat)
+            {
+                warn("WAV data chunk precedes the fmt chunk");
+                return false;
+            }
+
+            // streamed WAVs may not know their length up front
+            if (size != UINT32_MAX and size != 0)
+            {
+                remaining = size;
+            }
+
+            info("Reading WAV input");
+            return true;
+        }
+        else if (!skip(size + (size & 1), token))
+        {
+            if (token.stop_requested())
+            {
+                return false;
+            }
+
+            warn("WAV input ended before the data chunk");
+            return false;
+        }
+    }
+}
+
+bool StreamCapture::Start(BlockCallback callback)
+{
+    if (options.backend == "stdin")
+    {
+        fd = STDIN_FILENO;
+    }
+    else if ((fd = ::open(options.path.c_str(), O_RDONLY | O_CLOEXEC | O_NONBLOCK)) < 0)
+    {
+        warn("Failed to open {}: {}", options.path, std::strerror(errno));
+        return false;
+    }
+    else
+    {
+        // opened without blocking so that a FIFO without a writer does not hold up startup, reads then wait in poll()
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    }
+
+    remaining = UINT64_MAX;
+    finished  = false;
+    failed    = false;
+    blocks    = 0;
+
+    // the header is read on the capture thread, as stdin or a FIFO may not deliver it for a long time
+    thread    = std::jthread{[this, callback = std::move(callback)](std::stop_token token) {
+        if (!readHeader(token))
+        {
+            failed.store(!token.stop_requested(), std::memory_order_relaxed);
+            finished.store(true, std::memory_order_release);
+            return;
+        }
+
+        const size_t           frameSize = pa_frame_size(&options.spec);
+        const size_t           frames    = std::max<size_t>(1, options.spec.rate * options.fragment / 1000);
+        std::vector<std::byte> block(frames * frameSize);
+
+        size_t                 filled = std::min(pending.size(), block.size());
+        std::copy_n(pending.begin(), filled, block.begin());
+
+        const auto start     = std::chrono::steady_clock::now();
+        uint64_t   delivered = 0;
+
+        while (!token.stop_requested())
+        {
+            const auto want = (size_t) std::min<uint64_t>(block.size() - filled, remaining);
+            const auto n    = read(block.data() + filled, want, token);
+
+            filled += n;
+            remaining -= n;
+
+            const bool eof = !token.stop_requested() and ((n < want) or !remaining);
+
+            // only whole frames are processed
+            const auto bytes = filled - (filled % frameSize);
+
+            if (bytes)
+            {
+                callback({block.data(), bytes});
+                blocks.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            delivered += bytes / frameSize;
+            filled = 0;
+
+            if (eof)
+            {
+                info("Replay finished after {} blocks", blocks.load(std::memory_order_relaxed));
+                finished.store(true, std::memory_order_release);
+                break;
+            }
+
+            if (options.paced)
+            {
+                std::this_thread::sleep_until(start + std::chrono::microseconds(delivered * 1000000 / options.spec.rate));
+            }
+        }
+    }};
+
+    return true;
+}
+
+void StreamCapture::Stop()
+{
+    if (thread.joinable())
+    {
+        thread.request_stop();
+        thread.join();
+    }
+
+    if (fd >= 0 and fd != STDIN_FILENO)
+    {
+        ::close(fd);
+    }
+
+    fd = -1;
+    pending.clear();
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pulse/pulseaudio.h>
+
+//! Capture backend options
+struct CaptureOptions
+{
+    std::string backend{"pulse"};  //!< Backend name, one of pulse, file or stdin
+    std::string device{};          //!< PulseAudio source to capture, default source if empty
+    std::string path{};            //!< Input file of the file backend
+    size_t      fragment{10};      //!< Audio delivered per block in ms
+    size_t      latency{50};       //!< Maximum capture latency in ms, PulseAudio only
+    bool        paced{true};       //!< Deliver file and stdin input at the sample rate instead of as fast as possible
+
+    //! Format of delivered frames, S16LE or FLOAT32LE with up to 8 channels in WAVE order
+    pa_sample_spec spec{.format = PA_SAMPLE_S16LE, .rate = 48000, .channels = 2};
+};
+
+/*! Source of captured audio for the analyzer.
+
+    Backends deliver interleaved frames in the sample spec of their options to the callback passed to Start(),
+    on a thread of their own.
+*/
+class Capture
+{
+public:
+    using BlockCallback = std::function<void(std::span<const std::byte>)>;
+
+    virtual ~Capture()  = default;
+
+    /*! Creates a capture backend
+        \param[in]  options Capture options
+        \return The backend, or nullptr if the backend is unknown
+    */
+    static std::unique_ptr<Capture> Create(const CaptureOptions& options);
+
+    /*! Starts delivering audio
+        Does not wait for input, so errors in the input itself are only reported through Failed().
+        \param[in]  callback    Called with every captured block
+        \return true if capture started, false otherwise
+    */
+    virtual bool                    Start(BlockCallback callback) = 0;
+
+    //! Stops delivering audio, the callback is not called after this returns
+    virtual void                    Stop()                        = 0;
+
+    //! Checks whether a finite input has been delivered completely, or capture stopped on invalid input
+    bool                            Finished() const { return finished.load(std::memory_order_acquire); }
+
+    //! Checks whether capture stopped on invalid input, valid once Finished()
+    bool                            Failed() const { return failed.load(std::memory_order_relaxed); }
+
+    //! Number of blocks delivered so far
+    size_t                          Blocks() const { return blocks.load(std::memory_order_relaxed); }
+
+protected:
+    std::atomic_bool   finished{};
+    std::atomic_bool   failed{};
+    std::atomic_size_t blocks{};
+};
+
+//! Captures from a PulseAudio source through an asynchronous record stream
+class PulseCapture : public Capture
+{
+public:
+    explicit PulseCapture(const CaptureOptions& options) : options{options} {}
+    ~PulseCapture() override { Stop(); }
+
+    bool Start(BlockCallback callback) override;
+    void Stop() override;
+
+private:
+    static void           contextStateCallback(pa_context* c, void* userdata);
+    static void           streamStateCallback(pa_stream* s, void* userdata);
+    static void           streamReadCallback(pa_stream* s, size_t nbytes, void* userdata);
+
+    bool                  connectStream();
+    void                  reportLatency();
+
+    CaptureOptions        options;
+    BlockCallback         callback;
+
+    pa_threaded_mainloop* mainloop = nullptr;  //!< Capture thread, runs the stream callbacks
+    pa_context*           context  = nullptr;
+    pa_stream*            stream   = nullptr;
+
+    size_t                latencyBytes{};    //!< Bytes captured since the last latency report
+    size_t                latencyReports{};  //!< Number of latency reports so far
+};
+
+/*! Replays PCM in the sample spec of the options from a WAV file, a raw file or stdin
+
+    Input starting with a RIFF header is parsed as WAV and must match the sample spec, anything else is
+    read as raw interleaved frames.
+*/
+class StreamCapture : public Capture
+{
+public:
+    explicit StreamCapture(const CaptureOptions& options) : options{options} {}
+    ~StreamCapture() override { Stop(); }
+
+    bool Start(BlockCallback callback) override;
+    void Stop() override;
+
+private:
+    bool                   readHeader(const std::stop_token& token);
+    size_t                 read(std::byte* dest, size_t size, const std::stop_token& token);
+    bool                   skip(size_t size, const std::stop_token& token);
+
+    CaptureOptions         options;
+
+    int                    fd = -1;
+    std::vector<std::byte> pending;      //!< Raw input consumed while probing for a header
+    uint64_t               remaining{};  //!< Bytes left in the WAV data chunk
+    std::jthread           thread;
+};
@@ -0,0 +1,245 @@
+#include "capture.h"
+
+#include <algorithm>
+
+#include "pulse_viz.h"
+
+namespace
+{
+    constexpr size_t LatencyReportInterval = 10;  // seconds of audio between measured latency reports
+}  // namespace
+
+void PulseCapture::contextStateCallback(pa_context* c, void* userdata)
+{
+    pa_threaded_mainloop_signal(static_cast<PulseCapture*>(userdata)->mainloop, 0);
+}
+
+void PulseCapture::streamStateCallback(pa_stream* s, void* userdata)
+{
+    pa_threaded_mainloop_signal(static_cast<PulseCapture*>(userdata)->mainloop, 0);
+}
+
+// Runs on the mainloop thread whenever captured audio is available
+void PulseCapture::streamReadCallback(pa_stream* s, size_t nbytes, void* userdata)
+{
+    auto self = static_cast<PulseCapture*>(userdata);
+
+    while (pa_stream_readable_size(s) > 0)
+    {
+        const void* data = nullptr;
+
+        if (pa_stream_peek(s, &data, &nbytes) < 0)
+        {
+            warn("pa_stream_peek error: {}", pa_strerror(pa_context_errno(self->context)));
+            return;
+        }
+
+        if (!nbytes)
+        {
+            break;
+        }
+
+        // data is null for holes in the stream, which are skipped
+        if (data)
+        {
+            self->callback({static_cast<const std::byte*>(data), nbytes});
+            self->blocks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        pa_stream_drop(s);
+
+        self->latencyBytes += nbytes;
+
+        // report once after the first second, then periodically
+        const size_t interval = (self->latencyReports ? LatencyReportInterval : 1) * pa_bytes_per_second(&self->options.spec);
+
+        if (self->latencyBytes >= interval)
+        {
+            self->reportLatency();
+            self->latencyBytes = 0;
+        }
+    }
+}
+
+void PulseCapture::reportLatency()
+{
+    pa_usec_t usec     = 0;
+    int       negative = 0;
+
+    if (pa_stream_get_latency(stream, &usec, &negative) < 0)
+    {
+        // no timing info yet
+        return;
+    }
+
+    const double ms = (negative ? -1.0 : 1.0) * usec / 1000.0;
+
+    if (!latencyReports++)
+    {
+        info("Measured capture latency {:.1f} ms", ms);
+    }
+    else
+    {
+        debug("Measured capture latency {:.1f} ms", ms);
+    }
+}
+
+bool PulseCapture::Start(BlockCallback cb)
+{
+    callback       = std::move(cb);
+    latencyBytes   = 0;
+    latencyReports = 0;
+
+    mainloop       = pa_threaded_mainloop_new();
+
+    if (!mainloop)
+    {
+        warn("pa_threaded_mainloop_new failed");
+        return false;
+    }
+
+    context = pa_context_new(pa_threaded_mainloop_get_api(mainloop), "Quasar pulse_viz");
+
+    if (!context)
+    {
+        warn("pa_context_new failed");
+        Stop();
+        return false;
+    }
+
+    pa_context_set_state_callback(context, contextStateCallback, this);
+
+    if (pa_context_connect(context, nullptr, PA_CONTEXT_NOFLAGS, nullptr) < 0)
+    {
+        warn("pa_context_connect error: {}", pa_strerror(pa_context_errno(context)));
+        Stop();
+        return false;
+    }
+
+    pa_threaded_mainloop_lock(mainloop);
+
+    bool success = (pa_threaded_mainloop_start(mainloop) == 0) and connectStream();
+
+    pa_threaded_mainloop_unlock(mainloop);
+
+    if (!success)
+    {
+        Stop();
+    }
+
+    return success;
+}
+
+void PulseCapture::Stop()
+{
+    if (mainloop)
+    {
+        pa_threaded_mainloop_stop(mainloop);
+    }
+
+    if (stream)
+    {
+        pa_stream_disconnect(stream);
+        pa_stream_unref(stream);
+        stream = nullptr;
+    }
+
+    if (context)
+    {
+        pa_context_disconnect(context);
+        pa_context_unref(context);
+        context = nullptr;
+    }
+
+    if (mainloop)
+    {
+        pa_threaded_mainloop_free(mainloop);
+        mainloop = nullptr;
+    }
+}
+
+// Connects a record stream and waits until it is ready, called with the mainloop locked
+bool PulseCapture::connectStream()
+{
+    for (;;)
+    {
+        const auto state = pa_context_get_state(context);
+
+        if (state == PA_CONTEXT_READY)
+        {
+            break;
+        }
+
+        if (!PA_CONTEXT_IS_GOOD(state))
+        {
+            warn("Failed to connect to PulseAudio server: {}", pa_strerror(pa_context_errno(context)));
+            return false;
+        }
+
+        pa_threaded_mainloop_wait(mainloop);
+    }
+
+    info("Connected to PulseAudio server");
+
+    // WAVE channel order, which is the order of the Channel enum
+    pa_channel_map map;
+    pa_channel_map_init_extend(&map, options.spec.channels, PA_CHANNEL_MAP_WAVEEX);
+
+    stream = pa_stream_new(context, "Audio Visualization Data", &options.spec, &map);
+
+    if (!stream)
+    {
+        warn("pa_stream_new error: {}", pa_strerror(pa_context_errno(context)));
+        return false;
+    }
+
+    pa_stream_set_state_callback(stream, streamStateCallback, this);
+    pa_stream_set_read_callback(stream, streamReadCallback, this);
+
+    // fragsize sets how much audio is delivered per callback, maxlength caps how far capture may fall behind
+    const size_t   fragment = std::max<size_t>(1, options.fragment);
+    const size_t   latency  = std::max(fragment, options.latency);
+
+    pa_buffer_attr attr;
+    attr.maxlength   = (uint32_t) pa_usec_to_bytes(latency * PA_USEC_PER_MSEC, &options.spec);
+    attr.tlength     = (uint32_t) -1;
+    attr.prebuf      = (uint32_t) -1;
+    attr.minreq      = (uint32_t) -1;
+    attr.fragsize    = (uint32_t) pa_usec_to_bytes(fragment * PA_USEC_PER_MSEC, &options.spec);
+
+    const auto flags = (pa_stream_flags_t) (PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING);
+
+    if (pa_stream_connect_record(stream, options.device.empty() ? nullptr : options.device.c_str(), &attr, flags) < 0)
+    {
+        warn("pa_stream_connect_record error: {}", pa_strerror(pa_context_errno(context)));
+        return false;
+    }
+
+    for (;;)
+    {
+        const auto state = pa_stream_get_state(stream);
+
+        if (state == PA_STREAM_READY)
+        {
+            break;
+        }
+
+        if (!PA_STREAM_IS_GOOD(state))
+        {
+            warn("Failed to connect record stream: {}", pa_strerror(pa_context_errno(context)));
+            return false;
+        }
+
+        pa_threaded_mainloop_wait(mainloop);
+    }
+
+    if (const auto* actual = pa_stream_get_buffer_attr(stream))
+    {
+        info("Capturing from {} with fragsize {:.1f} ms, maxlength {:.1f} ms",
+            pa_stream_get_device_name(stream),
+            pa_bytes_to_usec(actual->fragsize, &options.spec) / 1000.0,
+            pa_bytes_to_usec(actual->maxlength, &options.spec) / 1000.0);
+    }
+
+    return true;
+}
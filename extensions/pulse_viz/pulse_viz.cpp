@@ -1,10 +1,11 @@
+#include <algorithm>
 #include <array>
-#include <complex>
+#include <cmath>
+#include <memory>
 #include <mutex>
 #include <ranges>
-#include <shared_mutex>
 #include <span>
-#include <thread>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -14,39 +15,24 @@
 #include <fmt/core.h>
 #include <fmt/xchar.h>
 
-#include <pulse/error.h>
-#include <pulse/simple.h>
+#include <beat.h>
+#include <dsp.h>
+#include <spectrum.h>
 
-#include <kfr/base.hpp>
-#include <kfr/dft.hpp>
-#include <kfr/dsp.hpp>
+#include "capture.h"
+#include "pulse_viz.h"
+#include "triplebuffer.h"
 
-constexpr std::string_view EXT_FULLNAME = "PulseAudio Audio Visualization Data";
-constexpr std::string_view EXT_NAME     = "pulse_viz";
-
-#define CLAMP01(x) kfr::clamp(x, 0.0, 1.0)
-
-template<typename T>
-requires std::numeric_limits<T>::is_integer
-constexpr float normalizeAsFloat(T val)
-{
-    constexpr float imax = 1.0f / std::numeric_limits<T>::max();
-    return val * imax;
-}
-
-#define qlog(l, ...)                                                      \
-  {                                                                       \
-    auto msg = fmt::format("{}: {}", EXT_NAME, fmt::format(__VA_ARGS__)); \
-    quasar_log(l, msg.c_str());                                           \
-  }
-
-#define debug(...) qlog(QUASAR_LOG_DEBUG, __VA_ARGS__)
-#define info(...)  qlog(QUASAR_LOG_INFO, __VA_ARGS__)
-#define warn(...)  qlog(QUASAR_LOG_WARNING, __VA_ARGS__)
+#define CLAMP01(x) std::clamp(x, 0.0, 1.0)
 
 quasar_data_source_t sources[] = {
-    { "fft", 16667, 0, 0},
-    {"band", 16667, 0, 0},
+    {       "fft",                   16667, 0, 0},
+    {      "band",                   16667, 0, 0},
+    { "fft_frame", QUASAR_POLLING_SIGNALED, 0, 0},
+    {"band_frame", QUASAR_POLLING_SIGNALED, 0, 0},
+    {       "rms",                   16667, 0, 0},
+    {      "peak",                   16667, 0, 0},
+    {      "beat", QUASAR_POLLING_SIGNALED, 0, 0},
 };
 
 namespace
@@ -55,364 +41,330 @@ namespace
     {
         FFT,
         BAND,
+        FFT_FRAME,
+        BAND_FRAME,
+        RMS,
+        PEAK,
+        BEAT,
         NUM_SOURCES
     };
 
-    enum Channel : uint8_t
-    {
-        CHANNEL_FL,
-        CHANNEL_FR,
-        MAX_CHANNELS
-    };
-
     // Handles and threads
     quasar_ext_handle                  extHandle = nullptr;
-    pa_simple*                         server    = nullptr;
     std::unordered_map<size_t, Source> sourceMap;
-    std::jthread                       pThread;  // Processing thread
-    std::shared_mutex                  mutex;
-
-    // Audio spec
-    constexpr pa_sample_spec spec          = {.format = PA_SAMPLE_S16LE, .rate = 48000, .channels = Channel::MAX_CHANNELS};
-    constexpr size_t         buffer_len_ms = 10;
-    constexpr size_t         buffer_size   = (size_t) (spec.rate * 2 * spec.channels * (buffer_len_ms / 1000.0));
-    constexpr size_t         frame_size    = sizeof(int16_t) * spec.channels;
-    constexpr size_t         num_frames    = buffer_size / frame_size;
+    std::mutex                         mutex;  // Guards DSP state between the capture thread and settings updates
+
+    // Capture
+    std::unique_ptr<Capture>           capture;                    // active capture backend, delivers audio on its own thread
+    CaptureOptions                     captureOptions;             // capture backend options (parsed from options)
+    pa_sample_spec                     spec{captureOptions.spec};  // sample spec of delivered blocks, fixed when capture starts
+
+    // Levels
+    std::array<std::vector<float>, Channel::MAX_CHANNELS> blockIn;        // current block, demuxed into normalized samples per channel
+    std::array<size_t, 2>                                 envRMS{};       // RMS attack/decay times in ms (parsed from options)
+    std::array<size_t, 2>                                 envPeak{};      // peak attack/decay times in ms (parsed from options)
+    std::array<float, 2>                                  kRMS{};         // RMS attack/decay filter constants
+    std::array<float, 2>                                  kPeak{};        // peak attack/decay filter constants
+    std::array<float, Channel::MAX_CHANNELS>              rms{};          // current RMS levels (mean square)
+    std::array<float, Channel::MAX_CHANNELS>              peak{};         // current peak levels
+    double                                                gainRMS{1.0};   // RMS gain (parsed from options)
+    double                                                gainPeak{1.0};  // peak gain (parsed from options)
 
     // DSP
-    size_t                                                           fftSize{};      // size of FFT (parsed from options)
-    size_t                                                           fftOverlap{};   // number of samples between FFT calculations
-    size_t                                                           nBands{};       // number of frequency bands (parsed from options)
-    double                                                           freqMin{};      // min freq for band measurement
-    double                                                           freqMax{};      // max freq for band measurement
-    double                                                           sensitivity{};  // dB range for FFT/Band return values (parsed from options)
-    std::array<size_t, 2>                                            envFFT{};       // FFT attack/decay times in ms (parsed from options)
-
-    std::array<kfr::dft_plan_real_ptr<float>, Channel::MAX_CHANNELS> fftPlan;    // FFT plans for each channel
-    std::array<std::vector<float>, Channel::MAX_CHANNELS>            fftIn;      // buffer for each channel's FFT input
-    std::array<std::vector<float>, Channel::MAX_CHANNELS>            fftOut;     // buffer for each channel's FFT output
-    kfr::univector<float>                                            fftKWdw;    // window function coefficients
-    kfr::univector<float>                                            fftTmpIn;   // temp FFT processing buffer
-    kfr::univector<std::complex<float>>                              fftTmpOut;  // temp FFT processing buffer
-    size_t                                                           fftBufW{};  // write index for input ring buffers
-    int                                                              fftBufP{};  // decremental counter - process FFT at zero
-    std::array<float, 2>                                             kFFT{};     // FFT attack/decay filter constants
-
-    float                                                            fftScalar, bandScalar, df = 0;
-
-    std::array<std::vector<float>, Channel::MAX_CHANNELS>            bandOut;     // buffer of band values
-    std::vector<float>                                               bandFreq{};  // buffer of band max frequencies
-    std::span<std::byte>                                             buffer{};
-    kfr::univector<kfr::u8>                                          temp;
-
-    std::array<std::vector<double>, Source::NUM_SOURCES>             output;  // output buffer
-
-    bool                                                             init_buffers()
+    size_t                                                     fftSize{};      // size of FFT (parsed from options)
+    size_t                                                     fftOverlap{};   // number of samples between FFT calculations
+    size_t                                                     nBands{};       // number of frequency bands (parsed from options)
+    double                                                     freqMin{};      // min freq for band measurement
+    double                                                     freqMax{};      // max freq for band measurement
+    bool                                                       constantQ{};    // compute bands with the constant-Q transform (parsed from options)
+    double                                                     sensitivity{};  // dB range for FFT/Band return values (parsed from options)
+    std::array<size_t, 2>                                      envFFT{};       // FFT attack/decay times in ms (parsed from options)
+    DSP::BeatOptions                                           beatOptions;    // beat tracker options (parsed from options), the hop rate is set per pipeline
+
+    // FFT and band analyzer with the beat tracker it feeds, replaced whole when reconfigured
+    struct Pipeline
+    {
+        DSP::SpectrumAnalyzer analyzer;
+        DSP::BeatTracker      beat;
+    };
+
+    std::unique_ptr<Pipeline>                                  pipeline;
+
+    size_t                                                     frameDecimation{1};  // FFT hops per published frame (parsed from options)
+    size_t                                                     frameHops{};         // FFT hops since the last published frame
+
+    std::array<TripleBuffer<std::vector<double>>, NUM_SOURCES> output;  // output levels, published by the processing thread
+
+    // Builds a pipeline for the current options, without touching the running one
+    std::unique_ptr<Pipeline>                                  build_pipeline()
     {
-        std::lock_guard lk(mutex);
+        auto next = std::make_unique<Pipeline>();
+
+        next->analyzer.Configure({.sampleRate = (double) spec.rate,
+            .channels                         = spec.channels,
+            .fftSize                          = fftSize,
+            .fftOverlap                       = fftOverlap,
+            .envFFT                           = envFFT,
+            .nBands                           = nBands,
+            .freqMin                          = freqMin,
+            .freqMax                          = freqMax,
+            .trackPower                       = true,
+            .constantQ                        = constantQ});
 
         if (fftSize)
         {
-            // output buffers
-            output[Source::FFT].resize((fftSize / 2) + 1, 0.0);
+            const auto&      opts = next->analyzer.Options();
 
-            fftScalar = (float) (1.0 / kfr::sqrt(fftSize));
+            DSP::BeatOptions beat = beatOptions;
+            beat.hopRate          = opts.sampleRate / (double) (opts.fftSize - opts.fftOverlap);
 
-            for (auto&& iChan : std::views::iota((size_t) 0, (size_t) spec.channels))
-            {
-                fftPlan[iChan].reset(new kfr::dft_plan_real<float>(fftSize));
-                fftIn[iChan].resize(fftSize, 0.0f);
-                fftOut[iChan].resize(fftSize, 0.0f);
-                temp.resize(fftPlan[iChan]->temp_size);
-            }
+            next->beat.Configure(beat, next->analyzer.Bins());
+        }
 
-            fftTmpIn.resize(fftSize, 0.0f);
-            fftTmpOut.resize(fftSize, {0.0f, 0.0f});
-            fftBufP = fftSize - fftOverlap;
+        return next;
+    }
 
-            fftKWdw = kfr::window_hann(fftSize);
-        }
+    // Publishes empty output levels to get_data, for both the timed and the signaled source, must hold mutex
+    void clear_levels(Source src, Source frameSrc)
+    {
+        output[src].Back().clear();
+        output[frameSrc].Back().clear();
 
-        if (nBands)
+        output[src].Publish();
+        output[frameSrc].Publish();
+    }
+
+    // Swaps in a new pipeline between two blocks, continuing from the recent input of the old one. Allocations and
+    // plan setup happen in build_pipeline() before the swap and the old pipeline is freed after it, so the capture
+    // thread only ever waits for a few copies and a pointer swap
+    void swap_pipeline(std::unique_ptr<Pipeline> next)
+    {
         {
-            // output buffers
-            output[Source::BAND].resize(nBands, 0.0);
+            std::lock_guard lk(mutex);
 
-            bandScalar = 2.0f / (float) spec.rate;
-            df         = (float) spec.rate / fftSize;
+            if (pipeline)
+            {
+                next->analyzer.Continue(pipeline->analyzer);
+                next->beat.Continue(pipeline->beat);
+            }
 
-            bandFreq.resize(nBands, 0.0f);
-            const double step = (kfr::log(freqMax / freqMin) / nBands) / kfr::log(2.0);
-            bandFreq[0]       = (float) (freqMin * kfr::pow(2.0, step / 2.0));
+            pipeline.swap(next);
+            frameHops = 0;
 
-            for (auto&& iBand : std::views::iota((size_t) 1, nBands))
+            // sources of a disabled analyzer return no data rather than the last levels it published
+            if (!fftSize)
             {
-                bandFreq[iBand] = (float) (bandFreq[iBand - 1] * kfr::pow(2.0, step));
+                clear_levels(Source::FFT, Source::FFT_FRAME);
             }
 
-            for (auto&& iChan : std::views::iota((size_t) 0, (size_t) spec.channels))
+            if (!fftSize or !nBands)
             {
-                bandOut[iChan].resize(nBands, 0.0f);
+                clear_levels(Source::BAND, Source::BAND_FRAME);
             }
         }
 
-        if (!buffer.data())
+        // next now holds the old pipeline, released here outside the lock
+    }
+
+    // Publishes output levels to get_data, for both the timed and the signaled source
+    void publish_levels(Source src, Source frameSrc, size_t count, void (DSP::SpectrumAnalyzer::*levels)(double, double*) const)
+    {
+        auto& out = output[src].Back();
+        out.resize(count);
+
+        (pipeline->analyzer.*levels)(sensitivity, out.data());
+
+        output[frameSrc].Back().assign(out.begin(), out.end());
+
+        output[src].Publish();
+        output[frameSrc].Publish();
+    }
+
+    // Publishes the current RMS and peak levels of every channel, called once per block
+    void publish_meters()
+    {
+        auto& outRMS  = output[Source::RMS].Back();
+        auto& outPeak = output[Source::PEAK].Back();
+
+        outRMS.resize(spec.channels);
+        outPeak.resize(spec.channels);
+
+        for (auto&& iChan : std::views::iota((size_t) 0, (size_t) spec.channels))
         {
-            info("Initializing audio buffer size {}", buffer_size);
-            buffer = std::span{new std::byte[buffer_size](), buffer_size};
+            outRMS[iChan]  = CLAMP01(std::sqrt(rms[iChan]) * gainRMS);
+            outPeak[iChan] = CLAMP01(peak[iChan] * gainPeak);
         }
 
-        return (buffer.data() != nullptr);
+        output[Source::RMS].Publish();
+        output[Source::PEAK].Publish();
     }
-}  // namespace
 
-void pulse_viz_process()
-{
-    int error = 0;
+    // Tracks onsets and tempo, and signals the beat source on onsets only, called once per completed FFT hop
+    void track_beat()
+    {
+        auto& beat = pipeline->beat;
+
+        if (!beat.Update(pipeline->analyzer.Power()))
+        {
+            return;
+        }
 
-    if (pa_simple_read(server, buffer.data(), buffer.size(), &error) == 0)
+        output[Source::BEAT].Back().assign({beat.Strength(), beat.Tempo(), beat.Phase()});
+        output[Source::BEAT].Publish();
+
+        quasar_signal_data_ready(extHandle, sources[Source::BEAT].name);
+    }
+
+    // Publishes the current spectra and signals the frame sources, called once per completed FFT hop
+    void publish_frame()
     {
-        std::lock_guard lk(mutex);
-        if (fftSize)
+        if (++frameHops < frameDecimation)
         {
-            int16_t* sI16 = (int16_t*) buffer.data();
+            return;
+        }
 
-            for ([[maybe_unused]] auto&& _ : std::views::iota((size_t) 0, num_frames))
-            {
-                // fill ring buffers (demux streams)
-                for (auto&& chan : std::views::iota((size_t) 0, (size_t) spec.channels))
-                {
-                    (fftIn[chan])[fftBufW] = normalizeAsFloat(*sI16++);
-                }
-
-                fftBufW = (fftBufW + 1) % fftSize;
-
-                // if overlap limit reached, process FFTs for each channel
-                if (!--fftBufP)
-                {
-                    for (auto&& iChan : std::views::iota((size_t) 0, (size_t) spec.channels))
-                    {
-                        // copy from the ring buffer to temp space
-                        std::memcpy(fftTmpIn.data(), fftIn[iChan].data() + fftBufW, (fftSize - fftBufW) * sizeof(float));
-                        if (fftSize - fftBufW < fftTmpIn.size())
-                        {
-                            std::memcpy(fftTmpIn.data() + (fftSize - fftBufW), fftIn[iChan].data(), fftBufW * sizeof(float));
-                        }
-
-                        // apply the windowing function
-                        fftTmpIn = fftTmpIn * fftKWdw;
-
-                        fftPlan[iChan]->execute(fftTmpOut, fftTmpIn, temp);
-
-                        auto scaled = kfr::cabssqr(fftTmpOut) * fftScalar;
-
-                        // filter the bin levels as with peak measurements
-                        for (auto&& bin : std::views::iota((size_t) 0, fftSize))
-                        {
-                            float x0             = (fftOut[iChan])[bin];
-                            float x1             = kfr::get_element(scaled, {bin});
-                            x0                   = x1 + kFFT[(x1 < x0)] * (x0 - x1);
-                            (fftOut[iChan])[bin] = x0;
-                        }
-                    }
-
-                    fftBufP = fftSize - fftOverlap;
-                }
-            }
+        frameHops = 0;
 
-            // integrate FFT results into log-scale frequency bands
-            if (nBands)
-            {
-                for (auto&& channel : std::views::iota((size_t) 0, (size_t) spec.channels))
-                {
-                    std::fill(bandOut[channel].begin(), bandOut[channel].end(), 0.0f);
-                    size_t iBin  = 0;
-                    size_t iBand = 0;
-                    float  f0    = 0.0f;
-
-                    while (iBin <= (fftSize / 2) and iBand < nBands)
-                    {
-                        float  fLin1 = ((float) iBin + 0.5f) * df;
-                        float  fLog1 = bandFreq[iBand];
-                        float  x     = (fftOut[channel])[iBin];
-                        float& y     = (bandOut[channel])[iBand];
-
-                        if (fLin1 <= fLog1)
-                        {
-                            y += (fLin1 - f0) * x * bandScalar;
-                            f0 = fLin1;
-                            iBin += 1;
-                        }
-                        else
-                        {
-                            y += (fLog1 - f0) * x * bandScalar;
-                            f0 = fLog1;
-                            iBand += 1;
-                        }
-                    }
-                }
-            }
+        // integrate FFT results into log-scale frequency bands
+        if (nBands)
+        {
+            pipeline->analyzer.IntegrateBands();
+
+            publish_levels(Source::BAND, Source::BAND_FRAME, pipeline->analyzer.Bands(), &DSP::SpectrumAnalyzer::BandLevels);
+            quasar_signal_data_ready(extHandle, sources[Source::BAND_FRAME].name);
         }
 
-        pa_simple_flush(server, nullptr);
+        publish_levels(Source::FFT, Source::FFT_FRAME, pipeline->analyzer.Bins(), &DSP::SpectrumAnalyzer::SpectrumLevels);
+        quasar_signal_data_ready(extHandle, sources[Source::FFT_FRAME].name);
+    }
+}  // namespace
+
+void pulse_viz_process(std::span<const std::byte> block)
+{
+    std::lock_guard lk(mutex);
+
+    const size_t    nFrames = block.size() / pa_frame_size(&spec);
+
+    // demux streams
+    std::array<float*, Channel::MAX_CHANNELS> outs{};
+
+    for (auto&& chan : std::views::iota((size_t) 0, (size_t) spec.channels))
+    {
+        blockIn[chan].resize(nFrames);
+        outs[chan] = blockIn[chan].data();
+    }
+
+    if (spec.format == PA_SAMPLE_FLOAT32LE)
+    {
+        DSP::Deinterleave((const float*) block.data(), nFrames, spec.channels, outs.data());
     }
     else
     {
-        warn("pa_simple_read error: {}", pa_strerror(error));
+        DSP::Deinterleave((const int16_t*) block.data(), nFrames, spec.channels, outs.data());
+    }
+
+    // measure RMS and peak levels
+    std::array<const float*, Channel::MAX_CHANNELS> ins{};
+
+    for (auto&& chan : std::views::iota((size_t) 0, (size_t) spec.channels))
+    {
+        ins[chan] = blockIn[chan].data();
     }
+
+    DSP::TrackLevels(ins.data(), nFrames, rms.data(), peak.data(), spec.channels, kRMS, kPeak);
+    publish_meters();
+
+    // run FFTs for every completed hop
+    pipeline->analyzer.Process(ins.data(), nFrames, [] {
+        track_beat();
+        publish_frame();
+    });
 }
 
 bool pulse_viz_init(quasar_ext_handle handle)
 {
     extHandle                 = handle;
+    spec                      = captureOptions.spec;
 
     sourceMap[sources[0].uid] = Source::FFT;
     sourceMap[sources[1].uid] = Source::BAND;
+    sourceMap[sources[2].uid] = Source::FFT_FRAME;
+    sourceMap[sources[3].uid] = Source::BAND_FRAME;
+    sourceMap[sources[4].uid] = Source::RMS;
+    sourceMap[sources[5].uid] = Source::PEAK;
+    sourceMap[sources[6].uid] = Source::BEAT;
 
-    int error                 = 0;
-    server                    = pa_simple_new(nullptr,  // Use the default server.
-        "Quasar pulse_viz",          // Our application's name.
-        PA_STREAM_RECORD,
-        nullptr,                     // Use the default device.
-        "Audio Visualization Data",  // Description of our stream.
-        &spec,                       // Our sample format.
-        nullptr,                     // Use default channel map
-        nullptr,                     // Use default buffering attributes.
-        &error                       // Error code.
-    );
-
-    if (server == nullptr)
-    {
-        warn("pa_simple_new error: {}", pa_strerror(error));
-        return false;
-    }
+    swap_pipeline(build_pipeline());
 
-    info("Connected to PulseAudio server");
+    capture = Capture::Create(captureOptions);
 
-    if (!init_buffers())
+    if (!capture or !capture->Start(pulse_viz_process))
     {
-        warn("Error initializing buffers");
+        warn("Failed to start {} capture", captureOptions.backend);
+        capture.reset();
         return false;
     }
 
-    pThread = std::jthread{[&](std::stop_token token) {
-        while (!token.stop_requested())
-        {
-            pulse_viz_process();
-        }
-    }};
-
-    return (server != nullptr);
+    return true;
 }
 
 bool pulse_viz_shutdown(quasar_ext_handle handle)
 {
-    if (pThread.joinable())
-    {
-        pThread.request_stop();
-        pThread.join();
-    }
-
-    if (server)
+    if (capture)
     {
-        pa_simple_free(server);
-        server = nullptr;
+        capture->Stop();
+        capture.reset();
     }
 
-    for (auto&& iChan : std::views::iota((size_t) 0, (size_t) spec.channels))
-    {
-        if (fftPlan[iChan])
-            fftPlan[iChan].reset();
-    }
-
-    if (buffer.data())
-    {
-        delete[] buffer.data();
-        buffer = std::span<std::byte>();
-    }
+    pipeline.reset();
 
     return true;
 }
 
 bool pulse_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
 {
-    std::shared_lock lk(mutex);
-
-    size_t           type = sourceMap[srcUid];
+    auto it = sourceMap.find(srcUid);
 
-    switch (type)
+    if (it == sourceMap.end())
     {
-        case Source::FFT:
-            {
-                if (fftSize)
-                {
-                    double x;
-
-                    for (auto&& i : std::views::iota((size_t) 0, (fftSize / 2) + 1))
-                    {
-                        if (spec.channels >= 2)
-                        {
-                            x = (fftOut[0][i] + fftOut[1][i]) * 0.5;
-                        }
-                        else
-                        {
-                            x = fftOut[0][i];
-                        }
-
-                        x                      = CLAMP01(x);
-                        x                      = kfr::max(0.0, sensitivity * kfr::log10(x) + 1.0);
-                        output[Source::FFT][i] = x;
-                    }
-
-                    quasar_set_data_double_vector(hData, output[Source::FFT]);
-
-                    return true;
-                }
-                break;
-            }
+        warn("Unknown source uid {}", srcUid);
+        return false;
+    }
 
-        case Source::BAND:
-            {
-                if (nBands)
-                {
-                    double x;
-
-                    for (auto&& i : std::views::iota((size_t) 0, nBands))
-                    {
-                        if (spec.channels >= 2)
-                        {
-                            x = (bandOut[0][i] + bandOut[1][i]) * 0.5;
-                        }
-                        else
-                        {
-                            x = bandOut[0][i];
-                        }
-
-                        x                       = CLAMP01(x);
-                        x                       = kfr::max(0.0, sensitivity * kfr::log10(x) + 1.0);
-                        output[Source::BAND][i] = x;
-                    }
-
-                    quasar_set_data_double_vector(hData, output[Source::BAND]);
-
-                    return true;
-                }
-                break;
-            }
+    // Each source is only read by one thread at a time, which makes it the single reader of its buffer
+    auto& buf = output[it->second];
+
+    buf.Update();
 
-        default:
-            break;
+    if (!buf.Front().empty())
+    {
+        quasar_set_data_double_vector(hData, buf.Front());
     }
 
     return true;
 }
 
+const Capture* pulse_viz_capture()
+{
+    return capture.get();
+}
+
 quasar_settings_t* pulse_viz_create_settings(quasar_ext_handle handle)
 {
     extHandle                   = handle;
 
     quasar_settings_t* settings = quasar_create_settings(extHandle);
 
+    // RMS options
+    quasar_add_int_setting(extHandle, settings, "RMSAttack", "RMSAttack", 0, 100000, 1, 300);
+    quasar_add_int_setting(extHandle, settings, "RMSDecay", "RMSDecay", 0, 100000, 1, 300);
+    quasar_add_double_setting(extHandle, settings, "RMSGain", "RMSGain", 0.0, 1000.0, 0.1, 1.0);
+
+    // Peak options
+    quasar_add_int_setting(extHandle, settings, "PeakAttack", "PeakAttack", 0, 100000, 1, 50);
+    quasar_add_int_setting(extHandle, settings, "PeakDecay", "PeakDecay", 0, 100000, 1, 2500);
+    quasar_add_double_setting(extHandle, settings, "PeakGain", "PeakGain", 0.0, 1000.0, 0.1, 1.0);
+
     // FFT options
     quasar_add_int_setting(extHandle, settings, "FFTSize", "FFTSize (requires power of 2)", 0, 8192, 2, 256);
     quasar_add_int_setting(extHandle, settings, "FFTOverlap", "FFTOverlap", 0, 4096, 1, 0);
@@ -421,7 +373,34 @@ quasar_settings_t* pulse_viz_create_settings(quasar_ext_handle handle)
     quasar_add_int_setting(extHandle, settings, "Bands", "Number of Bands", 0, 1024, 1, 16);
     quasar_add_double_setting(extHandle, settings, "FreqMin", "Band Frequency Min (Hz)", 0.0, 20000.0, 0.1, 20.0);
     quasar_add_double_setting(extHandle, settings, "FreqMax", "Band Frequency Max (Hz)", 0.0, 20000.0, 0.1, 20000.0);
+    quasar_add_bool_setting(extHandle, settings, "ConstantQ", "Compute bands with a constant-Q transform instead of FFT bins", false);
     quasar_add_double_setting(extHandle, settings, "Sensitivity", "Sensitivity", 1.0, 10000.0, 0.1, 35.0);
+    quasar_add_int_setting(extHandle, settings, "FrameDecimation", "FFT hops per fft_frame/band_frame update", 1, 1000, 1, 1);
+
+    // Beat options
+    quasar_add_double_setting(extHandle, settings, "BeatThreshold", "Onset threshold in mean deviations above the mean", 0.1, 20.0, 0.1, 2.0);
+    quasar_add_int_setting(extHandle, settings, "BeatMinBPM", "Slowest tempo considered (BPM)", 30, 300, 1, 60);
+    quasar_add_int_setting(extHandle, settings, "BeatMaxBPM", "Fastest tempo considered (BPM)", 30, 300, 1, 180);
+
+    // Capture options
+    quasar_selection_options_t* backends = quasar_create_selection_setting();
+    quasar_add_selection_option(backends, "PulseAudio", "pulse");
+    quasar_add_selection_option(backends, "WAV or raw PCM file", "file");
+    quasar_add_selection_option(backends, "Standard input", "stdin");
+
+    quasar_add_selection_setting(extHandle, settings, "Backend", "Capture backend (requires restart)", backends);
+    quasar_add_int_setting(extHandle, settings, "CaptureFragment", "Capture fragment size in ms (requires restart)", 1, 1000, 1, 10);
+    quasar_add_int_setting(extHandle, settings, "CaptureLatency", "Maximum capture latency in ms (requires restart)", 1, 2000, 1, 50);
+    quasar_add_string_setting(extHandle, settings, "Device", "Capture device, empty for the default source (requires restart)", "", false);
+    quasar_add_string_setting(extHandle, settings, "InputFile", "Input file for the file backend (requires restart)", "", false);
+    quasar_add_bool_setting(extHandle, settings, "Paced", "Replay files and standard input in real time (requires restart)", true);
+    quasar_add_int_setting(extHandle, settings, "Channels", "Number of channels to capture, 6 for 5.1 or 8 for 7.1 (requires restart)", 1, 8, 1, 2);
+
+    quasar_selection_options_t* formats = quasar_create_selection_setting();
+    quasar_add_selection_option(formats, "16 bit integer", "s16le");
+    quasar_add_selection_option(formats, "32 bit float", "float32le");
+
+    quasar_add_selection_setting(extHandle, settings, "SampleFormat", "Capture sample format (requires restart)", formats);
 
     return settings;
 }
@@ -449,9 +428,10 @@ void pulse_viz_update_settings(quasar_settings_t* settings)
         {
             warn("Invalid FFTOverlap {}: must be an integer between 0 and FFTSize({}).", overlap, fftSize);
         }
-        else
+        else if (overlap != fftOverlap)
         {
-            fftOverlap = overlap;
+            fftOverlap   = overlap;
+            needs_reinit = true;
         }
     }
 
@@ -472,27 +452,72 @@ void pulse_viz_update_settings(quasar_settings_t* settings)
         needs_reinit = true;
     }
 
-    envFFT[0] = quasar_get_uint_setting(extHandle, settings, "FFTAttack");
-    envFFT[1] = quasar_get_uint_setting(extHandle, settings, "FFTDecay");
+    const bool cq = quasar_get_bool_setting(extHandle, settings, "ConstantQ");
+    if (cq != constantQ)
+    {
+        constantQ    = cq;
+        needs_reinit = true;
+    }
+
+    const double beatThreshold = quasar_get_double_setting(extHandle, settings, "BeatThreshold");
+    const double beatMinBPM    = (double) quasar_get_uint_setting(extHandle, settings, "BeatMinBPM");
+    const double beatMaxBPM    = (double) quasar_get_uint_setting(extHandle, settings, "BeatMaxBPM");
+
+    if (beatMinBPM >= beatMaxBPM)
+    {
+        warn("Invalid beat tempo range {} - {} BPM: BeatMinBPM must be lower than BeatMaxBPM.", beatMinBPM, beatMaxBPM);
+    }
+    else if (beatThreshold != beatOptions.threshold or beatMinBPM != beatOptions.minBPM or beatMaxBPM != beatOptions.maxBPM)
+    {
+        beatOptions.threshold = beatThreshold;
+        beatOptions.minBPM    = beatMinBPM;
+        beatOptions.maxBPM    = beatMaxBPM;
+        needs_reinit          = true;
+    }
+
+    envRMS[0]       = quasar_get_uint_setting(extHandle, settings, "RMSAttack");
+    envRMS[1]       = quasar_get_uint_setting(extHandle, settings, "RMSDecay");
+    envPeak[0]      = quasar_get_uint_setting(extHandle, settings, "PeakAttack");
+    envPeak[1]      = quasar_get_uint_setting(extHandle, settings, "PeakDecay");
+    envFFT[0]       = quasar_get_uint_setting(extHandle, settings, "FFTAttack");
+    envFFT[1]       = quasar_get_uint_setting(extHandle, settings, "FFTDecay");
+
+    frameDecimation = std::max<size_t>(1, quasar_get_uint_setting(extHandle, settings, "FrameDecimation"));
+
+    // capture options only apply when capture starts
+    captureOptions.backend  = quasar_get_selection_setting_hpp(extHandle, settings, "Backend");
+    captureOptions.device   = quasar_get_string_setting_hpp(extHandle, settings, "Device");
+    captureOptions.path     = quasar_get_string_setting_hpp(extHandle, settings, "InputFile");
+    captureOptions.fragment = quasar_get_uint_setting(extHandle, settings, "CaptureFragment");
+    captureOptions.latency  = quasar_get_uint_setting(extHandle, settings, "CaptureLatency");
+    captureOptions.paced    = quasar_get_bool_setting(extHandle, settings, "Paced");
+
+    captureOptions.spec.channels = (uint8_t) std::clamp<size_t>(quasar_get_uint_setting(extHandle, settings, "Channels"), 1, Channel::MAX_CHANNELS);
+    captureOptions.spec.format   = (quasar_get_selection_setting_hpp(extHandle, settings, "SampleFormat") == "float32le") ? PA_SAMPLE_FLOAT32LE : PA_SAMPLE_S16LE;
 
     // (re)parse gain constants
+    gainRMS     = quasar_get_double_setting(extHandle, settings, "RMSGain");
+    gainPeak    = quasar_get_double_setting(extHandle, settings, "PeakGain");
     sensitivity = 10.0 / std::max(1.0, quasar_get_double_setting(extHandle, settings, "Sensitivity"));
 
     // regenerate filter constants
-
     const double freq = (double) spec.rate;
+    kRMS[0]           = DSP::EnvelopeCoefficient(freq, envRMS[0]);
+    kRMS[1]           = DSP::EnvelopeCoefficient(freq, envRMS[1]);
+    kPeak[0]          = DSP::EnvelopeCoefficient(freq, envPeak[0]);
+    kPeak[1]          = DSP::EnvelopeCoefficient(freq, envPeak[1]);
 
-    if (fftSize)
+    if (pipeline)
     {
-        kFFT[0] = (float) kfr::exp(kfr::log10(0.01) / (freq / (fftSize - fftOverlap) * (double) envFFT[0] * 0.001));
-        kFFT[1] = (float) kfr::exp(kfr::log10(0.01) / (freq / (fftSize - fftOverlap) * (double) envFFT[1] * 0.001));
+        pipeline->analyzer.SetEnvelope(envFFT);
     }
 
     lk.unlock();
 
-    if (needs_reinit)
+    // settings are applied before init, which builds the first pipeline
+    if (needs_reinit and pipeline)
     {
-        init_buffers();
+        swap_pipeline(build_pipeline());
     }
 }
 
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include <extension_support.h>
+
+#include <fmt/core.h>
+
+constexpr std::string_view EXT_FULLNAME = "PulseAudio Audio Visualization Data";
+constexpr std::string_view EXT_NAME     = "pulse_viz";
+
+#define qlog(l, ...)                                                      \
+  {                                                                       \
+    auto msg = fmt::format("{}: {}", EXT_NAME, fmt::format(__VA_ARGS__)); \
+    quasar_log(l, msg.c_str());                                           \
+  }
+
+#define debug(...) qlog(QUASAR_LOG_DEBUG, __VA_ARGS__)
+#define info(...)  qlog(QUASAR_LOG_INFO, __VA_ARGS__)
+#define warn(...)  qlog(QUASAR_LOG_WARNING, __VA_ARGS__)
+
+enum Channel : uint8_t
+{
+    CHANNEL_FL,
+    CHANNEL_FR,
+    CHANNEL_C,
+    CHANNEL_LFE,
+    CHANNEL_BL,
+    CHANNEL_BR,
+    CHANNEL_SL,
+    CHANNEL_SR,
+    MAX_CHANNELS
+};
+
+class Capture;
+
+/*! Runs a block of captured audio through the analyzer
+    Called on the capture backend's thread.
+    \param[in]  block   Interleaved frames in the sample spec of the capture options
+*/
+void           pulse_viz_process(std::span<const std::byte> block);
+
+/*! Returns the active capture backend, if any
+    Used by pulse_viz_replay to wait for the end of finite inputs.
+*/
+const Capture* pulse_viz_capture();
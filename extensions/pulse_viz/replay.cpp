@@ -0,0 +1,380 @@
+/*! pulse_viz_replay
+
+    Runs pulse_viz against a WAV/raw PCM file or stdin instead of a PulseAudio server, for
+    reproducible DSP benchmarks and golden output tests. Implements just enough of the
+    extension support API to host the extension in process.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <extension_api.h>
+#include <extension_support.hpp>
+
+#include <fmt/core.h>
+
+#include "capture.h"
+#include "pulse_viz.h"
+
+namespace
+{
+    constexpr auto Usage = R"(Usage: pulse_viz_replay [options] <input.wav|input.raw|->
+
+Replays 48 kHz PCM through pulse_viz. Use - to read from stdin. The input must match
+the Channels and SampleFormat settings, 16 bit stereo by default.
+
+Options:
+  --paced               Replay at the sample rate instead of as fast as possible
+  --set <name>=<value>  Override an extension setting, i.e. --set FFTSize=1024
+  --dump <file>         Write every fft_frame and band_frame update to file, one frame per line,
+                        followed by the final value of every timed source
+  --verbose             Log extension info messages
+)";
+
+    struct Host
+    {
+        quasar_ext_info_t*                       ext = nullptr;
+        std::map<std::string, std::string>       settings;   // setting values by name
+        std::map<std::string, std::string>       overrides;  // values given on the command line
+        std::unique_ptr<FILE, decltype(&fclose)> dump{nullptr, &fclose};
+        std::vector<double>                      data;
+        size_t                                   frames{};
+        bool                                     verbose{};
+    };
+
+    Host host;
+
+    // Handles only need to be non-null
+    quasar_ext_handle  hostHandle     = &host;
+    quasar_settings_t* hostSettings   = reinterpret_cast<quasar_settings_t*>(&host.settings);
+
+    void               addSetting(const char* name, std::string dflt)
+    {
+        auto it = host.overrides.find(name);
+        host.settings.insert_or_assign(name, it != host.overrides.end() ? it->second : std::move(dflt));
+    }
+
+    const std::string& getSetting(const char* name)
+    {
+        static const std::string empty;
+
+        auto                     it = host.settings.find(name);
+        return it != host.settings.end() ? it->second : empty;
+    }
+
+    struct Selection
+    {
+        std::vector<std::string> values;
+    };
+}  // namespace
+
+// Extension support API, as far as pulse_viz uses it
+
+char* quasar_strcpy(char* dest, size_t destSize, const char* src, size_t srcSize)
+{
+    const auto len = std::min(strnlen(src, srcSize), destSize - 1);
+    std::memcpy(dest, src, len);
+    dest[len] = '\0';
+    return dest;
+}
+
+void quasar_log(quasar_log_level_t level, const char* msg)
+{
+    if (level >= QUASAR_LOG_WARNING or (level == QUASAR_LOG_INFO and host.verbose))
+    {
+        std::fprintf(stderr, "%s\n", msg);
+    }
+}
+
+quasar_settings_t* quasar_create_settings(quasar_ext_handle handle)
+{
+    return hostSettings;
+}
+
+quasar_selection_options_t* quasar_create_selection_setting(void)
+{
+    return reinterpret_cast<quasar_selection_options_t*>(new Selection);
+}
+
+void quasar_free_selection_setting(quasar_selection_options_t* handle)
+{
+    delete reinterpret_cast<Selection*>(handle);
+}
+
+quasar_selection_options_t* quasar_add_selection_option(quasar_selection_options_t* select, const char* name, const char* value)
+{
+    reinterpret_cast<Selection*>(select)->values.emplace_back(value);
+    return select;
+}
+
+quasar_settings_t* quasar_add_selection_setting(quasar_ext_handle handle,
+    quasar_settings_t*                                           settings,
+    const char*                                                  name,
+    const char*                                                  description,
+    quasar_selection_options_t*                                  select)
+{
+    std::unique_ptr<Selection> sel{reinterpret_cast<Selection*>(select)};
+    addSetting(name, sel->values.empty() ? std::string{} : sel->values.front());
+    return settings;
+}
+
+quasar_settings_t*
+quasar_add_int_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, const char* description, int min, int max, int step, int dflt)
+{
+    addSetting(name, std::to_string(dflt));
+    return settings;
+}
+
+quasar_settings_t* quasar_add_bool_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, const char* description, bool dflt)
+{
+    addSetting(name, dflt ? "true" : "false");
+    return settings;
+}
+
+quasar_settings_t* quasar_add_double_setting(quasar_ext_handle handle,
+    quasar_settings_t*                                         settings,
+    const char*                                                name,
+    const char*                                                description,
+    double                                                     min,
+    double                                                     max,
+    double                                                     step,
+    double                                                     dflt)
+{
+    addSetting(name, fmt::format("{}", dflt));
+    return settings;
+}
+
+quasar_settings_t*
+quasar_add_string_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, const char* description, const char* dflt, bool password)
+{
+    addSetting(name, dflt ? dflt : "");
+    return settings;
+}
+
+intmax_t quasar_get_int_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    return std::strtoll(getSetting(name).c_str(), nullptr, 10);
+}
+
+uintmax_t quasar_get_uint_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    return std::strtoull(getSetting(name).c_str(), nullptr, 10);
+}
+
+bool quasar_get_bool_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    const auto& value = getSetting(name);
+    return value == "true" or value == "1";
+}
+
+double quasar_get_double_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    return std::strtod(getSetting(name).c_str(), nullptr);
+}
+
+bool quasar_get_string_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, char* buf, size_t size)
+{
+    const auto& value = getSetting(name);
+    quasar_strcpy(buf, size, value.c_str(), value.size() + 1);
+    return true;
+}
+
+bool quasar_get_selection_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, char* buf, size_t size)
+{
+    return quasar_get_string_setting(handle, settings, name, buf, size);
+}
+
+std::string_view quasar_get_string_setting_hpp(quasar_ext_handle handle, quasar_settings_t* settings, std::string_view name)
+{
+    return getSetting(std::string{name}.c_str());
+}
+
+std::string_view quasar_get_selection_setting_hpp(quasar_ext_handle handle, quasar_settings_t* settings, std::string_view name)
+{
+    return getSetting(std::string{name}.c_str());
+}
+
+quasar_data_handle quasar_set_data_double_vector(quasar_data_handle hData, const std::vector<double>& vec)
+{
+    *static_cast<std::vector<double>*>(hData) = vec;
+    return hData;
+}
+
+namespace
+{
+    // Reads a data source and writes its value as one line of the dump file
+    void dumpSource(const quasar_data_source_t& source)
+    {
+        host.data.clear();
+        host.ext->get_data(source.uid, &host.data, nullptr);
+
+        std::string line{source.name};
+
+        for (auto v : host.data)
+        {
+            fmt::format_to(std::back_inserter(line), " {:.6f}", v);
+        }
+
+        line.push_back('\n');
+        std::fwrite(line.data(), 1, line.size(), host.dump.get());
+    }
+}  // namespace
+
+// Called on the capture thread once per published frame
+void quasar_signal_data_ready(quasar_ext_handle handle, const char* source)
+{
+    host.frames++;
+
+    if (!host.dump)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < host.ext->numDataSources; i++)
+    {
+        if (std::strcmp(host.ext->dataSources[i].name, source) == 0)
+        {
+            dumpSource(host.ext->dataSources[i]);
+            break;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string input;
+    bool        paced    = false;
+    const char* dumpPath = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg{argv[i]};
+
+        if (arg == "--paced")
+        {
+            paced = true;
+        }
+        else if (arg == "--verbose")
+        {
+            host.verbose = true;
+        }
+        else if (arg == "--set" and i + 1 < argc)
+        {
+            std::string_view kv{argv[++i]};
+            const auto       eq = kv.find('=');
+
+            if (eq == std::string_view::npos)
+            {
+                std::fprintf(stderr, "Invalid setting %s, expected <name>=<value>\n", argv[i]);
+                return 2;
+            }
+
+            host.overrides.insert_or_assign(std::string{kv.substr(0, eq)}, std::string{kv.substr(eq + 1)});
+        }
+        else if (arg == "--dump" and i + 1 < argc)
+        {
+            dumpPath = argv[++i];
+        }
+        else if (input.empty() and (arg == "-" or !arg.starts_with("-")))
+        {
+            input = arg;
+        }
+        else
+        {
+            std::fputs(Usage, stderr);
+            return 2;
+        }
+    }
+
+    if (input.empty())
+    {
+        std::fputs(Usage, stderr);
+        return 2;
+    }
+
+    host.overrides["Backend"]   = (input == "-") ? "stdin" : "file";
+    host.overrides["InputFile"] = input;
+    host.overrides["Paced"]     = paced ? "true" : "false";
+
+    if (dumpPath)
+    {
+        host.dump.reset(std::fopen(dumpPath, "wb"));
+
+        if (!host.dump)
+        {
+            std::fprintf(stderr, "Failed to open %s: %s\n", dumpPath, std::strerror(errno));
+            return 1;
+        }
+    }
+
+    // Load the extension the way Quasar does
+    host.ext = quasar_ext_load();
+
+    for (size_t i = 0; i < host.ext->numDataSources; i++)
+    {
+        host.ext->dataSources[i].uid = i + 1;
+    }
+
+    host.ext->create_settings(hostHandle);
+    host.ext->update(hostSettings);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!host.ext->init(hostHandle))
+    {
+        std::fprintf(stderr, "Failed to initialize pulse_viz\n");
+        return 1;
+    }
+
+    const Capture* capture = pulse_viz_capture();
+
+    while (!capture->Finished())
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (capture->Failed())
+    {
+        std::fprintf(stderr, "Failed to read %s\n", input.c_str());
+        host.ext->shutdown(hostHandle);
+        quasar_ext_destroy(host.ext);
+        return 1;
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const auto                          blocks  = capture->Blocks();
+
+    // Timed sources are only dumped once, with their final value
+    if (host.dump)
+    {
+        for (size_t i = 0; i < host.ext->numDataSources; i++)
+        {
+            if (host.ext->dataSources[i].rate > 0)
+            {
+                dumpSource(host.ext->dataSources[i]);
+            }
+        }
+    }
+
+    host.ext->shutdown(hostHandle);
+    quasar_ext_destroy(host.ext);
+
+    const double audio = blocks * quasar_get_uint_setting(hostHandle, hostSettings, "CaptureFragment") / 1000.0;
+
+    std::printf("%zu blocks (%.2f s of audio) in %.3f s: %.0f blocks/s, %.1fx realtime, %zu source updates\n",
+        blocks,
+        audio,
+        elapsed.count(),
+        blocks / elapsed.count(),
+        audio / elapsed.count(),
+        host.frames);
+
+    return 0;
+}
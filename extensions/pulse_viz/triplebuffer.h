@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*! Lock-free triple buffer for a single writer and a single reader.
+
+    The writer fills Back() and hands it over with Publish(). The reader picks up the most
+    recently published buffer with Update() and reads it through Front(). Neither side ever
+    blocks or waits on the other, and the reader only ever sees complete buffers. Buffers are
+    recycled, so containers keep their capacity and steady state publishing does not allocate.
+*/
+template<typename T>
+class TripleBuffer
+{
+public:
+    //! Buffer owned by the writer
+    T&   Back() { return buffers[back]; }
+
+    //! Publishes the back buffer, replacing any buffer the reader has not picked up yet
+    void Publish() { back = middle.exchange(back | Fresh, std::memory_order_acq_rel) & IndexMask; }
+
+    /*! Picks up the most recently published buffer, if there is one
+        \return true if Front() changed
+    */
+    bool Update()
+    {
+        if (!(middle.load(std::memory_order_relaxed) & Fresh))
+        {
+            return false;
+        }
+
+        front = middle.exchange(front, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+
+    //! Buffer owned by the reader
+    const T& Front() const { return buffers[front]; }
+
+private:
+    static constexpr uint8_t IndexMask = 0x3;
+    static constexpr uint8_t Fresh     = 0x4;  //!< Set in middle when it holds a buffer the reader has not seen
+
+    std::array<T, 3>                 buffers{};
+    alignas(64) std::atomic<uint8_t> middle{1};  //!< Index of the buffer in transit, plus the Fresh flag
+    alignas(64) uint8_t              back{0};    //!< Writer's buffer
+    alignas(64) uint8_t              front{2};   //!< Reader's buffer
+};
@@ -0,0 +1,182 @@
+#include "beat.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "dsp.h"
+
+namespace
+{
+    constexpr float  Compression  = 10.0f;  // log compression of power, log(1 + C * power)
+    constexpr float  MinFlux      = 1e-3f;  // onset strength floor, keeps noise from triggering onsets in near silence
+    constexpr double RefractoryMs = 100.0;  // minimum time between onsets
+    constexpr size_t StatsMs      = 1000;   // averaging time of the onset statistics
+    constexpr size_t TempoMs      = 8000;   // averaging time of the tempo autocorrelation
+    constexpr double PriorBPM     = 120.0;  // tempo the lag weights are centered on
+    constexpr double TempoGain    = 0.05;   // fraction of the tempo estimate applied per hop
+    constexpr double PhaseGain    = 0.2;    // fraction of the phase error of an onset corrected
+}  // namespace
+
+void DSP::BeatTracker::Configure(const BeatOptions& opts, size_t bins)
+{
+    options    = opts;
+
+    minLag     = std::max<size_t>(1, (size_t) std::floor(60.0 * options.hopRate / options.maxBPM));
+    maxLag     = std::max(minLag, (size_t) std::ceil(60.0 * options.hopRate / options.minBPM));
+    refractory = (size_t) std::ceil(RefractoryMs * 0.001 * options.hopRate);
+
+    last.assign(bins, 0.0f);
+    history.assign(2 * (maxLag + 1), 0.0f);
+    acf.assign(maxLag - minLag + 1, 0.0f);
+    prior.resize(acf.size());
+
+    for (size_t lag = minLag; lag <= maxLag; lag++)
+    {
+        const double octaves = std::log2(60.0 * options.hopRate / lag / PriorBPM);
+        prior[lag - minLag]  = (float) std::exp(-0.5 * octaves * octaves);
+    }
+
+    kStats     = EnvelopeCoefficient(options.hopRate, StatsMs);
+    kACF       = EnvelopeCoefficient(options.hopRate, TempoMs);
+
+    pos        = 0;
+    sinceOnset = refractory;
+    primed     = false;
+    mean       = 0.0f;
+    dev        = 0.0f;
+    flux       = 0.0f;
+    strength   = 0.0f;
+    period     = std::clamp(60.0 * options.hopRate / PriorBPM, (double) minLag, (double) maxLag);
+    phase      = 0.0;
+}
+
+void DSP::BeatTracker::Continue(const BeatTracker& previous)
+{
+    if (!options.hopRate or !previous.options.hopRate)
+    {
+        return;
+    }
+
+    // the period is carried over in time rather than in hops, as the hop rate may have changed
+    period = std::clamp(previous.period / previous.options.hopRate * options.hopRate, (double) minLag, (double) maxLag);
+    phase  = previous.phase;
+
+    if (last.size() == previous.last.size())
+    {
+        std::copy(previous.last.begin(), previous.last.end(), last.begin());
+
+        mean   = previous.mean;
+        dev    = previous.dev;
+        primed = previous.primed;
+    }
+}
+
+bool DSP::BeatTracker::Update(const float* power)
+{
+    const size_t bins = last.size();
+
+    // half-wave rectified spectral flux, only rising energy counts towards onsets
+    float sum = 0.0f;
+
+    for (size_t i = 0; i < bins; i++)
+    {
+        const float x = std::log1p(Compression * power[i]);
+
+        sum += std::max(x - last[i], 0.0f);
+        last[i] = x;
+    }
+
+    flux = sum / (float) std::max<size_t>(bins, 1);
+
+    if (!primed)
+    {
+        // the first hop has nothing to compare against, all of its energy would count as rising
+        primed = true;
+        flux   = 0.0f;
+
+        phase += 1.0 / period;
+        phase -= std::floor(phase);
+        sinceOnset++;
+
+        return false;
+    }
+
+    // onset detection against the statistics of previous hops
+    const float threshold = mean + (float) options.threshold * dev;
+    const bool  onset     = (flux > threshold and flux > MinFlux and sinceOnset >= refractory);
+
+    mean                  = flux + kStats * (mean - flux);
+    dev                   = std::fabs(flux - mean) + kStats * (dev - std::fabs(flux - mean));
+
+    // autocorrelation of the onset strength above its mean, history is written twice so that
+    // h[-lag] is the value lag hops ago without wrapping
+    const size_t size    = maxLag + 1;
+    const float  novelty = std::max(flux - mean, 0.0f);
+
+    history[pos]         = novelty;
+    history[pos + size]  = novelty;
+
+    const float* h       = history.data() + pos + size;
+
+    for (size_t j = 0; j < acf.size(); j++)
+    {
+        acf[j] = novelty * h[-(ptrdiff_t) (minLag + j)] + kACF * acf[j];
+    }
+
+    pos = (pos + 1) % size;
+
+    // tempo from the strongest weighted lag, refined with a parabola through its neighbours
+    size_t best      = 0;
+    float  bestScore = 0.0f;
+
+    for (size_t j = 0; j < acf.size(); j++)
+    {
+        const float score = acf[j] * prior[j];
+
+        if (score > bestScore)
+        {
+            best      = j;
+            bestScore = score;
+        }
+    }
+
+    if (bestScore > 0.0f)
+    {
+        double lag = (double) (minLag + best);
+
+        if (best > 0 and best + 1 < acf.size())
+        {
+            const double a = acf[best - 1];
+            const double b = acf[best];
+            const double c = acf[best + 1];
+            const double d = a - 2.0 * b + c;
+
+            if (d < 0.0)
+            {
+                lag += 0.5 * (a - c) / d;
+            }
+        }
+
+        period += TempoGain * (lag - period);
+    }
+
+    // advance the beat oscillator, and pull it towards the beat on onsets
+    phase += 1.0 / period;
+    phase -= std::floor(phase);
+
+    if (!onset)
+    {
+        sinceOnset++;
+        return false;
+    }
+
+    const double error = (phase < 0.5) ? phase : phase - 1.0;
+
+    phase -= PhaseGain * error;
+    phase -= std::floor(phase);
+
+    strength   = std::clamp(1.0f - threshold / flux, 0.0f, 1.0f);
+    sinceOnset = 0;
+
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace DSP
+{
+    //! Beat tracker options
+    struct BeatOptions
+    {
+        double hopRate{};       //!< Rate of Update() calls in Hz, i.e. the FFT hop rate
+        double minBPM{60.0};    //!< Slowest tempo considered
+        double maxBPM{180.0};   //!< Fastest tempo considered
+        double threshold{2.0};  //!< Onset threshold, in mean deviations above the mean onset strength
+    };
+
+    /*! Incremental onset detection and tempo/beat phase tracking, updated once per FFT hop.
+
+        Onset strength is the half-wave rectified spectral flux of log-compressed power. An onset is detected
+        when it rises above an adaptive threshold, the running mean plus a multiple of the running mean
+        deviation, at least 100ms after the previous onset.
+
+        Tempo is the strongest lag of an exponentially weighted autocorrelation of the onset strength over the
+        last few seconds, weighted towards 120 BPM to avoid octave errors. The autocorrelation is updated with
+        one multiply-add per candidate lag per hop instead of being recomputed. Beat phase is an oscillator
+        running at the estimated tempo that is pulled towards detected onsets.
+    */
+    class BeatTracker
+    {
+    public:
+        /*! Resets the tracker
+            \param[in]  opts    Tracker options
+            \param[in]  bins    Number of power bins passed to Update()
+        */
+        void   Configure(const BeatOptions& opts, size_t bins);
+
+        /*! Carries the tempo and beat phase of a previous tracker over
+            With the same number of bins, the previous spectrum and onset statistics are carried over as well.
+            Otherwise the first Update() only primes the spectrum, as flux against a cleared one would read as an onset.
+            Does not allocate, so it can be called on the processing thread.
+            \param[in]  previous    Tracker being replaced
+        */
+        void   Continue(const BeatTracker& previous);
+
+        /*! Processes the power spectrum of one hop
+            \param[in]  power   Unsmoothed power of every bin, summed over channels
+            \return true if an onset was detected
+        */
+        bool   Update(const float* power);
+
+        //! Onset strength of the last hop
+        float  Flux() const { return flux; }
+
+        //! Strength of the last onset, 0.0 at the threshold to 1.0
+        float  Strength() const { return strength; }
+
+        //! Estimated tempo in BPM
+        double Tempo() const { return 60.0 * options.hopRate / period; }
+
+        //! Beat phase, 0.0 on the beat rising to 1.0 just before the next one
+        double Phase() const { return phase; }
+
+    private:
+        BeatOptions        options;
+        std::vector<float> last;     //!< Log-compressed power of the previous hop
+        std::vector<float> history;  //!< Onset strength of the last maxLag + 1 hops, stored twice so lags never wrap
+        std::vector<float> acf;      //!< Autocorrelation of the onset strength for every lag from minLag to maxLag
+        std::vector<float> prior;    //!< Tempo weight of every lag
+        size_t             pos{};    //!< Next write position in history
+        size_t             minLag{};
+        size_t             maxLag{};
+        size_t             refractory{};  //!< Minimum number of hops between onsets
+        size_t             sinceOnset{};  //!< Hops since the last onset
+        bool               primed{};      //!< Whether last holds the spectrum of a previous hop
+        float              kStats{};      //!< Onset statistics filter constant
+        float              kACF{};        //!< Autocorrelation filter constant
+        float              mean{};        //!< Running mean of the onset strength
+        float              dev{};         //!< Running mean deviation of the onset strength
+        float              flux{};
+        float              strength{};
+        double             period{1.0};  //!< Beat period in hops
+        double             phase{};
+    };
+}  // namespace DSP
@@ -0,0 +1,469 @@
+#include <array>
+#include <cmath>
+#include <complex>
+#include <random>
+#include <vector>
+
+#include "constantq.h"
+#include "dsp.h"
+#include "spectrum.h"
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+    constexpr float Rate = 48000.0f;
+
+    struct BandSetup
+    {
+        size_t             fftSize;
+        size_t             nBands;
+        float              df;
+        float              bandScalar;
+        std::vector<float> bandFreq;
+        std::vector<float> fftOut[2];
+        std::vector<float> bandOut[2];
+
+        BandSetup(size_t fft, size_t bands) :
+            fftSize{fft},
+            nBands{bands},
+            df{Rate / fft},
+            bandScalar{2.0f / Rate},
+            bandFreq(bands)
+        {
+            // Same band layout as pulse_viz with the default 20 Hz - 20 kHz range
+            const double step = (std::log(20000.0 / 20.0) / bands) / std::log(2.0);
+            bandFreq[0]       = (float) (20.0 * std::pow(2.0, step / 2.0));
+
+            for (size_t i = 1; i < bands; i++)
+            {
+                bandFreq[i] = (float) (bandFreq[i - 1] * std::pow(2.0, step));
+            }
+
+            std::mt19937                          rng{42};
+            std::uniform_real_distribution<float> dist{0.0f, 1.0f};
+
+            for (auto c = 0; c < 2; c++)
+            {
+                fftOut[c].resize(fft);
+                bandOut[c].resize(bands);
+
+                for (auto&& x : fftOut[c])
+                {
+                    x = dist(rng);
+                }
+            }
+        }
+    };
+
+    // The band integration loop pulse_viz used before the precomputed matrix
+    void integrateBands(const BandSetup& s, const std::vector<float>& in, std::vector<float>& out)
+    {
+        std::fill(out.begin(), out.end(), 0.0f);
+        size_t iBin  = 0;
+        size_t iBand = 0;
+        float  f0    = 0.0f;
+
+        while (iBin <= (s.fftSize / 2) and iBand < s.nBands)
+        {
+            float  fLin1 = ((float) iBin + 0.5f) * s.df;
+            float  fLog1 = s.bandFreq[iBand];
+            float  x     = in[iBin];
+            float& y     = out[iBand];
+
+            if (fLin1 <= fLog1)
+            {
+                y += (fLin1 - f0) * x * s.bandScalar;
+                f0 = fLin1;
+                iBin += 1;
+            }
+            else
+            {
+                y += (fLog1 - f0) * x * s.bandScalar;
+                f0 = fLog1;
+                iBand += 1;
+            }
+        }
+    }
+}  // namespace
+
+static void BM_BandIntegrateLoop(benchmark::State& state)
+{
+    BandSetup s(state.range(0), state.range(1));
+
+    for (auto _ : state)
+    {
+        for (auto c = 0; c < 2; c++)
+        {
+            integrateBands(s, s.fftOut[c], s.bandOut[c]);
+        }
+
+        benchmark::DoNotOptimize(s.bandOut[0].data());
+        benchmark::DoNotOptimize(s.bandOut[1].data());
+    }
+}
+BENCHMARK(BM_BandIntegrateLoop)->ArgsProduct({{1024, 2048, 4096, 8192}, {16, 64, 256}});
+
+static void BM_BandIntegrateMatrix(benchmark::State& state)
+{
+    BandSetup       s(state.range(0), state.range(1));
+    DSP::BandMatrix matrix;
+
+    matrix.Build(s.bandFreq, s.df, s.bandScalar, (s.fftSize / 2) + 1);
+
+    // Results must match the reference loop before the timing means anything
+    std::vector<float> expected(s.nBands);
+    integrateBands(s, s.fftOut[0], expected);
+    matrix.Apply(s.fftOut[0].data(), s.bandOut[0].data());
+
+    for (size_t i = 0; i < s.nBands; i++)
+    {
+        if (std::fabs(expected[i] - s.bandOut[0][i]) > 1e-4f * std::fabs(expected[i]) + 1e-9f)
+        {
+            state.SkipWithError("BandMatrix output does not match the reference loop");
+            return;
+        }
+    }
+
+    const float* ins[2]  = {s.fftOut[0].data(), s.fftOut[1].data()};
+    float*       outs[2] = {s.bandOut[0].data(), s.bandOut[1].data()};
+
+    for (auto _ : state)
+    {
+        matrix.Apply(ins, outs, 2);
+
+        benchmark::DoNotOptimize(s.bandOut[0].data());
+        benchmark::DoNotOptimize(s.bandOut[1].data());
+    }
+
+    state.counters["nnz"] = (double) matrix.NonZeros();
+}
+BENCHMARK(BM_BandIntegrateMatrix)->ArgsProduct({{1024, 2048, 4096, 8192}, {16, 64, 256}});
+
+namespace
+{
+    struct SmoothSetup
+    {
+        size_t                           nBins;
+        std::vector<std::complex<float>> spectrum;
+        std::vector<float>               scaled;
+        std::vector<float>               state;
+        float                            scale;
+        float                            k[2]{0.8f, 0.95f};
+
+        explicit SmoothSetup(size_t fft) :
+            nBins{(fft / 2) + 1},
+            spectrum(nBins),
+            scaled(nBins),
+            state(nBins),
+            scale{1.0f / std::sqrt((float) fft)}
+        {
+            std::mt19937                          rng{42};
+            std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+            for (auto&& c : spectrum)
+            {
+                c = {dist(rng), dist(rng)};
+            }
+
+            for (auto&& x : state)
+            {
+                x = std::fabs(dist(rng));
+            }
+        }
+    };
+}  // namespace
+
+// The power and smoothing pass pulse_viz used before the fused kernel
+static void BM_SmoothLoop(benchmark::State& state)
+{
+    SmoothSetup s(state.range(0));
+
+    for (auto _ : state)
+    {
+        for (size_t bin = 0; bin < s.nBins; bin++)
+        {
+            s.scaled[bin] = std::norm(s.spectrum[bin]) * s.scale;
+        }
+
+        for (size_t bin = 0; bin < s.nBins; bin++)
+        {
+            float x0     = s.state[bin];
+            float x1     = s.scaled[bin];
+            x0           = x1 + s.k[(x1 < x0)] * (x0 - x1);
+            s.state[bin] = x0;
+        }
+
+        benchmark::DoNotOptimize(s.state.data());
+    }
+}
+BENCHMARK(BM_SmoothLoop)->Arg(1024)->Arg(2048)->Arg(4096)->Arg(8192);
+
+static void BM_SmoothPower(benchmark::State& state)
+{
+    SmoothSetup s(state.range(0));
+
+    for (auto _ : state)
+    {
+        DSP::SmoothPower(s.spectrum.data(), s.state.data(), s.nBins, s.scale, s.k[0], s.k[1]);
+
+        benchmark::DoNotOptimize(s.state.data());
+    }
+}
+BENCHMARK(BM_SmoothPower)->Arg(1024)->Arg(2048)->Arg(4096)->Arg(8192);
+
+namespace
+{
+    struct LevelSetup
+    {
+        size_t             nFrames;
+        std::vector<float> samples;     // interleaved stereo
+        std::vector<float> channel[2];  // same samples, one buffer per channel
+        float              kRMS[2]{0.99931f, 0.99931f};
+        float              kPeak[2]{0.99808f, 0.99996f};
+
+        explicit LevelSetup(size_t frames) : nFrames{frames}, samples(frames * 2)
+        {
+            std::mt19937                          rng{42};
+            std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+            channel[0].resize(frames);
+            channel[1].resize(frames);
+
+            for (size_t i = 0; i < frames; i++)
+            {
+                channel[0][i]      = dist(rng);
+                channel[1][i]      = dist(rng);
+                samples[2 * i]     = channel[0][i];
+                samples[2 * i + 1] = channel[1][i];
+            }
+        }
+    };
+}  // namespace
+
+// The per sample RMS and peak loop of win_audio_viz
+static void BM_LevelsLoop(benchmark::State& state)
+{
+    LevelSetup s(state.range(0));
+    float      rms[2]{};
+    float      peak[2]{};
+
+    for (auto _ : state)
+    {
+        const float* x = s.samples.data();
+
+        for (size_t i = 0; i < s.nFrames; i++)
+        {
+            for (size_t c = 0; c < 2; c++)
+            {
+                float v    = *x++;
+                float sqrX = v * v;
+                float absX = std::fabs(v);
+                rms[c]     = sqrX + s.kRMS[(sqrX < rms[c])] * (rms[c] - sqrX);
+                peak[c]    = absX + s.kPeak[(absX < peak[c])] * (peak[c] - absX);
+            }
+        }
+
+        benchmark::DoNotOptimize(rms);
+        benchmark::DoNotOptimize(peak);
+    }
+
+    state.SetItemsProcessed(state.iterations() * s.nFrames);
+}
+BENCHMARK(BM_LevelsLoop)->Arg(480)->Arg(4800);
+
+static void BM_TrackLevels(benchmark::State& state)
+{
+    LevelSetup           s(state.range(0));
+    std::array<float, 2> kRMS{s.kRMS[0], s.kRMS[1]};
+    std::array<float, 2> kPeak{s.kPeak[0], s.kPeak[1]};
+    const float*         ins[2] = {s.channel[0].data(), s.channel[1].data()};
+    float                rms[2]{};
+    float                peak[2]{};
+
+    for (auto _ : state)
+    {
+        DSP::TrackLevels(ins, s.nFrames, rms, peak, 2, kRMS, kPeak);
+
+        benchmark::DoNotOptimize(rms);
+        benchmark::DoNotOptimize(peak);
+    }
+
+    state.SetItemsProcessed(state.iterations() * s.nFrames);
+}
+BENCHMARK(BM_TrackLevels)->Arg(480)->Arg(4800);
+
+namespace
+{
+    struct DemuxSetup
+    {
+        static constexpr size_t FFTSize = 2048;
+
+        size_t                  channels;
+        size_t                  nFrames;
+        std::vector<int16_t>    block;  // interleaved S16LE
+        std::vector<float>      ring[8];
+        std::vector<float>      demux[8];
+
+        DemuxSetup(size_t chans, size_t frames) : channels{chans}, nFrames{frames}, block(chans * frames)
+        {
+            std::mt19937                       rng{42};
+            std::uniform_int_distribution<int> dist{-32768, 32767};
+
+            for (auto&& x : block)
+            {
+                x = (int16_t) dist(rng);
+            }
+
+            for (size_t c = 0; c < chans; c++)
+            {
+                ring[c].resize(FFTSize);
+                demux[c].resize(frames);
+            }
+        }
+    };
+}  // namespace
+
+// The per sample conversion and modulo indexed ring buffers pulse_viz used before the deinterleave stage
+static void BM_DemuxLoop(benchmark::State& state)
+{
+    DemuxSetup s(state.range(0), state.range(1));
+    size_t     w = 0;
+
+    for (auto _ : state)
+    {
+        const int16_t* x = s.block.data();
+
+        for (size_t i = 0; i < s.nFrames; i++)
+        {
+            for (size_t c = 0; c < s.channels; c++)
+            {
+                s.ring[c][w] = *x++ * (1.0f / 32767);
+            }
+
+            w = (w + 1) % DemuxSetup::FFTSize;
+        }
+
+        benchmark::DoNotOptimize(s.ring[0].data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * s.nFrames * s.channels);
+}
+BENCHMARK(BM_DemuxLoop)->ArgsProduct({{2, 6, 8}, {480}});
+
+static void BM_DemuxRing(benchmark::State& state)
+{
+    DemuxSetup                     s(state.range(0), state.range(1));
+    std::array<DSP::RingBuffer, 8> rings;
+    float*                         outs[8];
+
+    for (size_t c = 0; c < s.channels; c++)
+    {
+        rings[c].Resize(DemuxSetup::FFTSize);
+        outs[c] = s.demux[c].data();
+    }
+
+    for (auto _ : state)
+    {
+        DSP::Deinterleave(s.block.data(), s.nFrames, s.channels, outs);
+
+        for (size_t c = 0; c < s.channels; c++)
+        {
+            rings[c].Write(outs[c], s.nFrames);
+        }
+
+        benchmark::DoNotOptimize(outs[0]);
+    }
+
+    state.SetItemsProcessed(state.iterations() * s.nFrames * s.channels);
+}
+BENCHMARK(BM_DemuxRing)->ArgsProduct({{2, 6, 8}, {480}});
+
+// The whole analyzer pipeline over 10ms stereo blocks, including the FFT and band integration of every completed hop
+static void BM_SpectrumAnalyzer(benchmark::State& state)
+{
+    DemuxSetup            s(2, 480);
+    DSP::SpectrumAnalyzer analyzer;
+    const size_t          fftSize = state.range(0);
+    float*                outs[2] = {s.demux[0].data(), s.demux[1].data()};
+    const float*          ins[2]  = {outs[0], outs[1]};
+
+    analyzer.Configure({.sampleRate = Rate, .fftSize = fftSize, .fftOverlap = fftSize / 2, .nBands = (size_t) state.range(1)});
+
+    DSP::Deinterleave(s.block.data(), s.nFrames, s.channels, outs);
+
+    for (auto _ : state)
+    {
+        analyzer.Process(ins, s.nFrames, [&] { analyzer.IntegrateBands(); });
+
+        benchmark::DoNotOptimize(analyzer.Band(0));
+    }
+
+    state.SetItemsProcessed(state.iterations() * s.nFrames * s.channels);
+}
+BENCHMARK(BM_SpectrumAnalyzer)->ArgsProduct({{1024, 2048, 4096}, {16, 64}});
+
+// Band output of the whole analyzer at a fixed 512 sample hop, from integrated FFT bins or from the constant-Q transform.
+// A small FFT with constant-Q bands resolves the bass better than FFT bands at 8192
+static void BM_SpectrumAnalyzerBands(benchmark::State& state)
+{
+    DemuxSetup            s(2, 480);
+    DSP::SpectrumAnalyzer analyzer;
+    const size_t          fftSize = state.range(0);
+    float*                outs[2] = {s.demux[0].data(), s.demux[1].data()};
+    const float*          ins[2]  = {outs[0], outs[1]};
+
+    analyzer.Configure({.sampleRate = Rate,
+        .fftSize                    = fftSize,
+        .fftOverlap                 = fftSize - 512,
+        .nBands                     = (size_t) state.range(1),
+        .constantQ                  = state.range(2) != 0});
+
+    DSP::Deinterleave(s.block.data(), s.nFrames, s.channels, outs);
+
+    for (auto _ : state)
+    {
+        analyzer.Process(ins, s.nFrames, [&] { analyzer.IntegrateBands(); });
+
+        benchmark::DoNotOptimize(analyzer.Band(0));
+    }
+
+    state.SetItemsProcessed(state.iterations() * s.nFrames * s.channels);
+}
+BENCHMARK(BM_SpectrumAnalyzerBands)->ArgsProduct({{1024, 8192}, {16, 64, 256}, {0, 1}});
+
+// The constant-Q transform alone, decimating 512 stereo samples and analyzing every band once
+static void BM_ConstantQ(benchmark::State& state)
+{
+    DemuxSetup         s(2, 512);
+    DSP::ConstantQ     cq;
+    std::vector<float> centers(state.range(0));
+    float*             outs[2] = {s.demux[0].data(), s.demux[1].data()};
+
+    // Same band layout as pulse_viz with the default 20 Hz - 20 kHz range
+    const double step = std::log2(20000.0 / 20.0) / centers.size();
+
+    for (size_t b = 0; b < centers.size(); b++)
+    {
+        centers[b] = (float) (20.0 * std::pow(2.0, step * b));
+    }
+
+    cq.Configure(Rate, 2, centers, 1.0 / (std::pow(2.0, step) - 1.0), s.nFrames);
+
+    DSP::Deinterleave(s.block.data(), s.nFrames, s.channels, outs);
+
+    for (auto _ : state)
+    {
+        for (size_t c = 0; c < 2; c++)
+        {
+            cq.Write(c, outs[c], s.nFrames);
+            benchmark::DoNotOptimize(cq.Analyze(c));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * s.nFrames * s.channels);
+    state.counters["octaves"] = (double) cq.Octaves();
+    state.counters["fft"]     = (double) cq.FFTSize();
+    state.counters["nnz"]     = (double) cq.NonZeros();
+}
+BENCHMARK(BM_ConstantQ)->Arg(16)->Arg(64)->Arg(256);
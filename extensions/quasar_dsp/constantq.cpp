@@ -0,0 +1,299 @@
+#include "constantq.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <numbers>
+
+#include <kfr/base.hpp>
+#include <kfr/dft.hpp>
+
+namespace
+{
+    constexpr size_t Taps      = 63;     // halfband decimator length, 4k + 3 so that its outermost taps are nonzero
+    constexpr size_t Delay     = Taps / 2;
+    constexpr double Passband  = 0.4;    // highest band edge analyzed in an octave relative to its sample rate, below the decimator transition band
+    constexpr double Threshold = 0.01;   // kernel spectrum bins below this fraction of the peak are dropped
+    constexpr size_t MinFFT    = 16;
+}  // namespace
+
+struct DSP::ConstantQ::Transform
+{
+    kfr::dft_plan_real<float>           dft;
+    kfr::univector<float>               in;    //!< FFT input
+    kfr::univector<std::complex<float>> out;   //!< FFT output
+    kfr::univector<kfr::u8>             temp;  //!< FFT scratch space
+
+    explicit Transform(size_t size) : dft(size), in(size, 0.0f), out(size, {0.0f, 0.0f}), temp(dft.temp_size) {}
+};
+
+DSP::ConstantQ::ConstantQ() = default;
+
+DSP::ConstantQ::~ConstantQ() = default;
+
+void DSP::ConstantQ::Configure(double sampleRate, size_t chans, std::span<const float> centers, double q, size_t block)
+{
+    constexpr double pi = std::numbers::pi;
+
+    channels            = std::clamp<size_t>(chans, 1, MaxChannels);
+    maxBlock            = std::max<size_t>(block, 1);
+
+    // windowed sinc halfband lowpass, every other tap but the center one is zero
+    taps.resize((Delay + 1) / 2);
+
+    float sum = 0.0f;
+
+    for (size_t k = 0; k < taps.size(); k++)
+    {
+        const double d      = (double) (2 * k + 1);
+        const double n      = (double) Delay - d;
+        const double window = 0.42 - 0.5 * std::cos(2.0 * pi * n / (Taps - 1)) + 0.08 * std::cos(4.0 * pi * n / (Taps - 1));
+
+        taps[k]             = (float) (std::sin(pi * d / 2.0) / (pi * d) * window);
+        sum += 2.0f * taps[k];
+    }
+
+    // normalize to unity gain at DC, with 0.5 for the center tap
+    for (auto& t : taps)
+    {
+        t *= 0.5f / sum;
+    }
+
+    // pick the octave and kernel length of every band
+    const size_t        nBands = centers.size();
+    std::vector<size_t> lengths(nBands, 0);
+
+    octave.assign(nBands, 0);
+    octaves = 1;
+
+    size_t longest = 1;
+
+    for (size_t b = 0; b < nBands; b++)
+    {
+        const double f = centers[b];
+
+        if (!(f > 0.0 and f < 0.5 * sampleRate))
+        {
+            continue;
+        }
+
+        const double edge = f * (1.0 + 0.5 / q);
+        const int    o    = std::clamp((int) std::floor(std::log2(Passband * sampleRate / edge)), 0, (int) MaxOctaves - 1);
+
+        octave[b]         = (uint8_t) o;
+        lengths[b]        = (size_t) std::max(4.0, std::ceil(q * std::ldexp(sampleRate, -o) / f));
+        octaves           = std::max(octaves, (size_t) o + 1);
+        longest           = std::max(longest, lengths[b]);
+    }
+
+    fftSize   = std::max(MinFFT, std::bit_ceil(longest));
+    transform = std::make_unique<Transform>(fftSize);
+
+    // transform the kernels, each aligned to the end of the FFT frame so that it covers the most recent samples
+    const size_t                     nBins = (fftSize / 2) + 1;
+    std::vector<std::complex<float>> spectrum(nBins);
+    std::vector<double>              window;
+
+    rowStart.assign(nBands + 1, 0);
+    firstBin.assign(nBands, 0);
+    weights.clear();
+
+    for (size_t b = 0; b < nBands; b++)
+    {
+        rowStart[b] = (uint32_t) weights.size();
+
+        if (!lengths[b])
+        {
+            continue;
+        }
+
+        const size_t length = lengths[b];
+        const size_t offset = fftSize - length;
+        const double w0     = 2.0 * pi * centers[b] / std::ldexp(sampleRate, -octave[b]);
+
+        double       norm   = 0.0;
+
+        window.resize(length);
+
+        for (size_t n = 0; n < length; n++)
+        {
+            const double s = std::sin(pi * (n + 0.5) / length);
+
+            window[n]      = s * s;
+            norm += window[n];
+        }
+
+        // the window's spectrum decays quickly outside its main lobe, 4 * N / length bins wide, so only a few times
+        // that around the center bin are worth transforming
+        const double center = w0 * fftSize / (2.0 * pi);
+        const double span   = 8.0 * fftSize / length + 2.0;
+        const size_t lo     = (size_t) std::clamp(std::floor(center - span), 0.0, (double) (nBins - 1));
+        const size_t hi     = (size_t) std::clamp(std::ceil(center + span), 0.0, (double) (nBins - 1)) + 1;
+
+        float        peak   = 0.0f;
+
+        for (size_t j = lo; j < hi; j++)
+        {
+            // sum of the modulated window over the basis function of bin j, with the phase advanced by rotation
+            const double         dphi = w0 - 2.0 * pi * (double) j / fftSize;
+            const auto           step = std::polar(1.0, dphi);
+            auto                 rot  = std::polar(1.0, -2.0 * pi * (double) ((j * offset) % fftSize) / fftSize);
+            std::complex<double> acc{};
+
+            for (size_t n = 0; n < length; n++)
+            {
+                acc += window[n] * rot;
+                rot *= step;
+            }
+
+            // conjugated and scaled by 1 / N, so that a dot product with the FFT of the input is the correlation
+            spectrum[j] = std::conj(std::complex<float>(acc / (norm * (double) fftSize)));
+            peak        = std::max(peak, std::abs(spectrum[j]));
+        }
+
+        size_t first = lo;
+        size_t last  = hi;
+
+        while (first < last and std::abs(spectrum[first]) < Threshold * peak)
+        {
+            first++;
+        }
+
+        while (last > first and std::abs(spectrum[last - 1]) < Threshold * peak)
+        {
+            last--;
+        }
+
+        firstBin[b] = (uint32_t) first;
+        weights.insert(weights.end(), spectrum.begin() + first, spectrum.begin() + last);
+    }
+
+    rowStart[nBands] = (uint32_t) weights.size();
+    response.assign(nBands, {0.0f, 0.0f});
+
+    work.assign(Taps - 1 + maxBlock, 0.0f);
+    phase.assign((work.size() / 2) + 1, 0.0f);
+    scratch.assign((maxBlock / 2) + 1, 0.0f);
+
+    for (size_t c = 0; c < MaxChannels; c++)
+    {
+        const bool used = (c < channels);
+
+        for (size_t o = 0; o < MaxOctaves; o++)
+        {
+            rings[c][o].Resize((used and o < octaves) ? fftSize : 0);
+            decimators[c][o].tail.assign((used and o > 0 and o < octaves) ? Taps - 1 : 0, 0.0f);
+            decimators[c][o].odd = false;
+        }
+    }
+}
+
+size_t DSP::ConstantQ::decimate(Decimator& d, const float* x, size_t n, float* out)
+{
+    std::copy(d.tail.begin(), d.tail.end(), work.begin());
+    std::copy(x, x + n, work.begin() + (Taps - 1));
+
+    // outputs are taken at every other input sample from start. All nonzero taps but the center one fall on
+    // samples of the same parity as start, so those are gathered into a contiguous phase first, which turns the
+    // filter into dense dot products over the outputs that vectorize
+    const size_t start = d.odd ? 1 : 0;
+    const size_t count = (n > start) ? (n - start + 1) / 2 : 0;
+    const size_t half  = taps.size() - 1;
+
+    for (size_t j = 0; j < count + Delay; j++)
+    {
+        phase[j] = work[start + 2 * j];
+    }
+
+    for (size_t m = 0; m < count; m++)
+    {
+        out[m] = 0.5f * work[start + 2 * m + Delay];
+    }
+
+    for (size_t k = 0; k < taps.size(); k++)
+    {
+        const float  t  = taps[k];
+        const float* lo = phase.data() + (half - k);
+        const float* hi = phase.data() + (half + 1 + k);
+
+        for (size_t m = 0; m < count; m++)
+        {
+            out[m] += t * (lo[m] + hi[m]);
+        }
+    }
+
+    d.odd = ((start + n) % 2) == 1;
+    std::copy(work.begin() + n, work.begin() + n + (Taps - 1), d.tail.begin());
+
+    return count;
+}
+
+void DSP::ConstantQ::Write(size_t channel, const float* x, size_t n)
+{
+    auto& ring = rings[channel];
+
+    while (n)
+    {
+        const size_t block = std::min(n, maxBlock);
+        const float* in    = x;
+        size_t       count = block;
+
+        for (size_t o = 0; o < octaves and count; o++)
+        {
+            if (o)
+            {
+                count = decimate(decimators[channel][o], in, count, scratch.data());
+                in    = scratch.data();
+            }
+
+            const size_t keep = std::min(count, fftSize);
+            ring[o].Write(in + (count - keep), keep);
+        }
+
+        x += block;
+        n -= block;
+    }
+}
+
+const std::complex<float>* DSP::ConstantQ::Analyze(size_t channel)
+{
+    auto&        t       = *transform;
+    const size_t nBands  = Bands();
+    size_t       current = MaxOctaves;
+
+    for (size_t b = 0; b < nBands; b++)
+    {
+        const size_t nz = rowStart[b + 1] - rowStart[b];
+
+        if (!nz)
+        {
+            response[b] = {0.0f, 0.0f};
+            continue;
+        }
+
+        // bands are ascending, so every octave is transformed once
+        if (octave[b] != current)
+        {
+            current = octave[b];
+
+            rings[channel][current].Read(t.in.data(), fftSize);
+            t.dft.execute(t.out, t.in, t.temp);
+        }
+
+        const std::complex<float>* x  = t.out.data() + firstBin[b];
+        const std::complex<float>* w  = weights.data() + rowStart[b];
+
+        float                      re = 0.0f;
+        float                      im = 0.0f;
+
+        for (size_t k = 0; k < nz; k++)
+        {
+            re += x[k].real() * w[k].real() - x[k].imag() * w[k].imag();
+            im += x[k].real() * w[k].imag() + x[k].imag() * w[k].real();
+        }
+
+        response[b] = {re, im};
+    }
+
+    return response.data();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "dsp.h"
+
+namespace DSP
+{
+    /*! Multi-resolution constant-Q band analyzer.
+
+        Every band has its own Hann windowed complex kernel, Q cycles of its center frequency long. Kernels are
+        transformed once when configured and kept as sparse rows of the few FFT bins around their center, so a
+        band costs a short complex dot product with the FFT of the input instead of a direct correlation.
+
+        To keep the FFT small, the input is run through a cascade of halfband decimators, halving the sample
+        rate once per octave. Each band is analyzed in the lowest octave whose passband still holds it, where
+        its kernel is at most about 5 * Q samples long, so every octave shares one small FFT size and the
+        low bands get the resolution of a kernel seconds long at the cost of a few small FFTs per hop.
+
+        The analyzer is not thread safe, callers serialize access.
+    */
+    class ConstantQ
+    {
+    public:
+        static constexpr size_t MaxChannels = 8;
+        static constexpr size_t MaxOctaves  = 12;
+
+        ConstantQ();
+        ~ConstantQ();
+
+        ConstantQ(const ConstantQ&)             = delete;
+        ConstantQ& operator= (const ConstantQ&) = delete;
+
+        /*! Builds the kernels and decimators and clears all input
+            \param[in]  sampleRate  Input sample rate in Hz
+            \param[in]  channels    Number of channels, at most MaxChannels
+            \param[in]  centers     Center frequency of every band in Hz, ascending
+            \param[in]  q           Quality factor, i.e. center frequency / bandwidth
+            \param[in]  maxBlock    Block size Write() is optimized for, larger blocks are split
+        */
+        void                       Configure(double sampleRate, size_t channels, std::span<const float> centers, double q, size_t maxBlock);
+
+        /*! Appends samples of a channel, decimating them into every octave
+            \param[in]  channel Channel index
+            \param[in]  x       Samples
+            \param[in]  n       Number of samples
+        */
+        void                       Write(size_t channel, const float* x, size_t n);
+
+        /*! Computes the complex response of every band of a channel to its most recent samples
+            For a sine at the center frequency of a band, the magnitude of that band is half its amplitude.
+            \param[in]  channel Channel index
+            \return Response of every band, Bands() long, valid until the next call
+        */
+        const std::complex<float>* Analyze(size_t channel);
+
+        //! Number of bands
+        size_t                     Bands() const { return octave.size(); }
+
+        //! Number of octaves, i.e. decimation stages + 1
+        size_t                     Octaves() const { return octaves; }
+
+        //! FFT size of every octave
+        size_t                     FFTSize() const { return fftSize; }
+
+        //! Number of stored kernel weights
+        size_t                     NonZeros() const { return weights.size(); }
+
+    private:
+        struct Transform;  // FFT plan and scratch buffers, keeps KFR out of this header
+
+        //! Halfband decimator state of one channel and octave
+        struct Decimator
+        {
+            std::vector<float> tail;   //!< Last input samples, filter length - 1 long
+            bool               odd{};  //!< Whether the next input sample is dropped
+        };
+
+        size_t                                                      decimate(Decimator& d, const float* x, size_t n, float* out);
+
+        std::unique_ptr<Transform>                                  transform;
+        std::array<std::array<RingBuffer, MaxOctaves>, MaxChannels> rings;       //!< Input of every channel at the rate of every octave
+        std::array<std::array<Decimator, MaxOctaves>, MaxChannels>  decimators;  //!< Decimator into every octave but the first
+        std::vector<float>                                          taps;        //!< Nonzero taps on one side of the halfband filter
+        std::vector<float>                                          work;        //!< Decimator input with its history prepended
+        std::vector<float>                                          phase;       //!< Samples of work the outer taps of the decimator fall on
+        std::vector<float>                                          scratch;     //!< Decimator output
+        std::vector<uint8_t>                                        octave;      //!< Octave every band is analyzed in
+        std::vector<uint32_t>                                       rowStart;    //!< Offset of every band into weights, Bands() + 1 entries
+        std::vector<uint32_t>                                       firstBin;    //!< First FFT bin of every band
+        std::vector<std::complex<float>>                            weights;     //!< Conjugated kernel spectra of all bands, concatenated
+        std::vector<std::complex<float>>                            response;    //!< Output of Analyze()
+        size_t                                                      channels{};
+        size_t                                                      octaves{};
+        size_t                                                      fftSize{};
+        size_t                                                      maxBlock{};
+    };
+}  // namespace DSP
@@ -0,0 +1,455 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace DSP
+{
+    namespace detail
+    {
+        template<size_t Channels, typename T>
+        void deinterleave(const T* in, size_t frames, float* const* out, float scale)
+        {
+            // frames are converted a tile at a time with contiguous loads, then transposed from the
+            // tile, as compilers do not vectorize strided loads of more than a couple of channels
+            constexpr size_t Tile = 8;
+
+            float*           o[Channels];
+
+            for (size_t c = 0; c < Channels; c++)
+            {
+                o[c] = out[c];
+            }
+
+            size_t i = 0;
+
+            for (; i + Tile <= frames; i += Tile)
+            {
+                float t[Tile * Channels];
+
+                for (size_t k = 0; k < Tile * Channels; k++)
+                {
+                    t[k] = (float) in[i * Channels + k] * scale;
+                }
+
+                for (size_t c = 0; c < Channels; c++)
+                {
+                    for (size_t j = 0; j < Tile; j++)
+                    {
+                        o[c][i + j] = t[j * Channels + c];
+                    }
+                }
+            }
+
+            for (; i < frames; i++)
+            {
+                for (size_t c = 0; c < Channels; c++)
+                {
+                    o[c][i] = (float) in[i * Channels + c] * scale;
+                }
+            }
+        }
+    }  // namespace detail
+
+    /*! Splits interleaved frames into one buffer per channel and converts them to float in one pass
+        Integer samples are normalized to -1.0 to 1.0, float samples are copied as is.
+        \param[in]  in          Interleaved frames
+        \param[in]  frames      Number of frames
+        \param[in]  channels    Number of channels, 1 to 8
+        \param[out] out         Per channel buffers, at least frames long
+    */
+    template<typename T>
+    void Deinterleave(const T* in, size_t frames, size_t channels, float* const* out)
+    {
+        float scale = 1.0f;
+
+        if constexpr (std::numeric_limits<T>::is_integer)
+        {
+            scale = 1.0f / std::numeric_limits<T>::max();
+        }
+
+        switch (channels)
+        {
+            case 1:
+                return detail::deinterleave<1>(in, frames, out, scale);
+            case 2:
+                return detail::deinterleave<2>(in, frames, out, scale);
+            case 3:
+                return detail::deinterleave<3>(in, frames, out, scale);
+            case 4:
+                return detail::deinterleave<4>(in, frames, out, scale);
+            case 5:
+                return detail::deinterleave<5>(in, frames, out, scale);
+            case 6:
+                return detail::deinterleave<6>(in, frames, out, scale);
+            case 7:
+                return detail::deinterleave<7>(in, frames, out, scale);
+            case 8:
+                return detail::deinterleave<8>(in, frames, out, scale);
+        }
+    }
+
+    /*! Power of two sized ring buffer of samples
+        Positions wrap with a mask instead of a modulo, and blocks are written and read with at
+        most two copies.
+    */
+    class RingBuffer
+    {
+    public:
+        /*! Clears the buffer and resizes it to hold at least size samples
+            \param[in]  size    Minimum number of samples
+        */
+        void Resize(size_t size)
+        {
+            data.assign(std::bit_ceil(std::max<size_t>(size, 1)), 0.0f);
+            mask = data.size() - 1;
+            pos  = 0;
+        }
+
+        /*! Appends samples, overwriting the oldest ones
+            \param[in]  x   Samples
+            \param[in]  n   Number of samples, at most the buffer size
+        */
+        void Write(const float* x, size_t n)
+        {
+            const size_t first = std::min(n, data.size() - pos);
+
+            std::memcpy(data.data() + pos, x, first * sizeof(float));
+            std::memcpy(data.data(), x + first, (n - first) * sizeof(float));
+
+            pos = (pos + n) & mask;
+        }
+
+        /*! Copies the most recent samples, oldest first
+            \param[out] out Destination, n long
+            \param[in]  n   Number of samples, at most the buffer size
+        */
+        void Read(float* out, size_t n) const
+        {
+            const size_t start = (pos - n) & mask;
+            const size_t first = std::min(n, data.size() - start);
+
+            std::memcpy(out, data.data() + start, first * sizeof(float));
+            std::memcpy(out + first, data.data(), (n - first) * sizeof(float));
+        }
+
+    private:
+        std::vector<float> data;
+        size_t             mask{};  //!< data.size() - 1
+        size_t             pos{};   //!< Next write position
+    };
+
+    /*! Converts FFT output to scaled power and applies attack/decay smoothing in one pass
+        Each bin is read and written once. The filter coefficient is selected with a compare
+        instead of a table lookup, so the loop has no branches and vectorizes.
+        \param[in]      in      FFT output
+        \param[in,out]  state   Smoothed bin levels, updated in place
+        \param[in]      n       Number of bins
+        \param[in]      scale   Scale applied to the squared magnitude
+        \param[in]      kAttack Filter coefficient for rising levels
+        \param[in]      kDecay  Filter coefficient for falling levels
+    */
+    inline void SmoothPower(const std::complex<float>* in, float* state, size_t n, float scale, float kAttack, float kDecay)
+    {
+        // std::complex<float> is guaranteed to be layout compatible with float[2]
+        const float* c = reinterpret_cast<const float*>(in);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const float re = c[2 * i];
+            const float im = c[2 * i + 1];
+            const float x1 = (re * re + im * im) * scale;
+            const float x0 = state[i];
+            const float k  = (x1 < x0) ? kDecay : kAttack;
+
+            state[i]       = x1 + k * (x0 - x1);
+        }
+    }
+
+    /*! Computes the coefficient of an attack/decay filter, as in the Rainmeter AudioLevel plugin
+        The exponent is log10(0.01), i.e. -2, kept from the original plugin, so the filter covers about 86% of a step
+        (1 - e^-2) in the given time rather than 99%.
+        \param[in]  rate    Rate the filter is updated at in Hz, i.e. the sample rate or the FFT hop rate
+        \param[in]  ms      Attack or decay time in ms
+        \return The filter coefficient, 0 for an instant response
+    */
+    inline float EnvelopeCoefficient(double rate, size_t ms)
+    {
+        return (float) std::exp(std::log10(0.01) / (rate * (double) ms * 0.001));
+    }
+
+    /*! Tracks the RMS and peak envelopes of every channel over a block of samples
+        Squares and absolute values are computed a chunk at a time in a loop that vectorizes. The
+        envelope filters depend on the previous sample and cannot be vectorized over time, so channels
+        are filtered in pairs instead, with the RMS and peak filters of both channels as the four lanes
+        of one vector. Both filter candidates are computed before the compare, so the rise/fall
+        selection is a blend rather than a branch or a table lookup on the dependency chain.
+        \param[in]      x           Per channel samples
+        \param[in]      n           Number of samples per channel
+        \param[in,out]  rms         Per channel mean square envelopes, updated in place
+        \param[in,out]  peak        Per channel peak envelopes, updated in place
+        \param[in]      channels    Number of channels
+        \param[in]      kRMS        RMS filter coefficients for rising and falling levels
+        \param[in]      kPeak       Peak filter coefficients for rising and falling levels
+    */
+    inline void TrackLevels(const float* const* x,
+        size_t                                  n,
+        float*                                  rms,
+        float*                                  peak,
+        size_t                                  channels,
+        const std::array<float, 2>&             kRMS,
+        const std::array<float, 2>&             kPeak)
+    {
+        constexpr size_t  Chunk        = 256;
+        constexpr size_t  Lanes        = 4;  // RMS and peak of a channel pair
+
+        const float       kRise[Lanes] = {kRMS[0], kRMS[0], kPeak[0], kPeak[0]};
+        const float       kFall[Lanes] = {kRMS[1], kRMS[1], kPeak[1], kPeak[1]};
+
+        alignas(16) float in[Chunk][Lanes];
+
+        for (size_t c = 0; c < channels; c += 2)
+        {
+            // an odd channel out is filtered twice, and the copy discarded
+            const size_t      c1           = std::min(c + 1, channels - 1);
+            const float*      x0           = x[c];
+            const float*      x1           = x[c1];
+
+            alignas(16) float state[Lanes] = {rms[c], rms[c1], peak[c], peak[c1]};
+
+            for (size_t base = 0; base < n; base += Chunk)
+            {
+                const size_t m = std::min(Chunk, n - base);
+
+                for (size_t i = 0; i < m; i++)
+                {
+                    const float s0 = x0[base + i];
+                    const float s1 = x1[base + i];
+
+                    in[i][0]       = s0 * s0;
+                    in[i][1]       = s1 * s1;
+                    in[i][2]       = std::fabs(s0);
+                    in[i][3]       = std::fabs(s1);
+                }
+
+                for (size_t i = 0; i < m; i++)
+                {
+                    float next[Lanes];
+
+                    for (size_t j = 0; j < Lanes; j++)
+                    {
+                        const float v    = in[i][j];
+                        const float d    = state[j] - v;
+                        const float rise = v + kRise[j] * d;
+                        const float fall = v + kFall[j] * d;
+
+                        next[j]          = (v < state[j]) ? fall : rise;
+                    }
+
+                    for (size_t j = 0; j < Lanes; j++)
+                    {
+                        state[j] = next[j];
+                    }
+                }
+            }
+
+            rms[c]   = state[0];
+            peak[c]  = state[2];
+            rms[c1]  = state[1];
+            peak[c1] = state[3];
+        }
+    }
+
+    /*! Sparse FFT bin to log-scale band weight matrix in CSR form.
+
+        Row b holds the weights of every FFT bin that overlaps band b, so band integration
+        becomes a sparse matrix-vector product. Bins of a row are always contiguous, so only
+        the first bin of each row is stored instead of a full column index array, which lets
+        Apply() use plain dense dot products that compilers vectorize.
+    */
+    class BandMatrix
+    {
+    public:
+        /*! Precomputes the weights
+            Matches the piecewise linear integration of the Rainmeter AudioLevel plugin, where
+            every bin is split at the band edges it straddles.
+            \param[in]  bandFreq    Upper frequency of every band, ascending
+            \param[in]  df          Frequency step between FFT bins
+            \param[in]  scalar      Scale applied to every weight
+            \param[in]  nBins       Number of FFT bins, i.e. FFTSize / 2 + 1
+        */
+        void Build(std::span<const float> bandFreq, float df, float scalar, size_t nBins)
+        {
+            const size_t nBands = bandFreq.size();
+
+            rowStart.assign(nBands + 1, 0);
+            firstBin.assign(nBands, 0);
+            weights.clear();
+
+            size_t iBin  = 0;
+            size_t iBand = 0;
+            float  f0    = 0.0f;
+
+            auto   add   = [&](float w) {
+                if (weights.size() == rowStart[iBand])
+                {
+                    firstBin[iBand] = (uint32_t) iBin;
+                }
+
+                weights.push_back(w * scalar);
+            };
+
+            while (iBin < nBins and iBand < nBands)
+            {
+                const float fLin1 = ((float) iBin + 0.5f) * df;
+                const float fLog1 = bandFreq[iBand];
+
+                if (fLin1 <= fLog1)
+                {
+                    add(fLin1 - f0);
+                    f0 = fLin1;
+                    iBin += 1;
+                }
+                else
+                {
+                    add(fLog1 - f0);
+                    f0 = fLog1;
+                    iBand += 1;
+
+                    rowStart[iBand] = (uint32_t) weights.size();
+                }
+            }
+
+            // Bands above the last bin stay empty
+            for (auto b = iBand + 1; b <= nBands; b++)
+            {
+                rowStart[b] = (uint32_t) weights.size();
+            }
+        }
+
+        //! Number of bands
+        size_t Rows() const { return firstBin.size(); }
+
+        //! Number of stored weights
+        size_t NonZeros() const { return weights.size(); }
+
+        /*! Integrates one channel of FFT bins into bands
+            \param[in]  in      FFT bins, at least nBins long
+            \param[out] out     Bands, at least Rows() long
+        */
+        void Apply(const float* in, float* out) const
+        {
+            const size_t nBands = Rows();
+
+            for (size_t b = 0; b < nBands; b++)
+            {
+                out[b] = dot(in + firstBin[b], weights.data() + rowStart[b], rowStart[b + 1] - rowStart[b]);
+            }
+        }
+
+        /*! Integrates several channels of FFT bins into bands, reading the weights once per band
+            \param[in]  in          Per channel FFT bins
+            \param[out] out         Per channel bands
+            \param[in]  channels    Number of channels
+        */
+        void Apply(const float* const* in, float* const* out, size_t channels) const
+        {
+            if (channels == 2)
+            {
+                const size_t nBands = Rows();
+
+                for (size_t b = 0; b < nBands; b++)
+                {
+                    const auto n  = rowStart[b + 1] - rowStart[b];
+                    const auto w  = weights.data() + rowStart[b];
+                    const auto x0 = in[0] + firstBin[b];
+                    const auto x1 = in[1] + firstBin[b];
+
+                    float      a0[Lanes]{};
+                    float      a1[Lanes]{};
+                    size_t     k = 0;
+
+                    for (; k + Lanes <= n; k += Lanes)
+                    {
+                        for (size_t j = 0; j < Lanes; j++)
+                        {
+                            a0[j] += w[k + j] * x0[k + j];
+                            a1[j] += w[k + j] * x1[k + j];
+                        }
+                    }
+
+                    float s0 = 0.0f;
+                    float s1 = 0.0f;
+
+                    for (; k < n; k++)
+                    {
+                        s0 += w[k] * x0[k];
+                        s1 += w[k] * x1[k];
+                    }
+
+                    out[0][b] = s0 + hsum(a0);
+                    out[1][b] = s1 + hsum(a1);
+                }
+
+                return;
+            }
+
+            for (size_t c = 0; c < channels; c++)
+            {
+                Apply(in[c], out[c]);
+            }
+        }
+
+    private:
+        //! Accumulator width, matches 256-bit vectors of float
+        static constexpr size_t Lanes = 8;
+
+        static float            hsum(const float (&acc)[Lanes])
+        {
+            float s = 0.0f;
+
+            for (auto v : acc)
+            {
+                s += v;
+            }
+
+            return s;
+        }
+
+        static float dot(const float* x, const float* w, size_t n)
+        {
+            float  acc[Lanes]{};
+            size_t k = 0;
+
+            for (; k + Lanes <= n; k += Lanes)
+            {
+                for (size_t j = 0; j < Lanes; j++)
+                {
+                    acc[j] += w[k + j] * x[k + j];
+                }
+            }
+
+            float s = 0.0f;
+
+            for (; k < n; k++)
+            {
+                s += w[k] * x[k];
+            }
+
+            return s + hsum(acc);
+        }
+
+        std::vector<uint32_t> rowStart;  //!< Offset of every row into weights, Rows() + 1 entries
+        std::vector<uint32_t> firstBin;  //!< First FFT bin of every row
+        std::vector<float>    weights;   //!< Weights of all rows, concatenated
+    };
+}  // namespace DSP
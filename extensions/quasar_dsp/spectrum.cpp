@@ -0,0 +1,271 @@
+#include "spectrum.h"
+
+#include <cmath>
+#include <complex>
+#include <mutex>
+#include <unordered_map>
+
+#include <kfr/base.hpp>
+#include <kfr/dft.hpp>
+#include <kfr/dsp.hpp>
+
+namespace
+{
+    // FFT plan and window of one FFT size, immutable once built and shared by every analyzer of that size
+    struct Plan
+    {
+        kfr::dft_plan_real<float> dft;
+        kfr::univector<float>     window;
+
+        explicit Plan(size_t size) : dft(size), window(kfr::window_hann(size)) {}
+    };
+
+    // Returns the plan of an FFT size, building it on first use. Plans are kept for the lifetime of the process,
+    // so switching back to an earlier size is only a lookup
+    std::shared_ptr<const Plan> cachedPlan(size_t size)
+    {
+        static std::mutex                                              mutex;
+        static std::unordered_map<size_t, std::shared_ptr<const Plan>> plans;
+
+        std::lock_guard                                                lk(mutex);
+
+        auto&                                                          plan = plans[size];
+
+        if (!plan)
+        {
+            plan = std::make_shared<const Plan>(size);
+        }
+
+        return plan;
+    }
+
+    // Mixes the front channels down and converts the levels to the 0.0 to 1.0 dB scale of the output sources
+    void toDecibels(const float* left, const float* right, size_t count, double sensitivity, double* out)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            double x = right ? (left[i] + right[i]) * 0.5 : left[i];
+
+            x        = std::clamp(x, 0.0, 1.0);
+            out[i]   = std::max(0.0, sensitivity * std::log10(x) + 1.0);
+        }
+    }
+}  // namespace
+
+struct DSP::SpectrumAnalyzer::Transform
+{
+    std::shared_ptr<const Plan>         plan;  //!< Cached FFT plan and window
+    kfr::univector<float>               in;    //!< Windowed FFT input
+    kfr::univector<std::complex<float>> out;   //!< FFT output
+    kfr::univector<kfr::u8>             temp;  //!< FFT scratch space
+
+    explicit Transform(size_t size) : plan(cachedPlan(size)), in(size, 0.0f), out(size, {0.0f, 0.0f}), temp(plan->dft.temp_size) {}
+};
+
+DSP::SpectrumAnalyzer::SpectrumAnalyzer() = default;
+
+DSP::SpectrumAnalyzer::~SpectrumAnalyzer() = default;
+
+void DSP::SpectrumAnalyzer::Configure(const SpectrumOptions& opts)
+{
+    options          = opts;
+    options.channels = std::clamp<size_t>(options.channels, 1, MaxChannels);
+
+    transform.reset();
+    constantQ.reset();
+    bandFreq.clear();
+    power.assign(options.trackPower ? Bins() : 0, 0.0f);
+
+    for (size_t c = 0; c < MaxChannels; c++)
+    {
+        const bool used = (c < options.channels);
+
+        rings[c].Resize(used ? options.fftSize : 0);
+        spectrum[c].assign(used ? Bins() : 0, 0.0f);
+        bands[c].assign(used ? options.nBands : 0, 0.0f);
+    }
+
+    if (options.nBands)
+    {
+        bandFreq.resize(options.nBands, 0.0f);
+
+        const double step = (std::log(options.freqMax / options.freqMin) / options.nBands) / std::log(2.0);
+        bandFreq[0]       = (float) (options.freqMin * std::pow(2.0, step / 2.0));
+
+        for (size_t b = 1; b < options.nBands; b++)
+        {
+            bandFreq[b] = (float) (bandFreq[b - 1] * std::pow(2.0, step));
+        }
+    }
+
+    if (!options.fftSize)
+    {
+        return;
+    }
+
+    options.fftOverlap = std::min(options.fftOverlap, options.fftSize - 1);
+
+    transform          = std::make_unique<Transform>(options.fftSize);
+    fftScalar          = (float) (1.0 / std::sqrt((double) options.fftSize));
+    untilHop           = options.fftSize - options.fftOverlap;
+
+    if (options.nBands)
+    {
+        if (!options.constantQ)
+        {
+            const float df         = (float) options.sampleRate / options.fftSize;
+            const float bandScalar = 2.0f / (float) options.sampleRate;
+
+            bandMatrix.Build(bandFreq, df, bandScalar, Bins());
+        }
+        else
+        {
+            // bands are one step wide and centered half a step below their upper frequencies
+            const double       step = std::log2(options.freqMax / options.freqMin) / options.nBands;
+            std::vector<float> centers(options.nBands);
+
+            for (size_t b = 0; b < options.nBands; b++)
+            {
+                centers[b] = (float) (options.freqMin * std::pow(2.0, step * b));
+            }
+
+            constantQ = std::make_unique<ConstantQ>();
+            constantQ->Configure(options.sampleRate, options.channels, centers, 1.0 / (std::pow(2.0, step) - 1.0), options.fftSize);
+
+            // a sine at the center of a band reads the same level as with integrated FFT bins. By Parseval, the bins of a
+            // sine of amplitude A integrate to A^2 / 2 * fftScalar * the window energy, while its constant-Q response is A / 2
+            const auto& window = transform->plan->window;
+            double      energy = 0.0;
+
+            for (size_t i = 0; i < window.size(); i++)
+            {
+                energy += (double) window[i] * window[i];
+            }
+
+            cqScalar = (float) (2.0 * energy) * fftScalar;
+        }
+    }
+
+    SetEnvelope(options.envFFT);
+}
+
+void DSP::SpectrumAnalyzer::Continue(const SpectrumAnalyzer& previous)
+{
+    if (!transform or !previous.transform)
+    {
+        return;
+    }
+
+    // the FFT input buffer is free between hops, so the history is copied through it
+    const size_t history  = std::min(options.fftSize, previous.options.fftSize);
+    const size_t channels = std::min(options.channels, previous.options.channels);
+
+    for (size_t c = 0; c < channels; c++)
+    {
+        previous.rings[c].Read(transform->in.data(), history);
+        rings[c].Write(transform->in.data(), history);
+
+        if (Bins() == previous.Bins())
+        {
+            std::copy(previous.spectrum[c].begin(), previous.spectrum[c].end(), spectrum[c].begin());
+        }
+
+        if (Bands() == previous.Bands())
+        {
+            std::copy(previous.bands[c].begin(), previous.bands[c].end(), bands[c].begin());
+        }
+    }
+}
+
+void DSP::SpectrumAnalyzer::SetEnvelope(const std::array<size_t, 2>& env)
+{
+    options.envFFT = env;
+
+    if (options.fftSize)
+    {
+        // bin levels are filtered once per hop
+        const double hopRate = options.sampleRate / (double) (options.fftSize - options.fftOverlap);
+
+        kFFT[0]              = EnvelopeCoefficient(hopRate, env[0]);
+        kFFT[1]              = EnvelopeCoefficient(hopRate, env[1]);
+    }
+}
+
+void DSP::SpectrumAnalyzer::hop(bool silent)
+{
+    auto& t = *transform;
+
+    for (size_t c = 0; c < options.channels; c++)
+    {
+        if (!silent)
+        {
+            // copy the most recent samples from the ring buffer and apply the windowing function
+            rings[c].Read(t.in.data(), options.fftSize);
+            t.in = t.in * t.plan->window;
+
+            t.plan->dft.execute(t.out, t.in, t.temp);
+        }
+        else
+        {
+            std::fill(t.out.begin(), t.out.end(), std::complex{0.0f, 0.0f});
+        }
+
+        // convert to power and filter the bin levels as with peak measurements
+        SmoothPower(t.out.data(), spectrum[c].data(), Bins(), fftScalar, kFFT[0], kFFT[1]);
+
+        if (constantQ)
+        {
+            if (!silent)
+            {
+                SmoothPower(constantQ->Analyze(c), bands[c].data(), Bands(), cqScalar, kFFT[0], kFFT[1]);
+            }
+            else
+            {
+                for (auto& x : bands[c])
+                {
+                    x *= kFFT[1];
+                }
+            }
+        }
+
+        if (options.trackPower)
+        {
+            const float* x    = reinterpret_cast<const float*>(t.out.data());
+            const float  keep = c ? 1.0f : 0.0f;  // the first channel overwrites the previous hop
+
+            for (size_t i = 0; i < power.size(); i++)
+            {
+                power[i] = keep * power[i] + (x[2 * i] * x[2 * i] + x[2 * i + 1] * x[2 * i + 1]) * fftScalar;
+            }
+        }
+    }
+}
+
+void DSP::SpectrumAnalyzer::IntegrateBands()
+{
+    if (!options.fftSize or !options.nBands or constantQ)
+    {
+        return;
+    }
+
+    std::array<const float*, MaxChannels> ins{};
+    std::array<float*, MaxChannels>       outs{};
+
+    for (size_t c = 0; c < options.channels; c++)
+    {
+        ins[c]  = spectrum[c].data();
+        outs[c] = bands[c].data();
+    }
+
+    bandMatrix.Apply(ins.data(), outs.data(), options.channels);
+}
+
+void DSP::SpectrumAnalyzer::SpectrumLevels(double sensitivity, double* out) const
+{
+    toDecibels(spectrum[0].data(), options.channels >= 2 ? spectrum[1].data() : nullptr, Bins(), sensitivity, out);
+}
+
+void DSP::SpectrumAnalyzer::BandLevels(double sensitivity, double* out) const
+{
+    toDecibels(bands[0].data(), options.channels >= 2 ? bands[1].data() : nullptr, Bands(), sensitivity, out);
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "constantq.h"
+#include "dsp.h"
+
+namespace DSP
+{
+    //! Spectrum analyzer options
+    struct SpectrumOptions
+    {
+        double                sampleRate{48000.0};  //!< Sample rate in Hz
+        size_t                channels{2};          //!< Number of channels, at most SpectrumAnalyzer::MaxChannels
+        size_t                fftSize{};            //!< Size of the FFT, 0 disables the analyzer
+        size_t                fftOverlap{};         //!< Number of samples shared by consecutive FFTs, less than fftSize
+        std::array<size_t, 2> envFFT{300, 300};     //!< Bin level attack/decay times in ms
+        size_t                nBands{};             //!< Number of log-scale frequency bands, 0 disables band integration
+        double                freqMin{20.0};        //!< Lower edge of the first band in Hz
+        double                freqMax{20000.0};     //!< Upper edge of the last band in Hz
+        bool                  trackPower{};         //!< Keep the unsmoothed power of the last hop for Power(), i.e. for onset detection
+        bool                  constantQ{};          //!< Compute the bands with a constant-Q transform instead of integrating FFT bins
+    };
+
+    /*! Spectrum analyzer pipeline shared by the audio visualizer extensions.
+
+        Per channel samples are collected in ring buffers. Every FFTSize - FFTOverlap samples, the most
+        recent FFTSize samples of every channel are windowed, transformed, converted to power and smoothed
+        with attack/decay filters. The smoothed bins can then be integrated into log-scale bands, and both
+        are mixed down and scaled to the 0.0 to 1.0 dB range of the output sources.
+
+        With constantQ, the bands are instead computed by a ConstantQ analyzer on every hop and smoothed
+        with the same filters. Their resolution then no longer depends on the FFT size, which only sets
+        the resolution of the bins and, with the overlap, the hop.
+
+        Matches the Rainmeter AudioLevel plugin the visualizers were adapted from. The analyzer is not
+        thread safe, callers serialize access.
+    */
+    class SpectrumAnalyzer
+    {
+    public:
+        static constexpr size_t MaxChannels = 8;
+
+        SpectrumAnalyzer();
+        ~SpectrumAnalyzer();
+
+        SpectrumAnalyzer(const SpectrumAnalyzer&)             = delete;
+        SpectrumAnalyzer& operator= (const SpectrumAnalyzer&) = delete;
+
+        /*! Rebuilds the pipeline and clears all levels
+            FFT plans are cached by size and shared between analyzers, so only the first use of a size builds one.
+            An FFT size of 0 releases all buffers.
+            \param[in]  opts    Analyzer options
+        */
+        void                   Configure(const SpectrumOptions& opts);
+
+        /*! Carries the recent input and, where the layouts match, the levels of a previous pipeline over
+            Lets a reconfigured analyzer pick up where the one it replaces left off instead of starting from silence.
+            Does not allocate, so it can be called on the processing thread.
+            Constant-Q input history is not carried over, its bands continue from their last levels.
+            \param[in]  previous    Analyzer being replaced, with the same number of channels
+        */
+        void                   Continue(const SpectrumAnalyzer& previous);
+
+        /*! Changes the bin level attack/decay times, keeping the current levels
+            \param[in]  env     Attack and decay times in ms
+        */
+        void                   SetEnvelope(const std::array<size_t, 2>& env);
+
+        //! Current options
+        const SpectrumOptions& Options() const { return options; }
+
+        //! Number of FFT bins, i.e. FFTSize / 2 + 1, or 0 if the analyzer is disabled
+        size_t                 Bins() const { return options.fftSize ? (options.fftSize / 2) + 1 : 0; }
+
+        //! Number of bands
+        size_t                 Bands() const { return options.nBands; }
+
+        /*! Feeds a block of samples, running an FFT for every completed hop
+            \param[in]  in      Per channel samples, one buffer for every configured channel
+            \param[in]  frames  Number of samples per channel
+            \param[in]  onHop   Called after every FFT, once the bin levels are updated
+            \param[in]  silent  Treats the block as silence, decaying the bin levels instead of transforming the input
+        */
+        template<typename OnHop>
+        void Process(const float* const* in, size_t frames, OnHop&& onHop, bool silent = false)
+        {
+            if (!options.fftSize)
+            {
+                return;
+            }
+
+            size_t done = 0;
+
+            while (done < frames)
+            {
+                // fill ring buffers up to the next FFT
+                const size_t n = std::min(frames - done, untilHop);
+
+                for (size_t c = 0; c < options.channels; c++)
+                {
+                    rings[c].Write(in[c] + done, n);
+
+                    if (constantQ)
+                    {
+                        constantQ->Write(c, in[c] + done, n);
+                    }
+                }
+
+                done += n;
+                untilHop -= n;
+
+                if (!untilHop)
+                {
+                    hop(silent);
+                    untilHop = options.fftSize - options.fftOverlap;
+
+                    onHop();
+                }
+            }
+        }
+
+        //! \overload
+        void Process(const float* const* in, size_t frames, bool silent = false)
+        {
+            Process(in, frames, [] {}, silent);
+        }
+
+        //! Integrates the current bin levels of every channel into bands. Does nothing with constantQ, as those bands are updated on every hop
+        void                   IntegrateBands();
+
+        //! Smoothed power of every bin of a channel, Bins() long
+        const float*           Spectrum(size_t channel) const { return spectrum[channel].data(); }
+
+        //! Unsmoothed power of every bin in the last hop, summed over channels, Bins() long. Only kept with trackPower
+        const float*           Power() const { return power.data(); }
+
+        //! Band levels of a channel as of the last IntegrateBands(), Bands() long
+        const float*           Band(size_t channel) const { return bands[channel].data(); }
+
+        //! Upper frequency of every band in Hz
+        std::span<const float> BandFrequencies() const { return bandFreq; }
+
+        //! Center frequency of a bin in Hz
+        double                 BinFrequency(size_t bin) const { return (double) bin * options.sampleRate / options.fftSize; }
+
+        /*! Mixes the front channels of the bin levels down and scales them to 0.0 to 1.0
+            \param[in]  sensitivity     dB scale factor, i.e. 10 / dB range
+            \param[out] out             Output levels, Bins() long
+        */
+        void                   SpectrumLevels(double sensitivity, double* out) const;
+
+        /*! Mixes the front channels of the band levels down and scales them to 0.0 to 1.0
+            \param[in]  sensitivity     dB scale factor, i.e. 10 / dB range
+            \param[out] out             Output levels, Bands() long
+        */
+        void                   BandLevels(double sensitivity, double* out) const;
+
+    private:
+        struct Transform;  // FFT plan and scratch buffers, keeps KFR out of this header
+
+        void                                        hop(bool silent);
+
+        SpectrumOptions                             options;
+        std::unique_ptr<Transform>                  transform;
+        std::unique_ptr<ConstantQ>                  constantQ;  //!< Band analyzer, only with constantQ
+        std::array<RingBuffer, MaxChannels>         rings;      //!< FFT input of every channel
+        std::array<std::vector<float>, MaxChannels> spectrum;   //!< Smoothed bin levels of every channel
+        std::array<std::vector<float>, MaxChannels> bands;      //!< Band levels of every channel
+        std::vector<float>                          bandFreq;   //!< Upper frequency of every band
+        std::vector<float>                          power;      //!< Unsmoothed power of the last hop, summed over channels
+        BandMatrix                                  bandMatrix;
+        std::array<float, 2>                        kFFT{};       //!< Bin level attack/decay filter constants
+        float                                       fftScalar{};  //!< Power scale of the FFT output
+        float                                       cqScalar{};   //!< Power scale of the constant-Q output
+        size_t                                      untilHop{};   //!< Samples left until the next FFT
+    };
+}  // namespace DSP
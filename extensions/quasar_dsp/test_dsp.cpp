@@ -0,0 +1,545 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <deque>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include "beat.h"
+#include "constantq.h"
+#include "dsp.h"
+#include "spectrum.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+    constexpr double Rate = 48000.0;
+
+    // Band upper frequencies as laid out by SpectrumAnalyzer::Configure()
+    std::vector<float> bandLayout(size_t nBands, double freqMin = 20.0, double freqMax = 20000.0)
+    {
+        std::vector<float> freq(nBands);
+
+        const double       step = (std::log(freqMax / freqMin) / nBands) / std::log(2.0);
+        freq[0]                 = (float) (freqMin * std::pow(2.0, step / 2.0));
+
+        for (size_t b = 1; b < nBands; b++)
+        {
+            freq[b] = (float) (freq[b - 1] * std::pow(2.0, step));
+        }
+
+        return freq;
+    }
+
+    // Band integration loop of the original pulse_viz, which BandMatrix replaces
+    void integrateBandsLoop(const std::vector<float>& bandFreq, float df, float scalar, size_t nBins, const float* in, float* out)
+    {
+        const size_t nBands = bandFreq.size();
+
+        std::fill(out, out + nBands, 0.0f);
+
+        size_t iBin  = 0;
+        size_t iBand = 0;
+        float  f0    = 0.0f;
+
+        while (iBin < nBins and iBand < nBands)
+        {
+            const float fLin1 = ((float) iBin + 0.5f) * df;
+            const float fLog1 = bandFreq[iBand];
+
+            if (fLin1 <= fLog1)
+            {
+                out[iBand] += (fLin1 - f0) * in[iBin] * scalar;
+                f0 = fLin1;
+                iBin += 1;
+            }
+            else
+            {
+                out[iBand] += (fLog1 - f0) * in[iBin] * scalar;
+                f0 = fLog1;
+                iBand += 1;
+            }
+        }
+    }
+
+    // Smoothing loop of the original pulse_viz, which SmoothPower replaces
+    void smoothLoop(const std::complex<float>* in, float* state, size_t n, float scale, const std::array<float, 2>& k)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            const float x1 = std::norm(in[i]) * scale;
+            const float x0 = state[i];
+
+            state[i]       = x1 + k[(x1 < x0)] * (x0 - x1);
+        }
+    }
+
+    std::vector<float> sine(size_t n, double freq, size_t offset = 0)
+    {
+        std::vector<float> x(n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            x[i] = (float) (0.5 * std::sin(2.0 * std::numbers::pi * freq * (double) (i + offset) / Rate));
+        }
+
+        return x;
+    }
+
+    DSP::SpectrumOptions monoOptions(size_t fftSize, size_t fftOverlap, size_t nBands)
+    {
+        return {
+            .sampleRate = Rate,
+            .channels   = 1,
+            .fftSize    = fftSize,
+            .fftOverlap = fftOverlap,
+            .envFFT     = {0, 0},
+            .nBands     = nBands,
+        };
+    }
+}  // namespace
+
+TEST(RingBuffer, ResizeRoundsUpToPowerOfTwo)
+{
+    DSP::RingBuffer ring;
+    ring.Resize(5);
+
+    // a buffer of 8 holds 8 samples, the 9th overwrites the first
+    std::vector<float> x{1, 2, 3, 4, 5, 6, 7, 8, 9};
+    ring.Write(x.data(), 8);
+    ring.Write(x.data() + 8, 1);
+
+    std::array<float, 8> out{};
+    ring.Read(out.data(), out.size());
+
+    EXPECT_EQ(out, (std::array<float, 8>{2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+TEST(RingBuffer, MatchesQueueAcrossWraparound)
+{
+    DSP::RingBuffer   ring;
+    std::deque<float> model;
+    std::mt19937      rng{1};
+
+    ring.Resize(64);
+
+    float next = 0.0f;
+
+    for (int iter = 0; iter < 200; iter++)
+    {
+        const size_t       n = std::uniform_int_distribution<size_t>{0, 64}(rng);
+        std::vector<float> x(n);
+
+        for (auto& v : x)
+        {
+            v = next++;
+            model.push_back(v);
+        }
+
+        ring.Write(x.data(), n);
+
+        while (model.size() > 64)
+        {
+            model.pop_front();
+        }
+
+        const size_t       m = std::uniform_int_distribution<size_t>{0, model.size()}(rng);
+        std::vector<float> out(m);
+        ring.Read(out.data(), m);
+
+        ASSERT_TRUE(std::equal(out.begin(), out.end(), model.end() - m)) << "iteration " << iter;
+    }
+}
+
+TEST(Deinterleave, MatchesScalarLoop)
+{
+    std::mt19937 rng{2};
+
+    // 37 frames leaves a partial tile
+    constexpr size_t frames = 37;
+
+    for (size_t channels = 1; channels <= 8; channels++)
+    {
+        std::vector<int16_t> in16(frames * channels);
+        std::vector<float>   inF(frames * channels);
+
+        for (size_t i = 0; i < in16.size(); i++)
+        {
+            in16[i] = (int16_t) std::uniform_int_distribution<int>{-32768, 32767}(rng);
+            inF[i]  = std::uniform_real_distribution<float>{-1.0f, 1.0f}(rng);
+        }
+
+        std::vector<std::vector<float>> out16(channels, std::vector<float>(frames));
+        std::vector<std::vector<float>> outF(channels, std::vector<float>(frames));
+        std::vector<float*>             p16, pF;
+
+        for (size_t c = 0; c < channels; c++)
+        {
+            p16.push_back(out16[c].data());
+            pF.push_back(outF[c].data());
+        }
+
+        DSP::Deinterleave(in16.data(), frames, channels, p16.data());
+        DSP::Deinterleave(inF.data(), frames, channels, pF.data());
+
+        for (size_t i = 0; i < frames; i++)
+        {
+            for (size_t c = 0; c < channels; c++)
+            {
+                ASSERT_FLOAT_EQ(out16[c][i], (float) in16[i * channels + c] * (1.0f / 32767)) << channels << " channels";
+                ASSERT_EQ(outF[c][i], inF[i * channels + c]) << channels << " channels";
+            }
+        }
+    }
+}
+
+TEST(SmoothPower, MatchesScalarLoop)
+{
+    std::mt19937                          rng{3};
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+    constexpr size_t                      n = 1025;
+    const std::array<float, 2>            k{DSP::EnvelopeCoefficient(Rate / 1024, 100), DSP::EnvelopeCoefficient(Rate / 1024, 300)};
+
+    std::vector<std::complex<float>>      in(n);
+    std::vector<float>                    state(n), expected(n);
+
+    for (int hop = 0; hop < 4; hop++)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            in[i] = {dist(rng), dist(rng)};
+        }
+
+        DSP::SmoothPower(in.data(), state.data(), n, 0.03125f, k[0], k[1]);
+        smoothLoop(in.data(), expected.data(), n, 0.03125f, k);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            ASSERT_FLOAT_EQ(state[i], expected[i]) << "bin " << i << ", hop " << hop;
+        }
+    }
+}
+
+TEST(BandMatrix, MatchesScalarLoop)
+{
+    std::mt19937                          rng{4};
+    std::uniform_real_distribution<float> dist{0.0f, 1.0f};
+
+    for (size_t fftSize : {256, 1024, 8192})
+    {
+        for (size_t nBands : {1, 16, 64, 256})
+        {
+            const size_t nBins    = fftSize / 2 + 1;
+            const float  df       = (float) Rate / fftSize;
+            const float  scalar   = 2.0f / (float) Rate;
+            const auto   bandFreq = bandLayout(nBands);
+
+            DSP::BandMatrix m;
+            m.Build(bandFreq, df, scalar, nBins);
+
+            ASSERT_EQ(m.Rows(), nBands);
+
+            std::array<std::vector<float>, 3> in, out, expected;
+            std::array<const float*, 3>       ins;
+            std::array<float*, 3>             outs;
+
+            for (size_t c = 0; c < 3; c++)
+            {
+                in[c].resize(nBins);
+                out[c].assign(nBands, -1.0f);
+                expected[c].resize(nBands);
+
+                std::generate(in[c].begin(), in[c].end(), [&] {
+                    return dist(rng);
+                });
+
+                integrateBandsLoop(bandFreq, df, scalar, nBins, in[c].data(), expected[c].data());
+
+                ins[c]  = in[c].data();
+                outs[c] = out[c].data();
+            }
+
+            // the stereo path and the generic path for other channel counts
+            m.Apply(ins.data(), outs.data(), 2);
+            m.Apply(ins[2], outs[2]);
+
+            for (size_t c = 0; c < 3; c++)
+            {
+                for (size_t b = 0; b < nBands; b++)
+                {
+                    ASSERT_NEAR(out[c][b], expected[c][b], 1e-5f * std::max(1.0f, std::fabs(expected[c][b])))
+                        << "FFT " << fftSize << ", " << nBands << " bands, channel " << c << ", band " << b;
+                }
+            }
+        }
+    }
+}
+
+TEST(SpectrumAnalyzer, SineLandsInItsBinAndBand)
+{
+    constexpr size_t fftSize = 1024;
+    constexpr size_t bin     = 64;  // 3 kHz
+    constexpr size_t nBands  = 16;
+
+    const double     freq    = bin * Rate / fftSize;
+
+    DSP::SpectrumAnalyzer analyzer;
+    analyzer.Configure(monoOptions(fftSize, 0, nBands));
+
+    const auto   x  = sine(4 * fftSize, freq);
+    const float* in = x.data();
+
+    analyzer.Process(&in, x.size());
+    analyzer.IntegrateBands();
+
+    const float* spectrum = analyzer.Spectrum(0);
+    const auto   peakBin  = std::max_element(spectrum, spectrum + analyzer.Bins()) - spectrum;
+
+    EXPECT_EQ(peakBin, bin);
+    EXPECT_DOUBLE_EQ(analyzer.BinFrequency(peakBin), freq);
+
+    // bands are named by their upper frequencies
+    const auto   bandFreq = analyzer.BandFrequencies();
+    const auto   expected = std::lower_bound(bandFreq.begin(), bandFreq.end(), (float) freq) - bandFreq.begin();
+
+    const float* bands    = analyzer.Band(0);
+    const auto   peakBand = std::max_element(bands, bands + analyzer.Bands()) - bands;
+
+    EXPECT_EQ(peakBand, expected);
+}
+
+TEST(SpectrumAnalyzer, HopsAreIndependentOfBlockSize)
+{
+    constexpr size_t fftSize = 256;
+    constexpr size_t overlap = 64;
+    constexpr size_t hop     = fftSize - overlap;
+    constexpr size_t total   = 10000;
+
+    const auto       x       = sine(total, 1000.0);
+
+    DSP::SpectrumAnalyzer whole, split;
+    whole.Configure(monoOptions(fftSize, overlap, 0));
+    split.Configure(monoOptions(fftSize, overlap, 0));
+
+    size_t       wholeHops = 0;
+    size_t       splitHops = 0;
+
+    const float* in        = x.data();
+    whole.Process(&in, total, [&] {
+        wholeHops++;
+    });
+
+    // blocks shorter than, equal to and longer than a hop, so that hops land inside and on block boundaries
+    const size_t blocks[] = {1, 7, hop - 1, hop, hop + 1, 500, 3 * hop};
+    size_t       done     = 0;
+
+    for (size_t i = 0; done < total; i++)
+    {
+        const size_t n     = std::min(blocks[i % std::size(blocks)], total - done);
+        const float* block = x.data() + done;
+
+        split.Process(&block, n, [&] {
+            splitHops++;
+        });
+
+        done += n;
+    }
+
+    EXPECT_EQ(wholeHops, total / hop);
+    EXPECT_EQ(splitHops, total / hop);
+
+    for (size_t i = 0; i < whole.Bins(); i++)
+    {
+        ASSERT_EQ(whole.Spectrum(0)[i], split.Spectrum(0)[i]) << "bin " << i;
+    }
+}
+
+TEST(SpectrumAnalyzer, ContinueMatchesUninterruptedAnalyzer)
+{
+    constexpr size_t fftSize = 1024;
+    constexpr size_t hop     = fftSize;
+    const auto       opts    = [] {
+        auto o   = monoOptions(fftSize, 0, 32);
+        o.envFFT = {100, 300};
+        return o;
+    }();
+
+    // a whole number of hops, so that the replacement starts on the same hop boundary
+    const auto before = sine(8 * hop, 440.0);
+    const auto after  = sine(4 * hop, 880.0, before.size());
+
+    DSP::SpectrumAnalyzer reference, previous, replacement;
+    reference.Configure(opts);
+    previous.Configure(opts);
+    replacement.Configure(opts);
+
+    const float* in = before.data();
+    reference.Process(&in, before.size());
+    previous.Process(&in, before.size());
+
+    replacement.Continue(previous);
+
+    for (size_t i = 0; i < replacement.Bins(); i++)
+    {
+        ASSERT_EQ(replacement.Spectrum(0)[i], reference.Spectrum(0)[i]) << "bin " << i;
+    }
+
+    in = after.data();
+    reference.Process(&in, after.size());
+    replacement.Process(&in, after.size());
+
+    reference.IntegrateBands();
+    replacement.IntegrateBands();
+
+    for (size_t i = 0; i < replacement.Bins(); i++)
+    {
+        ASSERT_EQ(replacement.Spectrum(0)[i], reference.Spectrum(0)[i]) << "bin " << i;
+    }
+
+    for (size_t b = 0; b < replacement.Bands(); b++)
+    {
+        ASSERT_EQ(replacement.Band(0)[b], reference.Band(0)[b]) << "band " << b;
+    }
+}
+
+TEST(SpectrumAnalyzer, ContinueFromSilenceWithoutHistory)
+{
+    // a freshly configured analyzer has no history, continuing from it must not disturb the replacement
+    DSP::SpectrumAnalyzer previous, replacement;
+    previous.Configure(monoOptions(512, 0, 8));
+    replacement.Configure(monoOptions(2048, 0, 8));
+
+    replacement.Continue(previous);
+
+    for (size_t i = 0; i < replacement.Bins(); i++)
+    {
+        ASSERT_EQ(replacement.Spectrum(0)[i], 0.0f);
+    }
+}
+
+TEST(SpectrumAnalyzer, ConstantQBandsMatchIntegratedBins)
+{
+    constexpr size_t fftSize = 512;
+    constexpr size_t nBands  = 32;
+
+    // the upper bands are many bins wide, so the window's main lobe of a sine at their centers falls inside them
+    DSP::SpectrumAnalyzer fft, cq;
+
+    auto                  options = monoOptions(fftSize, 0, nBands);
+    fft.Configure(options);
+
+    options.constantQ = true;
+    cq.Configure(options);
+
+    const double step = std::log2(options.freqMax / options.freqMin) / nBands;
+
+    for (size_t b = 24; b < nBands - 1; b++)
+    {
+        const double freq = options.freqMin * std::pow(2.0, step * b);
+        const auto   x    = sine(Rate, freq);
+        const float* in   = x.data();
+
+        fft.Process(&in, x.size());
+        fft.IntegrateBands();
+        cq.Process(&in, x.size());
+
+        const float expected = fft.Band(0)[b];
+
+        ASSERT_GT(expected, 0.0f);
+        EXPECT_NEAR(cq.Band(0)[b] / expected, 1.0f, 0.02f) << "band " << b << " at " << freq << " Hz";
+    }
+}
+
+TEST(ConstantQ, DecimatorsPassBandsAndRejectAliases)
+{
+    // a narrow band in the fifth octave, so that its input runs through four decimators
+    constexpr double  center = 1000.0;
+    constexpr double  q      = 17.0;
+    const float       centers[] = {(float) center};
+
+    auto              response  = [&](double freq) {
+        DSP::ConstantQ cq;
+        cq.Configure(Rate, 1, centers, q, 480);
+
+        const auto x = sine(Rate, freq);
+
+        for (size_t i = 0; i < x.size(); i += 480)
+        {
+            cq.Write(0, x.data() + i, 480);
+        }
+
+        return std::abs(cq.Analyze(0)[0]);
+    };
+
+    DSP::ConstantQ layout;
+    layout.Configure(Rate, 1, centers, q, 480);
+
+    ASSERT_EQ(layout.Octaves(), 5u);
+
+    // half the amplitude of the sine at the center frequency, i.e. unity gain through every decimator
+    const float level = response(center);
+
+    EXPECT_NEAR(level, 0.25f, 0.0025f);
+
+    // frequencies that fold onto the center frequency at the output of every decimator
+    for (size_t o = 1; o < layout.Octaves(); o++)
+    {
+        const double alias = std::ldexp(Rate, -(int) o) - center;
+
+        EXPECT_LT(response(alias), level * 1e-3f) << "alias at " << alias << " Hz into octave " << o;
+    }
+}
+
+TEST(BeatTracker, SteadySpectrumAfterRebuildIsNotAnOnset)
+{
+    const DSP::BeatOptions   opts{.hopRate = 100.0};
+    const std::vector<float> steady(64, 1.0f);
+
+    DSP::BeatTracker         previous;
+    previous.Configure(opts, steady.size());
+
+    for (size_t i = 0; i < 50; i++)
+    {
+        previous.Update(steady.data());
+    }
+
+    // same bin count, the previous spectrum is carried over
+    DSP::BeatTracker same;
+    same.Configure(opts, steady.size());
+    same.Continue(previous);
+
+    EXPECT_FALSE(same.Update(steady.data()));
+    EXPECT_EQ(same.Flux(), 0.0f);
+
+    // different bin count, the first hop only primes the spectrum
+    const std::vector<float> wider(128, 1.0f);
+
+    DSP::BeatTracker         resized;
+    resized.Configure(opts, wider.size());
+    resized.Continue(previous);
+
+    EXPECT_FALSE(resized.Update(wider.data()));
+    EXPECT_EQ(resized.Flux(), 0.0f);
+    EXPECT_FALSE(resized.Update(wider.data()));
+}
+
+TEST(BeatTracker, DetectsOnsetAfterPriming)
+{
+    const DSP::BeatOptions   opts{.hopRate = 100.0};
+    const std::vector<float> quiet(64, 0.0f), loud(64, 1.0f);
+
+    DSP::BeatTracker         tracker;
+    tracker.Configure(opts, quiet.size());
+
+    for (size_t i = 0; i < 50; i++)
+    {
+        ASSERT_FALSE(tracker.Update(quiet.data()));
+    }
+
+    EXPECT_TRUE(tracker.Update(loud.data()));
+}
@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <extension_api.h>
+#include <extension_support.hpp>
+
+#include <fmt/core.h>
+
+constexpr std::string_view EXT_FULLNAME = "Synthetic Load Generator";
+constexpr std::string_view EXT_NAME     = "synthetic_load";
+
+#define qlog(l, ...)                                                      \
+  {                                                                       \
+    auto msg = fmt::format("{}: {}", EXT_NAME, fmt::format(__VA_ARGS__)); \
+    quasar_log(l, msg.c_str());                                           \
+  }
+
+#define info(...) qlog(QUASAR_LOG_INFO, __VA_ARGS__)
+#define warn(...) qlog(QUASAR_LOG_WARNING, __VA_ARGS__)
+
+namespace
+{
+    enum class Shape : int
+    {
+        Scalar,
+        Array,
+        Nested
+    };
+
+    // Topic layout is fixed at load time, so it is configured through the environment
+    constexpr auto                             TopicsEnv     = "QUASAR_SYNTHETIC_TOPICS";
+    constexpr auto                             RateEnv       = "QUASAR_SYNTHETIC_RATE_US";
+    constexpr size_t                           DefaultTopics = 16;
+    constexpr size_t                           MaxTopics     = 1024;
+    constexpr int64_t                          DefaultRate   = 100000;
+
+    quasar_ext_handle                          extHandle = nullptr;
+
+    std::vector<quasar_data_source_t>          sources;
+    std::unordered_map<size_t, size_t>         uidMap;    // uid -> index into sources
+    std::unique_ptr<std::atomic<uint64_t>[]>   sequence;  // per topic sequence numbers
+
+    // Settings, read by get_data on pool threads
+    std::atomic<Shape>                         shape{Shape::Array};
+    std::atomic<size_t>                        payloadSize{64};
+    std::atomic<int64_t>                       costUs{0};
+
+    int64_t ReadEnv(const char* name, int64_t dflt, int64_t min, int64_t max)
+    {
+        const char* value = std::getenv(name);
+
+        if (!value or !*value)
+        {
+            return dflt;
+        }
+
+        char* end    = nullptr;
+        auto  result = std::strtoll(value, &end, 10);
+
+        if (*end != '\0')
+        {
+            return dflt;
+        }
+
+        return std::clamp<int64_t>(result, min, max);
+    }
+
+    //! Simulates get_data work by spinning, so that the cost shows up as CPU time
+    void Spin(int64_t us)
+    {
+        if (us <= 0)
+        {
+            return;
+        }
+
+        const auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+
+        while (std::chrono::steady_clock::now() < until)
+        {}
+    }
+
+    void WritePayload(std::string& out, uint64_t seq)
+    {
+        // ts is wall clock time in microseconds so that clients on the same host can compute end-to-end latency
+        const auto ts = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        auto       it = std::back_inserter(out);
+
+        fmt::format_to(it, "{{\"ts\":{},\"seq\":{},\"data\":", ts, seq);
+
+        const size_t count = payloadSize.load(std::memory_order_relaxed);
+
+        switch (shape.load(std::memory_order_relaxed))
+        {
+            case Shape::Scalar:
+                fmt::format_to(it, "{}", (seq % 1000) / 1000.0);
+                break;
+            case Shape::Array:
+                {
+                    out += '[';
+
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        fmt::format_to(it, "{}{}", i ? "," : "", ((seq + i) % 1000) / 1000.0);
+                    }
+
+                    out += ']';
+                    break;
+                }
+            case Shape::Nested:
+                {
+                    out += "{\"items\":[";
+
+                    for (size_t i = 0; i < count; i++)
+                    {
+                        const double v = ((seq + i) % 1000) / 1000.0;
+
+                        fmt::format_to(it,
+                            "{}{{\"id\":{},\"name\":\"item{}\",\"value\":{},\"tags\":[\"a\",\"b\"],\"child\":{{\"x\":{},\"y\":{}}}}}",
+                            i ? "," : "",
+                            i,
+                            i,
+                            v,
+                            i,
+                            1.0 - v);
+                    }
+
+                    out += "]}";
+                    break;
+                }
+        }
+
+        out += '}';
+    }
+}  // namespace
+
+bool synthetic_load_init(quasar_ext_handle handle)
+{
+    extHandle = handle;
+
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        uidMap[sources[i].uid] = i;
+    }
+
+    info("Serving {} topics", sources.size());
+
+    return true;
+}
+
+bool synthetic_load_shutdown(quasar_ext_handle handle)
+{
+    uidMap.clear();
+    extHandle = nullptr;
+
+    return true;
+}
+
+bool synthetic_load_get_data(size_t srcUid, quasar_data_handle hData, char* args)
+{
+    auto it = uidMap.find(srcUid);
+
+    if (it == uidMap.end())
+    {
+        warn("Unknown source {}", srcUid);
+        return false;
+    }
+
+    Spin(costUs.load(std::memory_order_relaxed));
+
+    thread_local std::string buffer;
+
+    buffer.clear();
+    WritePayload(buffer, sequence[it->second].fetch_add(1, std::memory_order_relaxed));
+
+    quasar_set_data_json_hpp(hData, buffer);
+
+    return true;
+}
+
+quasar_settings_t* synthetic_load_create_settings(quasar_ext_handle handle)
+{
+    quasar_settings_t*          settings = quasar_create_settings(handle);
+
+    quasar_selection_options_t* select   = quasar_create_selection_setting();
+    quasar_add_selection_option(select, "Array of numbers", "array");
+    quasar_add_selection_option(select, "Nested objects", "nested");
+    quasar_add_selection_option(select, "Single number", "scalar");
+
+    quasar_add_selection_setting(handle, settings, "Shape", "Payload shape", select);
+    quasar_add_int_setting(handle, settings, "Size", "Payload elements (array and nested shapes)", 1, 65536, 1, 64);
+    quasar_add_int_setting(handle, settings, "Cost", "Simulated get_data cost (microseconds)", 0, 1000000, 1, 0);
+
+    return settings;
+}
+
+void synthetic_load_update(quasar_settings_t* settings)
+{
+    char buf[16] = {};
+
+    if (quasar_get_selection_setting(extHandle, settings, "Shape", buf, sizeof(buf)))
+    {
+        const std::string_view s{buf};
+
+        shape = (s == "nested") ? Shape::Nested : (s == "scalar") ? Shape::Scalar : Shape::Array;
+    }
+
+    payloadSize = quasar_get_uint_setting(extHandle, settings, "Size");
+    costUs      = quasar_get_int_setting(extHandle, settings, "Cost");
+}
+
+quasar_ext_info_fields_t fields = {.version = "1.0",
+    .author                                 = "r52",
+    .description                            = "Generates configurable synthetic data for load testing",
+    .url                                    = "https://github.com/r52/quasar"};
+
+quasar_ext_info_t        info   = {QUASAR_API_VERSION,
+             &fields,
+
+             0,
+             nullptr,
+
+             synthetic_load_init,
+             synthetic_load_shutdown,
+             synthetic_load_get_data,
+             synthetic_load_create_settings,
+             synthetic_load_update};
+
+quasar_ext_info_t*       quasar_ext_load(void)
+{
+    quasar_strcpy(fields.name, sizeof(fields.name), EXT_NAME.data(), EXT_NAME.size());
+    quasar_strcpy(fields.fullname, sizeof(fields.fullname), EXT_FULLNAME.data(), EXT_FULLNAME.size());
+
+    const auto count = (size_t) ReadEnv(TopicsEnv, DefaultTopics, 1, MaxTopics);
+    const auto rate  = ReadEnv(RateEnv, DefaultRate, 1000, 60000000);
+
+    sources.assign(count, quasar_data_source_t{});
+    sequence = std::make_unique<std::atomic<uint64_t>[]>(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        auto name = fmt::format("t{}", i);
+
+        quasar_strcpy(sources[i].name, sizeof(sources[i].name), name.data(), name.size());
+        sources[i].rate = rate;
+    }
+
+    info.numDataSources = sources.size();
+    info.dataSources    = sources.data();
+
+    return &info;
+}
+
+void quasar_ext_destroy(quasar_ext_info_t* info)
+{
+    sources.clear();
+    sequence.reset();
+}
@@ -15,7 +15,7 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
-#include <complex>
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <numeric>
@@ -46,24 +46,15 @@
 #include <mmdeviceapi.h>
 //- WinAPI
 
-#include <kfr/base.hpp>
-#include <kfr/dft.hpp>
-#include <kfr/dsp.hpp>
+#include <dsp.h>
+#include <spectrum.h>
 
 #define WINDOWS_BUG_WORKAROUND 1
 
 constexpr std::string_view EXT_FULLNAME = "Audio Visualization Data";
 constexpr std::string_view EXT_NAME     = "win_audio_viz";
 
-#define CLAMP01(x) kfr::clamp(x, 0.0, 1.0)
-
-template<typename T>
-requires std::numeric_limits<T>::is_integer
-constexpr float normalizeAsFloat(T val)
-{
-    constexpr float imax = 1.0f / std::numeric_limits<T>::max();
-    return val * imax;
-}
+#define CLAMP01(x) std::clamp(x, 0.0, 1.0)
 
 #define qlog(l, ...)                                                          \
     {                                                                         \
@@ -200,24 +191,15 @@ struct Measure
     WInterface<IAudioClient>       m_clBugAudio;   // audio client for dummy silent channel
     WInterface<IAudioRenderClient> m_clBugRender;  // render client for dummy silent channel
 #endif
-    std::wstring                                            m_reqID;       // requested device ID (parsed from options)
-    std::wstring                                            m_devName;     // device friendly name (detected in init)
-    std::array<float, 2>                                    m_kRMS;        // RMS attack/decay filter constants
-    std::array<float, 2>                                    m_kPeak;       // peak attack/decay filter constants
-    std::array<float, 2>                                    m_kFFT;        // FFT attack/decay filter constants
-    std::array<double, MAX_CHANNELS>                        m_rms;         // current RMS levels
-    std::array<double, MAX_CHANNELS>                        m_peak;        // current peak levels
-    std::array<kfr::dft_plan_real_ptr<float>, MAX_CHANNELS> m_fftPlan;     // FFT plans for each channel
-    std::array<std::vector<float>, MAX_CHANNELS>            m_fftIn;       // buffer for each channel's FFT input
-    std::array<std::vector<float>, MAX_CHANNELS>            m_fftOut;      // buffer for each channel's FFT output
-    kfr::univector<float>                                   m_fftKWdw;     // window function coefficients
-    kfr::univector<float>                                   m_fftTmpIn;    // temp FFT processing buffer
-    kfr::univector<std::complex<float>>                     m_fftTmpOutP;  // temp FFT processing buffer
-    size_t                                                  m_fftBufW;     // write index for input ring buffers
-    int                                                     m_fftBufP;     // decremental counter - process FFT at zero
-    std::vector<float>                                      m_bandFreq;    // buffer of band max frequencies
-    std::array<std::vector<float>, MAX_CHANNELS>            m_bandOut;     // buffer of band values
-    std::span<std::byte>                                    m_buffer;      // temp processing buffer
+    std::wstring                                 m_reqID;     // requested device ID (parsed from options)
+    std::wstring                                 m_devName;   // device friendly name (detected in init)
+    std::array<float, 2>                         m_kRMS;      // RMS attack/decay filter constants
+    std::array<float, 2>                         m_kPeak;     // peak attack/decay filter constants
+    std::array<double, MAX_CHANNELS>             m_rms;       // current RMS levels
+    std::array<double, MAX_CHANNELS>             m_peak;      // current peak levels
+    std::array<std::vector<float>, MAX_CHANNELS> m_blockIn;   // current buffer, demuxed into normalized samples per channel
+    DSP::SpectrumAnalyzer                        m_spectrum;  // FFT and band pipeline
+    std::span<std::byte>                         m_buffer;    // temp processing buffer
 
     Measure() :
         m_format(FMT_INVALID),
@@ -240,12 +222,6 @@ struct Measure
 #endif
         m_reqID{},
         m_devName{},
-        m_fftKWdw{},
-        m_fftTmpIn{},
-        m_fftTmpOutP{},
-        m_fftBufW(0),
-        m_fftBufP(0),
-        m_bandFreq{},
         m_buffer{}
     {
         m_envRMS[0]  = 300;
@@ -258,8 +234,6 @@ struct Measure
         m_kRMS[1]    = 0.0f;
         m_kPeak[0]   = 0.0f;
         m_kPeak[1]   = 0.0f;
-        m_kFFT[0]    = 0.0f;
-        m_kFFT[1]    = 0.0f;
 
         for (auto&& iChan : std::views::iota((size_t) 0, (size_t) Measure::MAX_CHANNELS))
         {
@@ -272,6 +246,7 @@ struct Measure
 
     HRESULT DeviceInit();
     void    DeviceRelease();
+    void    UpdateFilters();
 };
 
 const CLSID          CLSID_MMDeviceEnumerator = __uuidof(MMDeviceEnumerator);
@@ -306,10 +281,7 @@ namespace
     quasar_ext_handle                                         extHandle = nullptr;
     std::array<std::vector<double>, Measure::Type::NUM_TYPES> output;
 
-    float                                                     fftScalar, bandScalar, df = 0;
-
     bool                                                      last_data_is_not_zero = true;
-    kfr::univector<kfr::u8>                                   temp;
     std::shared_mutex                                         mutex;
 }  // namespace
 
@@ -407,53 +379,17 @@ HRESULT Measure::DeviceInit()
     output[Measure::TYPE_RMS].resize(m_wfx->nChannels, 0.0);
     output[Measure::TYPE_PEAK].resize(m_wfx->nChannels, 0.0);
 
-    // setup FFT buffers
+    // output buffers for the spectrum analyzer, which is set up once the channel count is final
     if (m_fftSize)
     {
-        // output buffers
         output[Measure::TYPE_FFTFREQ].resize((m_fftSize / 2) + 1, 0.0);
         output[Measure::TYPE_FFT].resize((m_fftSize / 2) + 1, 0.0);
-
-        fftScalar = (float) (1.0 / kfr::sqrt(m->m_fftSize));
-
-        for (auto&& iChan : std::views::iota((size_t) 0, (size_t) m->m_wfx->nChannels))
-        {
-            m_fftPlan[iChan].reset(new kfr::dft_plan_real<float>(m_fftSize));
-            m_fftIn[iChan].resize(m_fftSize, 0.0f);
-            m_fftOut[iChan].resize(m_fftSize, 0.0f);
-            temp.resize(m_fftPlan[iChan]->temp_size);
-        }
-
-        m_fftTmpIn.resize(m_fftSize, 0.0f);
-        m_fftTmpOutP.resize(m_fftSize, {0.0f, 0.0f});
-        m_fftBufP = m_fftSize - m_fftOverlap;
-
-        m_fftKWdw = kfr::window_hann(m_fftSize);
     }
 
-    // calculate band frequencies and allocate band output buffers
     if (m_nBands)
     {
-        // output buffers
         output[Measure::TYPE_BANDFREQ].resize(m_nBands, 0.0);
         output[Measure::TYPE_BAND].resize(m_nBands, 0.0);
-
-        bandScalar = 2.0f / (float) m->m_wfx->nSamplesPerSec;
-        df         = (float) m->m_wfx->nSamplesPerSec / m->m_fftSize;
-
-        m_bandFreq.resize(m_nBands, 0.0f);
-        const double step = (kfr::log(m_freqMax / m_freqMin) / m_nBands) / kfr::log(2.0);
-        m_bandFreq[0]     = (float) (m_freqMin * kfr::pow(2.0, step / 2.0));
-
-        for (auto&& iBand : std::views::iota((size_t) 1, m->m_nBands))
-        {
-            m_bandFreq[iBand] = (float) (m_bandFreq[iBand - 1] * kfr::pow(2.0, step));
-        }
-
-        for (auto&& iChan : std::views::iota((size_t) 0, (size_t) m->m_wfx->nChannels))
-        {
-            m_bandOut[iChan].resize(m_nBands, 0.0f);
-        }
     }
 
 #if (WINDOWS_BUG_WORKAROUND)
@@ -537,6 +473,18 @@ HRESULT Measure::DeviceInit()
     bufsize  = nMaxFrames * m_wfx->nBlockAlign * sizeof(uint8_t);
     m_buffer = std::span{new std::byte[bufsize](), bufsize};
 
+    // setup FFT and band buffers
+    m_spectrum.Configure({.sampleRate = (double) m_wfx->nSamplesPerSec,
+        .channels                     = std::min<size_t>(m_wfx->nChannels, MAX_CHANNELS),
+        .fftSize                      = m_fftSize,
+        .fftOverlap                   = m_fftOverlap,
+        .envFFT                       = m_envFFT,
+        .nBands                       = m_nBands,
+        .freqMin                      = m_freqMin,
+        .freqMax                      = m_freqMax});
+
+    UpdateFilters();
+
     return S_OK;
 
 Exit:
@@ -572,11 +520,10 @@ void Measure::DeviceRelease()
     m_clAudio.reset();
     m_dev.reset();
 
+    m_spectrum.Configure({});
+
     for (auto&& iChan : std::views::iota((size_t) 0, (size_t) Measure::MAX_CHANNELS))
     {
-        if (m_fftPlan[iChan])
-            m_fftPlan[iChan].reset();
-
         m_rms[iChan]  = 0.0;
         m_peak[iChan] = 0.0;
     }
@@ -590,6 +537,17 @@ void Measure::DeviceRelease()
     m_format = FMT_INVALID;
 }
 
+void Measure::UpdateFilters()
+{
+    const double freq = m_wfx->nSamplesPerSec;
+    m_kRMS[0]         = DSP::EnvelopeCoefficient(freq, m_envRMS[0]);
+    m_kRMS[1]         = DSP::EnvelopeCoefficient(freq, m_envRMS[1]);
+    m_kPeak[0]        = DSP::EnvelopeCoefficient(freq, m_envPeak[0]);
+    m_kPeak[1]        = DSP::EnvelopeCoefficient(freq, m_envPeak[1]);
+
+    m_spectrum.SetEnvelope(m_envFFT);
+}
+
 bool win_audio_viz_init(quasar_ext_handle handle)
 {
     assert(m.get());
@@ -636,7 +594,7 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
                 {
                     for (auto&& i : std::views::iota((size_t) 0, (m->m_fftSize / 2) + 1))
                     {
-                        output[Measure::TYPE_FFTFREQ][i] = (double) i * m->m_wfx->nSamplesPerSec / m->m_fftSize;
+                        output[Measure::TYPE_FFTFREQ][i] = m->m_spectrum.BinFrequency(i);
                     }
 
                     quasar_set_data_double_vector(hData, output[Measure::TYPE_FFTFREQ]);
@@ -651,7 +609,7 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
                 {
                     for (auto&& i : std::views::iota((size_t) 0, m->m_nBands))
                     {
-                        output[Measure::TYPE_BANDFREQ][i] = m->m_bandFreq[i];
+                        output[Measure::TYPE_BANDFREQ][i] = m->m_spectrum.BandFrequencies()[i];
                     }
 
                     quasar_set_data_double_vector(hData, output[Measure::TYPE_BANDFREQ]);
@@ -782,6 +740,27 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
             // release the buffer
             m->m_clCapture->ReleaseBuffer(nFrames);
 
+            // demux streams
+            const size_t                                    nChannels = std::min<size_t>(m->m_wfx->nChannels, Measure::MAX_CHANNELS);
+            std::array<float*, Measure::MAX_CHANNELS>       outs{};
+            std::array<const float*, Measure::MAX_CHANNELS> ins{};
+
+            for (auto&& iChan : std::views::iota((size_t) 0, nChannels))
+            {
+                m->m_blockIn[iChan].resize(nFrames);
+                outs[iChan] = m->m_blockIn[iChan].data();
+                ins[iChan]  = outs[iChan];
+            }
+
+            if (m->m_format == Measure::FMT_PCM_F32)
+            {
+                DSP::Deinterleave((const float*) m->m_buffer.data(), nFrames, nChannels, outs.data());
+            }
+            else
+            {
+                DSP::Deinterleave((const INT16*) m->m_buffer.data(), nFrames, nChannels, outs.data());
+            }
+
             if (type == Measure::TYPE_RMS or type == Measure::TYPE_PEAK)
             {
                 // measure RMS and peak levels
@@ -794,25 +773,12 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
                     peak[iChan] = (float) m->m_peak[iChan];
                 }
 
-                float* sF32 = (float*) m->m_buffer.data();
-                INT16* sI16 = (INT16*) m->m_buffer.data();
+                DSP::TrackLevels(ins.data(), nFrames, rms, peak, nChannels, m->m_kRMS, m->m_kPeak);
 
-                for ([[maybe_unused]] auto&& _ : std::views::iota((size_t) 0, (size_t) nFrames))
+                if (nChannels == 1)
                 {
-                    for (auto&& iChan : std::views::iota((size_t) 0, (size_t) m->m_wfx->nChannels))
-                    {
-                        float x     = m->m_format == Measure::FMT_PCM_F32 ? *sF32++ : normalizeAsFloat(*sI16++);
-                        float sqrX  = kfr::sqr(x);
-                        float absX  = kfr::abs(x);
-                        rms[iChan]  = sqrX + m->m_kRMS[(sqrX < rms[iChan])] * (rms[iChan] - sqrX);
-                        peak[iChan] = absX + m->m_kPeak[(absX < peak[iChan])] * (peak[iChan] - absX);
-
-                        if (m->m_wfx->nChannels == 1)
-                        {
-                            rms[1]  = rms[0];
-                            peak[1] = peak[0];
-                        }
-                    }
+                    rms[1]  = rms[0];
+                    peak[1] = peak[0];
                 }
 
                 for (auto&& iChan : std::views::iota((size_t) 0, (size_t) Measure::MAX_CHANNELS))
@@ -825,91 +791,10 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
             // process FFTs (optional)
             if (m->m_fftSize)
             {
-                float* sF32 = (float*) m->m_buffer.data();
-                INT16* sI16 = (INT16*) m->m_buffer.data();
-
-                for ([[maybe_unused]] auto&& _ : std::views::iota((size_t) 0, (size_t) nFrames))
-                {
-                    // fill ring buffers (demux streams)
-                    for (auto&& iChan : std::views::iota((size_t) 0, (size_t) m->m_wfx->nChannels))
-                    {
-                        (m->m_fftIn[iChan])[m->m_fftBufW] = m->m_format == Measure::FMT_PCM_F32 ? *sF32++ : normalizeAsFloat(*sI16++);
-                    }
-
-                    m->m_fftBufW = (m->m_fftBufW + 1) % m->m_fftSize;
-
-                    // if overlap limit reached, process FFTs for each channel
-                    if (!--m->m_fftBufP)
-                    {
-                        for (auto&& iChan : std::views::iota((size_t) 0, (size_t) m->m_wfx->nChannels))
-                        {
-                            if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT))
-                            {
-                                // copy from the ring buffer to temp space
-                                std::memcpy(m->m_fftTmpIn.data(), m->m_fftIn[iChan].data() + m->m_fftBufW, (m->m_fftSize - m->m_fftBufW) * sizeof(float));
-                                if (m->m_fftSize - m->m_fftBufW < m->m_fftTmpIn.size())
-                                {
-                                    std::memcpy(m->m_fftTmpIn.data() + (m->m_fftSize - m->m_fftBufW), m->m_fftIn[iChan].data(), m->m_fftBufW * sizeof(float));
-                                }
-
-                                // apply the windowing function
-                                m->m_fftTmpIn = m->m_fftTmpIn * m->m_fftKWdw;
-
-                                m->m_fftPlan[iChan]->execute(m->m_fftTmpOutP, m->m_fftTmpIn, temp);
-                            }
-                            else
-                            {
-                                std::fill(m->m_fftTmpOutP.begin(), m->m_fftTmpOutP.end(), std::complex{0.0f, 0.0f});
-                            }
-
-                            auto scaled = kfr::cabssqr(m->m_fftTmpOutP) * fftScalar;
-
-                            // filter the bin levels as with peak measurements
-                            for (auto&& bin : std::views::iota((size_t) 0, m->m_fftSize))
-                            {
-                                float x0                  = (m->m_fftOut[iChan])[bin];
-                                float x1                  = kfr::get_element(scaled, {bin});
-                                x0                        = x1 + m->m_kFFT[(x1 < x0)] * (x0 - x1);
-                                (m->m_fftOut[iChan])[bin] = x0;
-                            }
-                        }
-
-                        m->m_fftBufP = m->m_fftSize - m->m_fftOverlap;
-                    }
-                }
+                m->m_spectrum.Process(ins.data(), nFrames, (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0);
 
                 // integrate FFT results into log-scale frequency bands
-                if (m->m_nBands)
-                {
-                    for (auto&& channel : std::views::iota((size_t) 0, (size_t) m->m_wfx->nChannels))
-                    {
-                        std::fill(m->m_bandOut[channel].begin(), m->m_bandOut[channel].end(), 0.0f);
-                        size_t iBin  = 0;
-                        size_t iBand = 0;
-                        float  f0    = 0.0f;
-
-                        while (iBin <= (m->m_fftSize / 2) and iBand < m->m_nBands)
-                        {
-                            float  fLin1 = ((float) iBin + 0.5f) * df;
-                            float  fLog1 = m->m_bandFreq[iBand];
-                            float  x     = (m->m_fftOut[channel])[iBin];
-                            float& y     = (m->m_bandOut[channel])[iBand];
-
-                            if (fLin1 <= fLog1)
-                            {
-                                y += (fLin1 - f0) * x * bandScalar;
-                                f0 = fLin1;
-                                iBin += 1;
-                            }
-                            else
-                            {
-                                y += (fLog1 - f0) * x * bandScalar;
-                                f0 = fLog1;
-                                iBand += 1;
-                            }
-                        }
-                    }
-                }
+                m->m_spectrum.IntegrateBands();
             }
         }
         // detect device disconnection
@@ -953,7 +838,7 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
             {
                 for (auto&& i : std::views::iota((size_t) 0, (size_t) m->m_wfx->nChannels))
                 {
-                    output[Measure::TYPE_RMS][i] = CLAMP01(kfr::sqrt(m->m_rms[i]) * m->m_gainRMS);
+                    output[Measure::TYPE_RMS][i] = CLAMP01(std::sqrt(m->m_rms[i]) * m->m_gainRMS);
                 }
 
                 quasar_set_data_double_vector(hData, output[Measure::TYPE_RMS]);
@@ -977,23 +862,7 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
             {
                 if (m->m_clCapture and m->m_fftSize)
                 {
-                    double x;
-
-                    for (auto&& i : std::views::iota((size_t) 0, (m->m_fftSize / 2) + 1))
-                    {
-                        if (m->m_wfx->nChannels >= 2)
-                        {
-                            x = (m->m_fftOut[0][i] + m->m_fftOut[1][i]) * 0.5;
-                        }
-                        else
-                        {
-                            x = m->m_fftOut[0][i];
-                        }
-
-                        x                            = CLAMP01(x);
-                        x                            = kfr::max(0.0, m->m_sensitivity * kfr::log10(x) + 1.0);
-                        output[Measure::TYPE_FFT][i] = x;
-                    }
+                    m->m_spectrum.SpectrumLevels(m->m_sensitivity, output[Measure::TYPE_FFT].data());
 
                     double acc = std::reduce(output[Measure::TYPE_FFT].begin(), output[Measure::TYPE_FFT].end(), 0.0);
 
@@ -1016,23 +885,7 @@ bool win_audio_viz_get_data(size_t srcUid, quasar_data_handle hData, char* args)
             {
                 if (m->m_clCapture and m->m_nBands)
                 {
-                    double x;
-
-                    for (auto&& i : std::views::iota((size_t) 0, m->m_nBands))
-                    {
-                        if (m->m_wfx->nChannels >= 2)
-                        {
-                            x = (m->m_bandOut[0][i] + m->m_bandOut[1][i]) * 0.5;
-                        }
-                        else
-                        {
-                            x = m->m_bandOut[0][i];
-                        }
-
-                        x                             = CLAMP01(x);
-                        x                             = kfr::max(0.0, m->m_sensitivity * kfr::log10(x) + 1.0);
-                        output[Measure::TYPE_BAND][i] = x;
-                    }
+                    m->m_spectrum.BandLevels(m->m_sensitivity, output[Measure::TYPE_BAND].data());
 
                     double acc = std::reduce(output[Measure::TYPE_BAND].begin(), output[Measure::TYPE_BAND].end(), 0.0);
 
@@ -1180,9 +1033,10 @@ void win_audio_viz_update_settings(quasar_settings_t* settings)
         {
             warn("Invalid FFTOverlap {}: must be an integer between 0 and FFTSize({}).", overlap, m->m_fftSize);
         }
-        else
+        else if (overlap != m->m_fftOverlap)
         {
             m->m_fftOverlap = overlap;
+            needs_reinit    = true;
         }
     }
 
@@ -1216,18 +1070,12 @@ void win_audio_viz_update_settings(quasar_settings_t* settings)
     m->m_sensitivity = 10.0 / std::max(1.0, quasar_get_double_setting(extHandle, settings, "Sensitivity"));
 
     // regenerate filter constants
-    if (m->m_wfx)
     {
-        const double freq = m->m_wfx->nSamplesPerSec;
-        m->m_kRMS[0]      = (float) kfr::exp(kfr::log10(0.01) / (freq * (double) m->m_envRMS[0] * 0.001));
-        m->m_kRMS[1]      = (float) kfr::exp(kfr::log10(0.01) / (freq * (double) m->m_envRMS[1] * 0.001));
-        m->m_kPeak[0]     = (float) kfr::exp(kfr::log10(0.01) / (freq * (double) m->m_envPeak[0] * 0.001));
-        m->m_kPeak[1]     = (float) kfr::exp(kfr::log10(0.01) / (freq * (double) m->m_envPeak[1] * 0.001));
+        std::unique_lock lk(mutex);
 
-        if (m->m_fftSize)
+        if (m->m_wfx)
         {
-            m->m_kFFT[0] = (float) kfr::exp(kfr::log10(0.01) / (freq / (m->m_fftSize - m->m_fftOverlap) * (double) m->m_envFFT[0] * 0.001));
-            m->m_kFFT[1] = (float) kfr::exp(kfr::log10(0.01) / (freq / (m->m_fftSize - m->m_fftOverlap) * (double) m->m_envFFT[1] * 0.001));
+            m->UpdateFilters();
         }
     }
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "api/extension_types.h"
+
+#include "common/settings.h"
+
+#include "exthost/protocol.h"
+#include "exthost/shmring.h"
+
+using SettingsVariantVector = std::vector<Settings::SettingsVariant>;
+
+/*! State of the extension loaded by this host process.
+    A pointer to the single instance is used as the quasar_ext_handle passed to the extension.
+*/
+struct HostContext
+{
+    //! Returns the single host context
+    static HostContext& Instance();
+
+    /*! Sends a request to Quasar and waits for its reply
+        \param[in]  type    Message type
+        \param[in]  payload Message payload
+        \return Reply payload if successful, empty if Quasar went away
+    */
+    std::optional<std::string> Request(ExtHost::MessageType type, std::string_view payload);
+
+    /*! Sends a message to Quasar that expects no reply
+        \param[in]  type    Message type
+        \param[in]  seq     Sequence number
+        \param[in]  payload Message payload
+    */
+    void                       Send(ExtHost::MessageType type, uint64_t seq, std::string_view payload);
+
+    //! Fulfills an outstanding Request()
+    void                       Fulfill(uint64_t seq, std::string&& payload);
+
+    //! Fails all outstanding Request() calls
+    void                       Disconnect();
+
+    using PendingMapType = std::unordered_map<uint64_t, std::promise<std::optional<std::string>>>;
+
+    std::string                name;     //!< Extension identifier
+    quasar_ext_info_t*         info{};   //!< Extension info data
+    SettingsVariantVector      settings;  //!< Extension settings
+    ExtHost::ShmRing           ring;     //!< Data plane
+    std::string                buffer;   //!< Serialization buffer for get_data results
+
+    int                        sock{ExtHost::HostSocketFd};
+    std::mutex                 sendMutex;
+    uint64_t                   nextSeq{};
+
+    std::mutex                 pendingMutex;
+    PendingMapType             pending;
+    bool                       connected{true};
+};
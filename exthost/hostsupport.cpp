@@ -0,0 +1,362 @@
+/*! \file
+    \brief Extension support functions for extensions running inside quasar-exthost.
+    Calls that need Quasar are forwarded over the control socket.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "hostcontext.h"
+
+#include "api/extension_support.h"
+
+#include "extension_support.hpp"
+
+#include "extension/extension_support_internal.h"
+
+#include <fmt/core.h>
+#include <jsoncons/json.hpp>
+
+#define EXTKEY(key) fmt::format("{}/{}", ctx->name, key)
+
+namespace
+{
+    //! Finds a setting of type T by its full label
+    template<typename T>
+    T* find_setting(quasar_ext_handle handle, quasar_settings_t* settings, std::string_view name)
+    {
+        SettingsVariantVector* container = reinterpret_cast<SettingsVariantVector*>(settings);
+        HostContext*           ctx       = static_cast<HostContext*>(handle);
+
+        if (!container or !ctx)
+        {
+            return nullptr;
+        }
+
+        auto cmp    = EXTKEY(name);
+        auto result = std::find_if(container->begin(), container->end(), [&](Settings::SettingsVariant& entry) {
+            return std::holds_alternative<T>(entry) and std::get<T>(entry).GetLabel() == cmp;
+        });
+
+        return (result != container->end()) ? &std::get<T>(*result) : nullptr;
+    }
+
+    //! Copies a string value into a caller supplied buffer
+    bool copy_out(const std::string& val, char* buf, size_t size)
+    {
+        if (!buf or size < val.length() + 1)
+        {
+            quasar_log(QUASAR_LOG_WARNING, "Buffer size for retrieving value too small!");
+            return false;
+        }
+
+        std::memcpy(buf, val.data(), val.length());
+        buf[val.length()] = 0;
+
+        return true;
+    }
+
+    //! Forwards quasar_set_storage_*() to Quasar
+    void set_storage(quasar_ext_handle handle, const char* name, const char* type, jsoncons::json val)
+    {
+        HostContext* ctx = static_cast<HostContext*>(handle);
+
+        if (ctx and name)
+        {
+            jsoncons::json req{
+                jsoncons::json_object_arg,
+                {{"name", name}, {"type", type}, {"val", std::move(val)}}
+            };
+
+            std::string msg;
+            req.dump(msg);
+
+            ctx->Send(ExtHost::MessageType::SetStorage, 0, msg);
+        }
+    }
+
+    //! Forwards quasar_get_storage_*() to Quasar
+    std::optional<jsoncons::json> get_storage(quasar_ext_handle handle, const char* name, const char* type)
+    {
+        HostContext* ctx = static_cast<HostContext*>(handle);
+
+        if (!ctx or !name)
+        {
+            return std::nullopt;
+        }
+
+        jsoncons::json req{
+            jsoncons::json_object_arg,
+            {{"name", name}, {"type", type}}
+        };
+
+        std::string msg;
+        req.dump(msg);
+
+        auto result = ctx->Request(ExtHost::MessageType::GetStorage, msg);
+
+        if (!result)
+        {
+            return std::nullopt;
+        }
+
+        auto val = jsoncons::json::parse(*result);
+
+        if (val.is_null())
+        {
+            return std::nullopt;
+        }
+
+        return val;
+    }
+}  // namespace
+
+void quasar_log(quasar_log_level_t level, const char* msg)
+{
+    auto& ctx = HostContext::Instance();
+
+    if (msg)
+    {
+        std::string payload(1, (char) level);
+        payload.append(msg);
+
+        ctx.Send(ExtHost::MessageType::Log, 0, payload);
+    }
+}
+
+quasar_settings_t* quasar_create_settings(quasar_ext_handle handle)
+{
+    HostContext* ctx = static_cast<HostContext*>(handle);
+
+    if (ctx)
+    {
+        return (quasar_settings_t*) &ctx->settings;
+    }
+
+    return nullptr;
+}
+
+quasar_settings_t*
+quasar_add_int_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, const char* description, int min, int max, int step, int dflt)
+{
+    SettingsVariantVector* container = reinterpret_cast<SettingsVariantVector*>(settings);
+    HostContext*           ctx       = static_cast<HostContext*>(handle);
+
+    if (container and ctx)
+    {
+        container->push_back(Settings::Setting<int>{EXTKEY(name), description, dflt, min, max, step});
+        return settings;
+    }
+
+    return nullptr;
+}
+
+quasar_settings_t* quasar_add_bool_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, const char* description, bool dflt)
+{
+    SettingsVariantVector* container = reinterpret_cast<SettingsVariantVector*>(settings);
+    HostContext*           ctx       = static_cast<HostContext*>(handle);
+
+    if (container and ctx)
+    {
+        container->push_back(Settings::Setting<bool>{EXTKEY(name), description, dflt});
+        return settings;
+    }
+
+    return nullptr;
+}
+
+quasar_settings_t* quasar_add_double_setting(quasar_ext_handle handle,
+    quasar_settings_t*                                         settings,
+    const char*                                                name,
+    const char*                                                description,
+    double                                                     min,
+    double                                                     max,
+    double                                                     step,
+    double                                                     dflt)
+{
+    SettingsVariantVector* container = reinterpret_cast<SettingsVariantVector*>(settings);
+    HostContext*           ctx       = static_cast<HostContext*>(handle);
+
+    if (container and ctx)
+    {
+        container->push_back(Settings::Setting<double>{EXTKEY(name), description, dflt, min, max, step});
+        return settings;
+    }
+
+    return nullptr;
+}
+
+quasar_settings_t*
+quasar_add_string_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, const char* description, const char* dflt, bool password)
+{
+    SettingsVariantVector* container = reinterpret_cast<SettingsVariantVector*>(settings);
+    HostContext*           ctx       = static_cast<HostContext*>(handle);
+
+    if (container and ctx)
+    {
+        container->push_back(Settings::Setting<std::string>{EXTKEY(name), description, dflt, password});
+        return settings;
+    }
+
+    return nullptr;
+}
+
+quasar_settings_t* quasar_add_selection_setting(quasar_ext_handle handle,
+    quasar_settings_t*                                            settings,
+    const char*                                                   name,
+    const char*                                                   description,
+    quasar_selection_options_t*                                   select)
+{
+    SettingsVariantVector*  set_con = reinterpret_cast<SettingsVariantVector*>(settings);
+    SelectionOptionsVector* sel_con = reinterpret_cast<SelectionOptionsVector*>(select);
+    HostContext*            ctx     = static_cast<HostContext*>(handle);
+
+    if (set_con and sel_con and ctx)
+    {
+        if (sel_con->empty())
+        {
+            delete sel_con;
+            return nullptr;
+        }
+
+        set_con->push_back(Settings::SelectionSetting<std::string>{EXTKEY(name), description, sel_con->at(0).first, *sel_con});
+        delete sel_con;
+
+        return settings;
+    }
+
+    return nullptr;
+}
+
+intmax_t quasar_get_int_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    auto w = find_setting<Settings::Setting<int>>(handle, settings, name);
+    return w ? w->GetValue() : intmax_t();
+}
+
+uintmax_t quasar_get_uint_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    auto w = find_setting<Settings::Setting<int>>(handle, settings, name);
+    return w ? w->GetValue() : uintmax_t();
+}
+
+bool quasar_get_bool_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    auto w = find_setting<Settings::Setting<bool>>(handle, settings, name);
+    return w ? w->GetValue() : false;
+}
+
+double quasar_get_double_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
+{
+    auto w = find_setting<Settings::Setting<double>>(handle, settings, name);
+    return w ? w->GetValue() : 0.0;
+}
+
+bool quasar_get_string_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, char* buf, size_t size)
+{
+    auto w = find_setting<Settings::Setting<std::string>>(handle, settings, name);
+    return w ? copy_out(w->GetValue(), buf, size) : false;
+}
+
+bool quasar_get_selection_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, char* buf, size_t size)
+{
+    auto w = find_setting<Settings::SelectionSetting<std::string>>(handle, settings, name);
+    return w ? copy_out(w->GetValue(), buf, size) : false;
+}
+
+std::string_view quasar_get_string_setting_hpp(quasar_ext_handle handle, quasar_settings_t* settings, std::string_view name)
+{
+    auto w = find_setting<Settings::Setting<std::string>>(handle, settings, name);
+    return w ? std::string_view{w->GetValue()} : std::string_view();
+}
+
+std::string_view quasar_get_selection_setting_hpp(quasar_ext_handle handle, quasar_settings_t* settings, std::string_view name)
+{
+    auto w = find_setting<Settings::SelectionSetting<std::string>>(handle, settings, name);
+    return w ? std::string_view{w->GetValue()} : std::string_view();
+}
+
+void quasar_signal_data_ready(quasar_ext_handle handle, const char* source)
+{
+    HostContext* ctx = static_cast<HostContext*>(handle);
+
+    if (ctx and source)
+    {
+        ctx->Send(ExtHost::MessageType::SignalDataReady, 0, source);
+    }
+}
+
+void quasar_signal_wait_processed(quasar_ext_handle handle, const char* source)
+{
+    HostContext* ctx = static_cast<HostContext*>(handle);
+
+    if (ctx and source)
+    {
+        ctx->Request(ExtHost::MessageType::WaitProcessed, source);
+    }
+}
+
+void quasar_set_storage_string(quasar_ext_handle handle, const char* name, const char* data)
+{
+    set_storage(handle, name, "string", data ? jsoncons::json(data) : jsoncons::json(""));
+}
+
+void quasar_set_storage_int(quasar_ext_handle handle, const char* name, int data)
+{
+    set_storage(handle, name, "int", data);
+}
+
+void quasar_set_storage_double(quasar_ext_handle handle, const char* name, double data)
+{
+    set_storage(handle, name, "double", data);
+}
+
+void quasar_set_storage_bool(quasar_ext_handle handle, const char* name, bool data)
+{
+    set_storage(handle, name, "bool", data);
+}
+
+bool quasar_get_storage_string(quasar_ext_handle handle, const char* name, char* buf, size_t size)
+{
+    auto val = get_storage(handle, name, "string");
+    return val ? copy_out(val->as<std::string>(), buf, size) : false;
+}
+
+bool quasar_get_storage_int(quasar_ext_handle handle, const char* name, int* buf)
+{
+    auto val = get_storage(handle, name, "int");
+
+    if (val and buf)
+    {
+        *buf = val->as<int>();
+        return true;
+    }
+
+    return false;
+}
+
+bool quasar_get_storage_double(quasar_ext_handle handle, const char* name, double* buf)
+{
+    auto val = get_storage(handle, name, "double");
+
+    if (val and buf)
+    {
+        *buf = val->as<double>();
+        return true;
+    }
+
+    return false;
+}
+
+bool quasar_get_storage_bool(quasar_ext_handle handle, const char* name, bool* buf)
+{
+    auto val = get_storage(handle, name, "bool");
+
+    if (val and buf)
+    {
+        *buf = val->as<bool>();
+        return true;
+    }
+
+    return false;
+}
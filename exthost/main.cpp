@@ -0,0 +1,534 @@
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hostcontext.h"
+
+#include "api/extension_api.h"
+
+#include "extension/extension_support_internal.h"
+
+#include <jsoncons/json.hpp>
+
+#include <dlfcn.h>
+#include <sched.h>
+#include <sys/resource.h>
+
+using namespace ExtHost;
+
+namespace
+{
+    using extension_load    = std::add_pointer_t<quasar_ext_info_t*(void)>;
+    using extension_destroy = std::add_pointer_t<void(quasar_ext_info_t*)>;
+
+    //! A request from Quasar waiting to be executed
+    struct Task
+    {
+        MessageHeader header;
+        std::string   payload;
+    };
+
+    std::mutex              taskMutex;
+    std::condition_variable taskCv;
+    std::deque<Task>        tasks;
+    bool                    closing  = false;
+    bool                    shutdown = false;  // quasar_ext_info_t.shutdown was called
+
+    struct Options
+    {
+        std::string shm;
+        std::string cpus;
+        int         nice     = 0;
+        long        memlimit = 0;  // MiB
+        std::string libpath;
+    };
+
+    bool parse_args(int argc, char* argv[], Options& opts)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg{argv[i]};
+
+            if (i + 1 < argc and arg == "--shm")
+            {
+                opts.shm = argv[++i];
+            }
+            else if (i + 1 < argc and arg == "--cpus")
+            {
+                opts.cpus = argv[++i];
+            }
+            else if (i + 1 < argc and arg == "--nice")
+            {
+                opts.nice = std::atoi(argv[++i]);
+            }
+            else if (i + 1 < argc and arg == "--memlimit")
+            {
+                opts.memlimit = std::atol(argv[++i]);
+            }
+            else
+            {
+                opts.libpath = arg;
+            }
+        }
+
+        return !opts.shm.empty() and !opts.libpath.empty();
+    }
+
+    //! Applies the resource limits configured for this extension
+    void apply_limits(const Options& opts)
+    {
+        if (opts.memlimit > 0)
+        {
+            rlimit lim{.rlim_cur = (rlim_t) opts.memlimit * 1024 * 1024, .rlim_max = (rlim_t) opts.memlimit * 1024 * 1024};
+
+            if (setrlimit(RLIMIT_AS, &lim) != 0)
+            {
+                std::fprintf(stderr, "quasar-exthost: setrlimit() failed: %s\n", std::strerror(errno));
+            }
+        }
+
+        if (opts.nice and setpriority(PRIO_PROCESS, 0, opts.nice) != 0)
+        {
+            std::fprintf(stderr, "quasar-exthost: setpriority() failed: %s\n", std::strerror(errno));
+        }
+
+        if (!opts.cpus.empty())
+        {
+            // list of cpus and ranges, i.e. "0,2-3"
+            cpu_set_t set;
+            CPU_ZERO(&set);
+
+            size_t pos = 0;
+
+            while (pos < opts.cpus.size())
+            {
+                auto end   = opts.cpus.find(',', pos);
+                auto token = opts.cpus.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+                auto dash  = token.find('-');
+
+                int  first = std::atoi(token.c_str());
+                int  last  = (dash == std::string::npos) ? first : std::atoi(token.c_str() + dash + 1);
+
+                for (int c = first; c <= last and c < CPU_SETSIZE; c++)
+                {
+                    CPU_SET(c, &set);
+                }
+
+                pos = (end == std::string::npos) ? opts.cpus.size() : end + 1;
+            }
+
+            if (sched_setaffinity(0, sizeof(set), &set) != 0)
+            {
+                std::fprintf(stderr, "quasar-exthost: sched_setaffinity() failed: %s\n", std::strerror(errno));
+            }
+        }
+    }
+
+    //! Builds the Hello message describing the loaded extension
+    std::string craft_hello(HostContext& ctx)
+    {
+        auto           info = ctx.info;
+
+        jsoncons::json hello{jsoncons::json_object_arg};
+        jsoncons::json fields{jsoncons::json_object_arg};
+
+        fields["name"]        = info->fields->name;
+        fields["fullname"]    = info->fields->fullname;
+        fields["version"]     = info->fields->version;
+        fields["author"]      = info->fields->author;
+        fields["description"] = info->fields->description;
+        fields["url"]         = info->fields->url;
+
+        hello["fields"]       = std::move(fields);
+        jsoncons::json sources{jsoncons::json_array_arg};
+
+        for (size_t i = 0; i < info->numDataSources; i++)
+        {
+            auto& src = info->dataSources[i];
+
+            sources.push_back(jsoncons::json{
+                jsoncons::json_object_arg,
+                {{"name", src.name}, {"rate", src.rate}, {"validtime", src.validtime}}
+            });
+        }
+
+        hello["sources"] = std::move(sources);
+        hello["update"]  = (info->update != nullptr);
+
+        if (info->create_settings)
+        {
+            jsoncons::json defs{jsoncons::json_array_arg};
+
+            const auto     prefix = ctx.name + "/";
+
+            for (auto&& def : ctx.settings)
+            {
+                jsoncons::json setting(jsoncons::json_object_arg);
+
+                std::visit(
+                    [&](auto&& arg) {
+                        using T         = std::decay_t<decltype(arg)>;
+
+                        setting["name"] = arg.GetLabel().substr(prefix.size());
+                        setting["desc"] = arg.GetDescription();
+
+                        if constexpr (std::is_same_v<T, Settings::Setting<int>> or std::is_same_v<T, Settings::Setting<double>>)
+                        {
+                            setting["type"]       = std::is_same_v<T, Settings::Setting<int>> ? "int" : "double";
+
+                            auto [min, max, step] = arg.GetMinMaxStep();
+
+                            setting["min"]        = min;
+                            setting["max"]        = max;
+                            setting["step"]       = step;
+                            setting["def"]        = arg.GetDefault();
+                        }
+                        else if constexpr (std::is_same_v<T, Settings::Setting<bool>>)
+                        {
+                            setting["type"] = "bool";
+                            setting["def"]  = arg.GetDefault();
+                        }
+                        else if constexpr (std::is_same_v<T, Settings::Setting<std::string>>)
+                        {
+                            setting["type"]     = "string";
+                            setting["def"]      = arg.GetDefault();
+                            setting["password"] = arg.GetIsPassword();
+                        }
+                        else if constexpr (std::is_same_v<T, Settings::SelectionSetting<std::string>>)
+                        {
+                            setting["type"] = "select";
+                            setting["list"] = jsoncons::json{jsoncons::json_array_arg};
+
+                            for (auto& [value, name] : arg.GetOptions())
+                            {
+                                setting["list"].push_back(jsoncons::json{
+                                    jsoncons::json_object_arg,
+                                    {{"name", name}, {"value", value}}
+                                });
+                            }
+                        }
+                    },
+                    def);
+
+                defs.push_back(setting);
+            }
+
+            hello["settings"] = std::move(defs);
+        }
+
+        std::string out;
+        hello.dump(out);
+
+        return out;
+    }
+
+    //! Applies settings values sent by Quasar
+    void apply_settings(HostContext& ctx, const std::string& payload)
+    {
+        auto vals = jsoncons::json::parse(payload);
+
+        for (auto&& def : ctx.settings)
+        {
+            std::visit(
+                [&](auto&& arg) {
+                    using V = std::decay_t<decltype(arg.GetValue())>;
+
+                    if (vals.contains(arg.GetLabel()))
+                    {
+                        arg.SetValue(vals[arg.GetLabel()].as<V>());
+                    }
+                },
+                def);
+        }
+    }
+
+    //! Executes a get_data request, placing the result into the ShmRing when possible
+    std::string get_data(HostContext& ctx, const std::string& payload)
+    {
+        auto                 req  = jsoncons::json::parse(payload);
+        auto                 uid  = req["uid"].as<size_t>();
+        std::string          args = req["args"].is_null() ? std::string{} : req["args"].as<std::string>();
+
+        quasar_return_data_t rett;
+
+        bool                 ok = ctx.info->get_data(uid, &rett, args.empty() ? nullptr : args.data());
+
+        jsoncons::json       reply{
+            jsoncons::json_object_arg,
+            {{"ok", ok}, {"errors", jsoncons::json(rett.errors)}}
+        };
+
+        // the frame crosses the process boundary as JSON, so a floating point array is converted here
+        if (!rett.val and !rett.numbers.empty())
+        {
+            rett.val = jsoncons::json(rett.numbers);
+        }
+
+        if (rett.val)
+        {
+            ctx.buffer.clear();
+            rett.val->dump(ctx.buffer);
+
+            if (auto pos = ctx.ring.Write(ctx.buffer))
+            {
+                reply["pos"]  = *pos;
+                reply["size"] = ctx.buffer.size();
+            }
+            else
+            {
+                // ring is full or frame is too large, fall back to the socket
+                reply["val"] = std::move(*rett.val);
+            }
+        }
+
+        std::string out;
+        reply.dump(out);
+
+        return out;
+    }
+
+    //! Executes requests from Quasar in order
+    void worker(HostContext& ctx)
+    {
+        while (true)
+        {
+            Task task;
+
+            {
+                std::unique_lock<std::mutex> lk(taskMutex);
+                taskCv.wait(lk, [] {
+                    return closing or !tasks.empty();
+                });
+
+                if (tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+
+            std::string reply;
+
+            try
+            {
+                switch (task.header.type)
+                {
+                    case MessageType::Init:
+                        {
+                            auto uids = jsoncons::json::parse(task.payload);
+
+                            for (size_t i = 0; i < ctx.info->numDataSources and i < uids.size(); i++)
+                            {
+                                ctx.info->dataSources[i].uid = uids[i].as<size_t>();
+                            }
+
+                            reply = ctx.info->init(&ctx) ? "true" : "false";
+                            break;
+                        }
+                    case MessageType::Update:
+                        apply_settings(ctx, task.payload);
+
+                        if (ctx.info->update)
+                        {
+                            ctx.info->update((quasar_settings_t*) &ctx.settings);
+                        }
+
+                        break;
+                    case MessageType::GetData:
+                        reply = get_data(ctx, task.payload);
+                        break;
+                    case MessageType::Shutdown:
+                        ctx.info->shutdown(&ctx);
+                        shutdown = true;
+                        break;
+                    default:
+                        break;
+                }
+            } catch (std::exception& e)
+            {
+                quasar_log(QUASAR_LOG_ERROR, e.what());
+                reply = (task.header.type == MessageType::GetData) ? R"({"ok":false,"errors":[]})" : "false";
+            }
+
+            ctx.Send(MessageType::Reply, task.header.seq, reply);
+
+            if (task.header.type == MessageType::Shutdown)
+            {
+                return;
+            }
+        }
+    }
+}  // namespace
+
+HostContext& HostContext::Instance()
+{
+    static HostContext ctx;
+    return ctx;
+}
+
+std::optional<std::string> HostContext::Request(MessageType type, std::string_view payload)
+{
+    std::future<std::optional<std::string>> result;
+    uint64_t                                 seq;
+
+    {
+        std::lock_guard<std::mutex> lk(pendingMutex);
+
+        if (!connected)
+        {
+            return std::nullopt;
+        }
+
+        seq    = ++nextSeq;
+        result = pending[seq].get_future();
+    }
+
+    Send(type, seq, payload);
+
+    return result.get();
+}
+
+void HostContext::Send(MessageType type, uint64_t seq, std::string_view payload)
+{
+    std::lock_guard<std::mutex> lk(sendMutex);
+    SendMessage(sock, type, seq, payload);
+}
+
+void HostContext::Fulfill(uint64_t seq, std::string&& payload)
+{
+    std::lock_guard<std::mutex> lk(pendingMutex);
+
+    if (auto it = pending.find(seq); it != pending.end())
+    {
+        it->second.set_value(std::move(payload));
+        pending.erase(it);
+    }
+}
+
+void HostContext::Disconnect()
+{
+    std::lock_guard<std::mutex> lk(pendingMutex);
+
+    connected = false;
+
+    for (auto&& [seq, p] : pending)
+    {
+        p.set_value(std::nullopt);
+    }
+
+    pending.clear();
+}
+
+int main(int argc, char* argv[])
+{
+    Options opts;
+
+    if (!parse_args(argc, argv, opts))
+    {
+        std::fprintf(stderr, "usage: quasar-exthost --shm NAME [--cpus LIST] [--nice N] [--memlimit MiB] LIBRARY\n");
+        return 1;
+    }
+
+    auto& ctx = HostContext::Instance();
+
+    if (!ctx.ring.Open(opts.shm))
+    {
+        std::fprintf(stderr, "quasar-exthost: failed to open %s\n", opts.shm.c_str());
+        return 1;
+    }
+
+    apply_limits(opts);
+
+    void* lib = dlopen(opts.libpath.c_str(), RTLD_NOW | RTLD_LOCAL);
+
+    if (!lib)
+    {
+        std::fprintf(stderr, "quasar-exthost: %s\n", dlerror());
+        return 1;
+    }
+
+    auto loadfunc    = (extension_load) dlsym(lib, "quasar_ext_load");
+    auto destroyfunc = (extension_destroy) dlsym(lib, "quasar_ext_destroy");
+
+    if (!loadfunc or !destroyfunc)
+    {
+        std::fprintf(stderr, "quasar-exthost: failed to resolve extension API in %s\n", opts.libpath.c_str());
+        return 1;
+    }
+
+    ctx.info = loadfunc();
+
+    if (!ctx.info or ctx.info->api_version != QUASAR_API_VERSION or !ctx.info->init or !ctx.info->shutdown or !ctx.info->get_data or !ctx.info->fields or
+        !ctx.info->dataSources)
+    {
+        std::fprintf(stderr, "quasar-exthost: quasar_ext_load failed in %s: required extension data missing\n", opts.libpath.c_str());
+        return 1;
+    }
+
+    ctx.info->fields->name[sizeof(ctx.info->fields->name) - 1] = 0;
+    ctx.name                                                   = ctx.info->fields->name;
+
+    if (ctx.info->create_settings and !ctx.info->create_settings(&ctx))
+    {
+        std::fprintf(stderr, "quasar-exthost: extension create_settings() failed in %s\n", opts.libpath.c_str());
+        return 1;
+    }
+
+    ctx.Send(MessageType::Hello, 0, craft_hello(ctx));
+
+    std::jthread  work([&ctx] {
+        worker(ctx);
+    });
+
+    MessageHeader header;
+    std::string   payload;
+
+    while (ReceiveMessage(ctx.sock, header, payload))
+    {
+        if (header.type == MessageType::Reply)
+        {
+            ctx.Fulfill(header.seq, std::move(payload));
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(taskMutex);
+            tasks.push_back({header, std::move(payload)});
+        }
+
+        taskCv.notify_one();
+
+        if (header.type == MessageType::Shutdown)
+        {
+            break;
+        }
+    }
+
+    // Quasar went away or asked us to stop
+    ctx.Disconnect();
+
+    {
+        std::lock_guard<std::mutex> lk(taskMutex);
+        closing = true;
+    }
+
+    taskCv.notify_one();
+    work.join();
+
+    if (!shutdown)
+    {
+        ctx.info->shutdown(&ctx);
+    }
+
+    destroyfunc(ctx.info);
+    ctx.info = nullptr;
+
+    return 0;
+}
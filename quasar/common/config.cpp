@@ -1,9 +1,12 @@
 #include "config.h"
+#include "startup.h"
 
 #include <string>
 
 Config::Config() : cfg{std::make_unique<QSettings>()}
 {
+    Startup::Phase phase("Config");
+
     ReadInteralSettings();
 }
 
@@ -22,6 +25,7 @@ void Config::ReadInteralSettings()
     ReadSetting(Settings::internal.log_file);
     ReadSetting(Settings::internal.log_level);
     ReadSetting(Settings::internal.port);
+    ReadSetting(Settings::internal.host);
     ReadSetting(Settings::internal.auth);
     ReadSetting(Settings::internal.cookies);
     ReadSetting(Settings::internal.loaded_widgets);
@@ -30,6 +34,7 @@ void Config::ReadInteralSettings()
     ReadSetting(Settings::internal.applauncher);
     ReadSetting(Settings::internal.update_check);
     ReadSetting(Settings::internal.auto_update);
+    ReadSetting(Settings::internal.exthost);
 }
 
 QByteArray Config::ReadGeometry(const QString& name)
@@ -95,6 +100,7 @@ void Config::WriteInternalSettings()
     WriteSetting(Settings::internal.log_file);
     WriteSetting(Settings::internal.log_level);
     WriteSetting(Settings::internal.port);
+    WriteSetting(Settings::internal.host);
     WriteSetting(Settings::internal.auth);
     WriteSetting(Settings::internal.cookies);
     WriteSetting(Settings::internal.loaded_widgets);
@@ -103,4 +109,5 @@ void Config::WriteInternalSettings()
     WriteSetting(Settings::internal.applauncher);
     WriteSetting(Settings::internal.update_check);
     WriteSetting(Settings::internal.auto_update);
+    WriteSetting(Settings::internal.exthost);
 }
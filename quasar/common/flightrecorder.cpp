@@ -0,0 +1,251 @@
+#include "flightrecorder.h"
+
+#include "qutil.h"
+#include "util.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <QDateTime>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    static_assert((FlightRecorder::Capacity & (FlightRecorder::Capacity - 1)) == 0, "FlightRecorder::Capacity must be a power of two");
+
+    constexpr size_t Mask = FlightRecorder::Capacity - 1;
+
+    /*! Single ring entry, guarded by a per slot sequence number
+        seq is 0 while the slot is being written and index + 1 once it is complete, which lets
+        Dump() detect slots that were torn or overwritten while reading them.
+    */
+    struct alignas(32) Slot
+    {
+        std::atomic<uint64_t> seq;
+        std::atomic<int64_t>  ts;
+        std::atomic<int64_t>  value;
+        std::atomic<uint64_t> meta;  //!< thread << 32 | name << 8 | type
+    };
+
+    struct State
+    {
+        std::unique_ptr<Slot[]>                   slots{new Slot[FlightRecorder::Capacity]{}};
+        std::atomic<uint64_t>                     head{};
+
+        std::mutex                                mutex;
+        std::vector<std::string>                  names;
+        std::unordered_map<std::string, uint16_t> nameIds;
+        std::map<uint32_t, std::string>           threadNames;
+
+        std::atomic<uint32_t>                     nextThread{1};
+    };
+
+    State& state()
+    {
+        static State s;
+        return s;
+    }
+
+    uint32_t threadId()
+    {
+        thread_local const uint32_t id = state().nextThread.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    const char* categoryName(FlightRecorder::EventType type)
+    {
+        constexpr const char* categories[] = {"tick", "get_data", "serialize", "publish", "dropped", "lock_wait"};
+        static_assert(std::size(categories) == static_cast<size_t>(FlightRecorder::EventType::Count));
+
+        return categories[static_cast<size_t>(type)];
+    }
+}  // namespace
+
+uint16_t FlightRecorder::RegisterName(std::string_view name)
+{
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lk(s.mutex);
+
+    std::string                 key{name};
+
+    if (auto it = s.nameIds.find(key); it != s.nameIds.end())
+    {
+        return it->second;
+    }
+
+    if (s.names.size() >= UINT16_MAX)
+    {
+        SPDLOG_WARN("Flight recorder name table full, dropping name {}", name);
+        return 0;
+    }
+
+    const auto id = static_cast<uint16_t>(s.names.size());
+
+    s.names.push_back(key);
+    s.nameIds.emplace(std::move(key), id);
+
+    return id;
+}
+
+void FlightRecorder::SetThreadName(std::string_view name)
+{
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lk(s.mutex);
+
+    s.threadNames[threadId()] = name;
+}
+
+void FlightRecorder::Record(EventType type, uint16_t name, int64_t ts, int64_t value)
+{
+    auto&      s    = state();
+    const auto idx  = s.head.fetch_add(1, std::memory_order_relaxed);
+    auto&      slot = s.slots[idx & Mask];
+
+    slot.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.ts.store(ts, std::memory_order_relaxed);
+    slot.value.store(value, std::memory_order_relaxed);
+    slot.meta.store((uint64_t) threadId() << 32 | (uint64_t) name << 8 | static_cast<uint8_t>(type), std::memory_order_relaxed);
+
+    slot.seq.store(idx + 1, std::memory_order_release);
+}
+
+int64_t FlightRecorder::Dump(const std::string& path)
+{
+    auto&                           s = state();
+
+    std::vector<std::string>        names;
+    std::map<uint32_t, std::string> threadNames;
+
+    {
+        std::lock_guard<std::mutex> lk(s.mutex);
+        names       = s.names;
+        threadNames = s.threadNames;
+    }
+
+    std::unique_ptr<FILE, decltype(&fclose)> file{fopen(path.c_str(), "wb"), &fclose};
+
+    if (!file)
+    {
+        SPDLOG_WARN("Failed to open {} for writing", path);
+        return -1;
+    }
+
+    std::string out;
+    out.reserve(1 << 20);
+    out.append(R"({"displayTimeUnit":"ns","traceEvents":[)");
+
+    bool first = true;
+
+    auto separator = [&] {
+        if (!first)
+        {
+            out.append(",\n");
+        }
+
+        first = false;
+    };
+
+    for (auto&& [tid, tname] : threadNames)
+    {
+        separator();
+        fmt::format_to(std::back_inserter(out), R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":")", tid);
+        Util::AppendJSONEscaped(out, tname);
+        out.append(R"("}})");
+    }
+
+    const auto head    = s.head.load(std::memory_order_acquire);
+    const auto begin   = head > Capacity ? head - Capacity : 0;
+    int64_t    written = 0;
+
+    for (auto idx = begin; idx < head; idx++)
+    {
+        auto&      slot = s.slots[idx & Mask];
+
+        const auto seq  = slot.seq.load(std::memory_order_acquire);
+
+        if (seq != idx + 1)
+        {
+            // Being written or already overwritten
+            continue;
+        }
+
+        const auto ts    = slot.ts.load(std::memory_order_relaxed);
+        const auto value = slot.value.load(std::memory_order_relaxed);
+        const auto meta  = slot.meta.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+        {
+            continue;
+        }
+
+        const auto tid  = static_cast<uint32_t>(meta >> 32);
+        const auto name = static_cast<uint16_t>(meta >> 8);
+        const auto type = static_cast<EventType>(meta & 0xFF);
+
+        if (type >= EventType::Count)
+        {
+            continue;
+        }
+
+        separator();
+
+        out.append(R"({"name":")");
+        Util::AppendJSONEscaped(out, name < names.size() ? names[name] : std::string_view{"unknown"});
+        fmt::format_to(std::back_inserter(out), R"(","cat":"{}","pid":1,"tid":{},"ts":{:.3f})", categoryName(type), tid, ts / 1000.0);
+
+        switch (type)
+        {
+            case EventType::Publish:
+                fmt::format_to(std::back_inserter(out), R"(,"ph":"i","s":"t","args":{{"bytes":{}}}}})", value);
+                break;
+            case EventType::Dropped:
+                out.append(R"(,"ph":"i","s":"t"})");
+                break;
+            default:
+                fmt::format_to(std::back_inserter(out), R"(,"ph":"X","dur":{:.3f}}})", value / 1000.0);
+                break;
+        }
+
+        written++;
+    }
+
+    out.append("]}\n");
+
+    if (fwrite(out.data(), 1, out.size(), file.get()) != out.size())
+    {
+        SPDLOG_WARN("Failed to write flight recorder dump to {}", path);
+        return -1;
+    }
+
+    return written;
+}
+
+std::string FlightRecorder::DumpToDataFolder()
+{
+    const auto path = fmt::format("{}flightrecorder-{}.json",
+        QUtil::GetCommonAppDataPath().toStdString(),
+        QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss").toStdString());
+
+    const auto count = Dump(path);
+
+    if (count < 0)
+    {
+        return {};
+    }
+
+    SPDLOG_INFO("Flight recorder: wrote {} events to {}", count, path);
+
+    return path;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*! Always-on in-memory recorder for hot path events.
+
+    Events are written into a fixed size ring of compact binary records and overwrite the oldest
+    entries once the ring is full, so that the most recent history is available after a stutter
+    without any per frame logging. Recording is a single atomic increment plus a handful of relaxed
+    stores and never blocks or allocates. The ring is only decoded when dumped, into the Chrome trace
+    event format which can be opened in chrome://tracing, Perfetto or Speedscope.
+*/
+namespace FlightRecorder
+{
+    //! Number of events kept in the ring, must be a power of two
+    constexpr size_t Capacity = 1 << 16;
+
+    //! Kind of a recorded event
+    enum class EventType : uint8_t
+    {
+        Tick,       //!< Timer tick, timestamped at its scheduled time, value is the delay until it ran in ns
+        GetData,    //!< get_data call, value is its duration in ns
+        Serialize,  //!< JSON serialization, value is its duration in ns
+        Publish,    //!< Frame published, value is its size in bytes
+        Dropped,    //!< Tick dropped for missing its deadline
+        LockWait,   //!< Contended lock acquisition, value is the wait time in ns
+        Count
+    };
+
+    //! Monotonic timestamp in nanoseconds, on the same clock as std::chrono::steady_clock
+    inline int64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //! Converts a steady clock time point to a recorder timestamp
+    inline int64_t ToTimestamp(std::chrono::steady_clock::time_point tp)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+    }
+
+    /*! Registers an event name, i.e. a topic or lock name
+        Names are interned, so registering the same name twice returns the same id.
+        Not meant for hot paths, ids should be looked up once and stored.
+        \param[in]  name    Event name
+        \return Name id to pass to Record()
+    */
+    uint16_t    RegisterName(std::string_view name);
+
+    /*! Names the calling thread in dumps
+        \param[in]  name    Thread name
+    */
+    void        SetThreadName(std::string_view name);
+
+    /*! Records an event
+        \param[in]  type    Event type
+        \param[in]  name    Name id from RegisterName()
+        \param[in]  ts      Timestamp from Now() or ToTimestamp()
+        \param[in]  value   Type specific value \sa EventType
+    */
+    void        Record(EventType type, uint16_t name, int64_t ts, int64_t value = 0);
+
+    /*! Writes the current contents of the ring as Chrome trace JSON
+        Recording continues while dumping, events overwritten during the dump are skipped.
+        \param[in]  path    Output file path
+        \return Number of events written, or -1 if the file could not be opened
+    */
+    int64_t     Dump(const std::string& path);
+
+    /*! Dumps the ring into a timestamped file in the data folder
+        \return Path of the written file, empty on failure
+    */
+    std::string DumpToDataFolder();
+
+    //! Records the lifetime of the scope as a duration event
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent(EventType type, uint16_t name) : evtype{type}, evname{name}, start{Now()} {}
+
+        ~ScopedEvent() { Record(evtype, evname, start, Now() - start); }
+
+    private:
+        EventType evtype;
+        uint16_t  evname;
+        int64_t   start;
+    };
+}  // namespace FlightRecorder
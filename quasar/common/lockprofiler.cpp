@@ -0,0 +1,180 @@
+#include "lockprofiler.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    struct StatsTable
+    {
+        std::mutex                                                                   mutex;
+        std::map<std::string, std::unique_ptr<LockProfiler::LockStats>, std::less<>> locks;
+    };
+
+    StatsTable& table()
+    {
+        static StatsTable t;
+        return t;
+    }
+
+    uint64_t elapsedNs(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count();
+    }
+}  // namespace
+
+LockProfiler::LockStats& LockProfiler::GetStats(std::string_view name)
+{
+    auto&                       t = table();
+    std::lock_guard<std::mutex> lk(t.mutex);
+
+    auto                        it = t.locks.find(name);
+
+    if (it == t.locks.end())
+    {
+        it = t.locks.emplace(std::string{name}, std::make_unique<LockStats>()).first;
+    }
+
+    return *it->second;
+}
+
+void LockProfiler::ToJSON(jsoncons::json& json)
+{
+    auto&                       t = table();
+    std::lock_guard<std::mutex> lk(t.mutex);
+
+    for (auto&& [name, s] : t.locks)
+    {
+        const auto acquisitions = s->acquisitions.load(std::memory_order_relaxed);
+        const auto shared       = s->shared_acquisitions.load(std::memory_order_relaxed);
+
+        if (!acquisitions and !shared)
+        {
+            continue;
+        }
+
+        jsoncons::json l{jsoncons::json_object_arg};
+        l["acquisitions"]        = acquisitions;
+        l["shared_acquisitions"] = shared;
+        l["contended"]           = s->contended.load(std::memory_order_relaxed);
+
+        jsoncons::json wait{jsoncons::json_object_arg};
+        jsoncons::json hold{jsoncons::json_object_arg};
+
+        s->wait_ns.ToJSON(wait);
+        s->hold_ns.ToJSON(hold);
+
+        l["wait_ns"] = std::move(wait);
+        l["hold_ns"] = std::move(hold);
+
+        json[name]   = std::move(l);
+    }
+}
+
+void LockProfiler::LogReport()
+{
+    auto&                                                        t = table();
+    std::lock_guard<std::mutex>                                  lk(t.mutex);
+
+    std::vector<std::pair<const std::string*, const LockStats*>> locks;
+
+    for (auto&& [name, s] : t.locks)
+    {
+        if (s->acquisitions.load(std::memory_order_relaxed) or s->shared_acquisitions.load(std::memory_order_relaxed))
+        {
+            locks.emplace_back(&name, s.get());
+        }
+    }
+
+    if (locks.empty())
+    {
+        return;
+    }
+
+    std::sort(locks.begin(), locks.end(), [](auto& a, auto& b) {
+        return a.second->wait_ns.Sum() > b.second->wait_ns.Sum();
+    });
+
+    SPDLOG_INFO("Lock contention report ({} locks):", locks.size());
+
+    for (auto&& [name, s] : locks)
+    {
+        SPDLOG_INFO("  {}: {} exclusive, {} shared, {} contended, wait total {}us p99 {}us max {}us, hold p99 {}us max {}us",
+            *name,
+            s->acquisitions.load(std::memory_order_relaxed),
+            s->shared_acquisitions.load(std::memory_order_relaxed),
+            s->contended.load(std::memory_order_relaxed),
+            s->wait_ns.Sum() / 1000,
+            s->wait_ns.Percentile(0.99) / 1000,
+            s->wait_ns.Max() / 1000,
+            s->hold_ns.Percentile(0.99) / 1000,
+            s->hold_ns.Max() / 1000);
+    }
+}
+
+void LockProfiler::ProfiledSharedMutex::lock()
+{
+    if (!mutex.try_lock())
+    {
+        const auto start = Clock::now();
+
+        mutex.lock();
+
+        stats->contended.fetch_add(1, std::memory_order_relaxed);
+        stats->wait_ns.Record(elapsedNs(start));
+    }
+
+    stats->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    acquired = Clock::now();
+}
+
+bool LockProfiler::ProfiledSharedMutex::try_lock()
+{
+    if (!mutex.try_lock())
+    {
+        return false;
+    }
+
+    stats->acquisitions.fetch_add(1, std::memory_order_relaxed);
+    acquired = Clock::now();
+
+    return true;
+}
+
+void LockProfiler::ProfiledSharedMutex::unlock()
+{
+    stats->hold_ns.Record(elapsedNs(acquired));
+    mutex.unlock();
+}
+
+void LockProfiler::ProfiledSharedMutex::lock_shared()
+{
+    if (!mutex.try_lock_shared())
+    {
+        const auto start = Clock::now();
+
+        mutex.lock_shared();
+
+        stats->contended.fetch_add(1, std::memory_order_relaxed);
+        stats->wait_ns.Record(elapsedNs(start));
+    }
+
+    stats->shared_acquisitions.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool LockProfiler::ProfiledSharedMutex::try_lock_shared()
+{
+    if (!mutex.try_lock_shared())
+    {
+        return false;
+    }
+
+    stats->shared_acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#include <jsoncons/json.hpp>
+
+#include "metrics.h"
+
+#if defined(TRACY_ENABLE) and !defined(QUASAR_LOCK_PROFILING)
+#  include <tracy/Tracy.hpp>
+#endif
+
+/*! Lock contention profiling for the server's hot locks.
+
+    Locks declared with QUASAR_SHARED_LOCKABLE() are plain std::shared_mutex in regular builds.
+    When built with the QUASAR_LOCK_PROFILING option they become ProfiledSharedMutex, which records
+    acquisitions, contended acquisitions, wait times and exclusive hold times per lock name. Otherwise,
+    when built with TRACY_ENABLE they become Tracy lockables and show up in the Tracy profiler instead.
+*/
+namespace LockProfiler
+{
+    //! Contention statistics for a single named lock
+    struct LockStats
+    {
+        std::atomic<uint64_t> acquisitions{};         //!< Exclusive acquisitions
+        std::atomic<uint64_t> shared_acquisitions{};  //!< Shared acquisitions
+        std::atomic<uint64_t> contended{};            //!< Acquisitions that had to wait, exclusive or shared
+
+        Metrics::Histogram    wait_ns;  //!< Wait time of contended acquisitions in nanoseconds
+        Metrics::Histogram    hold_ns;  //!< Exclusive hold time in nanoseconds
+    };
+
+    /*! Returns the statistics of a named lock, creating them if necessary
+        Locks sharing a name share statistics. The returned reference stays valid for the lifetime of the process.
+        \param[in]  name    Lock name
+    */
+    LockStats& GetStats(std::string_view name);
+
+    /*! Writes statistics of all locks that were acquired at least once
+        \param[in,out]  json    JSON object, keyed by lock name
+    */
+    void       ToJSON(jsoncons::json& json);
+
+    //! Logs statistics of all locks, sorted by total wait time
+    void       LogReport();
+
+    //! Checks whether lock profiling was compiled in
+    constexpr bool Enabled()
+    {
+#if defined(QUASAR_LOCK_PROFILING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /*! std::shared_mutex that records contention into LockStats
+        Only exclusive hold times are recorded, as shared holders are not tracked individually.
+    */
+    class ProfiledSharedMutex
+    {
+    public:
+        explicit ProfiledSharedMutex(std::string_view name) : stats{&GetStats(name)} {}
+
+        ProfiledSharedMutex(const ProfiledSharedMutex&)             = delete;
+        ProfiledSharedMutex& operator= (const ProfiledSharedMutex&) = delete;
+
+        /*! Changes the name statistics are recorded under, i.e. to a per instance name
+            Must not be called while the lock is held.
+            \param[in]  name    Lock name
+        */
+        void                 SetName(std::string_view name) { stats = &GetStats(name); }
+
+        void                 lock();
+        bool                 try_lock();
+        void                 unlock();
+
+        void                 lock_shared();
+        bool                 try_lock_shared();
+        void                 unlock_shared() { mutex.unlock_shared(); }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::shared_mutex mutex;
+        LockStats*        stats;
+        Clock::time_point acquired;  //!< Time of the current exclusive acquisition
+    };
+}  // namespace LockProfiler
+
+#if defined(QUASAR_LOCK_PROFILING)
+//! Declares a named, profiled shared mutex
+#  define QUASAR_SHARED_LOCKABLE(varname, desc) LockProfiler::ProfiledSharedMutex varname{desc}
+//! Renames a lock declared with QUASAR_SHARED_LOCKABLE()
+#  define QUASAR_LOCKABLE_NAME(varname, name)   (varname).SetName(name)
+
+namespace LockProfiler
+{
+    using SharedMutex = ProfiledSharedMutex;
+}  // namespace LockProfiler
+#elif defined(TRACY_ENABLE)
+#  define QUASAR_SHARED_LOCKABLE(varname, desc) TracySharedLockableN(std::shared_mutex, varname, desc)
+#  define QUASAR_LOCKABLE_NAME(varname, name)        \
+    do                                               \
+    {                                                \
+        const std::string n_{name};                  \
+        LockableName(varname, n_.data(), n_.size()); \
+    } while (0)
+
+namespace LockProfiler
+{
+    using SharedMutex = SharedLockableBase(std::shared_mutex);
+}  // namespace LockProfiler
+#else
+#  define QUASAR_SHARED_LOCKABLE(varname, desc) std::shared_mutex varname
+#  define QUASAR_LOCKABLE_NAME(varname, name)   ((void) 0)
+
+namespace LockProfiler
+{
+    using SharedMutex = std::shared_mutex;
+}  // namespace LockProfiler
+#endif
@@ -0,0 +1,494 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+
+#  include <psapi.h>
+#  include <tlhelp32.h>
+#elif defined(__linux__)
+#  include <fstream>
+#endif
+
+#include <fmt/core.h>
+
+namespace
+{
+    std::string EscapeLabel(const std::string& value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+
+        for (char c : value)
+        {
+            switch (c)
+            {
+                case '\\':
+                    escaped += "\\\\";
+                    break;
+                case '"':
+                    escaped += "\\\"";
+                    break;
+                case '\n':
+                    escaped += "\\n";
+                    break;
+                default:
+                    escaped += c;
+                    break;
+            }
+        }
+
+        return escaped;
+    }
+
+    void WriteHeader(std::string& out, std::string_view name, std::string_view type, std::string_view help)
+    {
+        fmt::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+    }
+
+    template<typename T>
+    void WriteSample(std::string& out, std::string_view name, std::string_view labels, T value)
+    {
+        if (labels.empty())
+        {
+            fmt::format_to(std::back_inserter(out), "{} {}\n", name, value);
+        }
+        else
+        {
+            fmt::format_to(std::back_inserter(out), "{}{{{}}} {}\n", name, labels, value);
+        }
+    }
+
+    void WriteProviderValue(std::string& out, const std::string& metric, const std::string& labels, const jsoncons::json& value)
+    {
+        if (value.is_bool())
+        {
+            WriteSample(out, metric, labels, value.as<bool>() ? 1 : 0);
+        }
+        else if (value.is_number())
+        {
+            WriteSample(out, metric, labels, value.as<double>());
+        }
+    }
+}  // namespace
+
+namespace Metrics
+{
+    ProcessStats GetProcessStats()
+    {
+        ProcessStats stats{};
+
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS pmc{};
+
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        {
+            stats.rss_bytes = pmc.WorkingSetSize;
+        }
+
+        HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+
+        if (snap != INVALID_HANDLE_VALUE)
+        {
+            const DWORD   pid = GetCurrentProcessId();
+            THREADENTRY32 te{.dwSize = sizeof(THREADENTRY32)};
+
+            if (Thread32First(snap, &te))
+            {
+                do
+                {
+                    if (te.th32OwnerProcessID == pid)
+                    {
+                        stats.threads++;
+                    }
+                } while (Thread32Next(snap, &te));
+            }
+
+            CloseHandle(snap);
+        }
+#elif defined(__linux__)
+        std::ifstream status("/proc/self/status");
+        std::string   line;
+
+        while (std::getline(status, line))
+        {
+            if (line.starts_with("VmRSS:"))
+            {
+                // reported in kB
+                stats.rss_bytes = std::stoull(line.substr(6)) * 1024;
+            }
+            else if (line.starts_with("Threads:"))
+            {
+                stats.threads = std::stoull(line.substr(8));
+            }
+        }
+#endif
+
+        return stats;
+    }
+
+    unsigned Histogram::BucketIndex(uint64_t value)
+    {
+        value = std::min<uint64_t>(value, (uint64_t{1} << MaxValueBits) - 1);
+
+        if (value < SubBucketCount)
+        {
+            return (unsigned) value;
+        }
+
+        const unsigned msb   = 63 - std::countl_zero(value);
+        const unsigned shift = msb - SubBucketBits;
+
+        return (shift + 1) * SubBucketCount + (unsigned) ((value >> shift) & (SubBucketCount - 1));
+    }
+
+    uint64_t Histogram::BucketLowerBound(unsigned index)
+    {
+        if (index < SubBucketCount)
+        {
+            return index;
+        }
+
+        const unsigned shift = index / SubBucketCount - 1;
+        const unsigned sub   = index % SubBucketCount;
+
+        return uint64_t{SubBucketCount + sub} << shift;
+    }
+
+    void Histogram::Record(uint64_t value)
+    {
+        buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        auto prev = max.load(std::memory_order_relaxed);
+        while (value > prev and !max.compare_exchange_weak(prev, value, std::memory_order_relaxed))
+        {}
+    }
+
+    uint64_t Histogram::Percentile(double q) const
+    {
+        const uint64_t total = Count();
+
+        if (!total)
+        {
+            return 0;
+        }
+
+        const uint64_t target = std::max<uint64_t>(1, (uint64_t) std::ceil(std::clamp(q, 0.0, 1.0) * total));
+        uint64_t       seen   = 0;
+
+        for (unsigned i = 0; i < BucketCount; i++)
+        {
+            seen += buckets[i].load(std::memory_order_relaxed);
+
+            if (seen >= target)
+            {
+                // report the middle of the bucket, but never more than the actual maximum
+                const uint64_t lo = BucketLowerBound(i);
+                const uint64_t hi = (i + 1 < BucketCount) ? BucketLowerBound(i + 1) : lo + 1;
+
+                return std::min(lo + (hi - lo) / 2, Max());
+            }
+        }
+
+        return Max();
+    }
+
+    void Histogram::ToJSON(jsoncons::json& json) const
+    {
+        const auto n  = Count();
+
+        json["count"] = n;
+        json["mean"]  = n ? (double) Sum() / n : 0.0;
+        json["p50"]   = Percentile(0.50);
+        json["p90"]   = Percentile(0.90);
+        json["p99"]   = Percentile(0.99);
+        json["max"]   = Max();
+    }
+
+    Registry::Registry() : started{std::chrono::steady_clock::now()} {}
+
+    Registry& Registry::Instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    SourceMetrics& Registry::GetSource(const std::string& topic)
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+
+        auto&                       entry = sources[topic];
+
+        if (!entry)
+        {
+            entry = std::make_unique<SourceMetrics>();
+        }
+
+        return *entry;
+    }
+
+    void Registry::SetProvider(const std::string& key, ProviderFunc func)
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        providers[key] = std::move(func);
+    }
+
+    void Registry::RemoveProvider(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        providers.erase(key);
+    }
+
+    void Registry::ForEachSource(const std::function<void(const std::string&, const SourceMetrics&)>& func) const
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+
+        for (auto&& [topic, m] : sources)
+        {
+            func(topic, *m);
+        }
+    }
+
+    double Registry::Uptime() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+
+    void Registry::ToJSON(jsoncons::json& json) const
+    {
+        json["uptime"] = Uptime();
+
+        jsoncons::json srv{
+            jsoncons::json_object_arg,
+            {{"clients", server.clients.load()},
+             {"messages", server.messages.load()},
+             {"message_bytes", server.message_bytes.load()},
+             {"publishes", server.publishes.load()},
+             {"publish_bytes", server.publish_bytes.load()}}
+        };
+
+        json["server"] = std::move(srv);
+
+        jsoncons::json srcs{jsoncons::json_object_arg};
+
+        ForEachSource([&](const std::string& topic, const SourceMetrics& m) {
+            jsoncons::json s{
+                jsoncons::json_object_arg,
+                {{"subscribers", m.subscribers.load()},
+                 {"ticks", m.ticks.load()},
+                 {"dropped", m.dropped.load()},
+                 {"errors", m.errors.load()},
+                 {"published", m.published.load()},
+                 {"bytes", m.bytes.load()},
+                 {"cache_hits", m.cache_hits.load()},
+                 {"cache_misses", m.cache_misses.load()}}
+            };
+
+            jsoncons::json getdata{jsoncons::json_object_arg};
+            jsoncons::json serialize{jsoncons::json_object_arg};
+            jsoncons::json queue{jsoncons::json_object_arg};
+            jsoncons::json send{jsoncons::json_object_arg};
+
+            m.get_data_us.ToJSON(getdata);
+            m.serialize_us.ToJSON(serialize);
+            m.queue_us.ToJSON(queue);
+            m.send_us.ToJSON(send);
+
+            s["get_data_us"]  = std::move(getdata);
+            s["serialize_us"] = std::move(serialize);
+            s["queue_us"]     = std::move(queue);
+            s["send_us"]      = std::move(send);
+
+            srcs[topic]       = std::move(s);
+        });
+
+        json["sources"] = std::move(srcs);
+
+        // copy providers so they can run without holding the registry lock
+        std::map<std::string, ProviderFunc> provs;
+
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            provs = providers;
+        }
+
+        for (auto&& [key, func] : provs)
+        {
+            jsoncons::json p{jsoncons::json_object_arg};
+            func(p);
+            json[key] = std::move(p);
+        }
+    }
+
+    void Registry::ToPrometheus(std::string& out) const
+    {
+        const auto proc = GetProcessStats();
+
+        WriteHeader(out, "quasar_uptime_seconds", "gauge", "Seconds since Quasar started");
+        WriteSample(out, "quasar_uptime_seconds", "", Uptime());
+
+        WriteHeader(out, "quasar_process_resident_memory_bytes", "gauge", "Resident set size of the Quasar process");
+        WriteSample(out, "quasar_process_resident_memory_bytes", "", proc.rss_bytes);
+
+        WriteHeader(out, "quasar_process_threads", "gauge", "Number of OS threads in the Quasar process");
+        WriteSample(out, "quasar_process_threads", "", proc.threads);
+
+        WriteHeader(out, "quasar_clients", "gauge", "Connected WebSocket clients");
+        WriteSample(out, "quasar_clients", "", server.clients.load());
+
+        WriteHeader(out, "quasar_messages_received_total", "counter", "Messages received from clients");
+        WriteSample(out, "quasar_messages_received_total", "", server.messages.load());
+
+        WriteHeader(out, "quasar_messages_received_bytes_total", "counter", "Bytes received from clients");
+        WriteSample(out, "quasar_messages_received_bytes_total", "", server.message_bytes.load());
+
+        WriteHeader(out, "quasar_publishes_total", "counter", "Topic publish calls");
+        WriteSample(out, "quasar_publishes_total", "", server.publishes.load());
+
+        WriteHeader(out, "quasar_publish_bytes_total", "counter", "Bytes published to topics");
+        WriteSample(out, "quasar_publish_bytes_total", "", server.publish_bytes.load());
+
+        // Per source metrics, grouped by metric name as required by the format
+        struct SourceCounter
+        {
+            const char*                                   name;
+            const char*                                   type;
+            const char*                                   help;
+            std::function<uint64_t(const SourceMetrics&)> get;
+        };
+
+        const SourceCounter counters[] = {
+            {"quasar_source_subscribers", "gauge", "Current subscribers",
+             [](auto& m) {
+                 return (uint64_t) std::max<int64_t>(m.subscribers.load(), 0);
+             }},
+            {"quasar_source_ticks_total", "counter", "Timer ticks and signals received",
+             [](auto& m) {
+                 return m.ticks.load();
+             }},
+            {"quasar_source_dropped_total", "counter", "Timer ticks dropped for missing their deadline",
+             [](auto& m) {
+                 return m.dropped.load();
+             }},
+            {"quasar_source_errors_total", "counter", "Failed get_data calls",
+             [](auto& m) {
+                 return m.errors.load();
+             }},
+            {"quasar_source_published_total", "counter", "Messages sent to clients",
+             [](auto& m) {
+                 return m.published.load();
+             }},
+            {"quasar_source_bytes_total", "counter", "Bytes sent to clients",
+             [](auto& m) {
+                 return m.bytes.load();
+             }},
+            {"quasar_source_cache_hits_total", "counter", "Client polls served from cache",
+             [](auto& m) {
+                 return m.cache_hits.load();
+             }},
+            {"quasar_source_cache_misses_total", "counter", "Client polls of cachable sources that called get_data",
+             [](auto& m) {
+                 return m.cache_misses.load();
+             }},
+        };
+
+        for (auto&& c : counters)
+        {
+            WriteHeader(out, c.name, c.type, c.help);
+
+            ForEachSource([&](const std::string& topic, const SourceMetrics& m) {
+                WriteSample(out, c.name, fmt::format("topic=\"{}\"", EscapeLabel(topic)), c.get(m));
+            });
+        }
+
+        const std::pair<const char*, const Histogram SourceMetrics::*> histograms[] = {
+            {"quasar_source_get_data_seconds",  &SourceMetrics::get_data_us },
+            {"quasar_source_serialize_seconds", &SourceMetrics::serialize_us},
+            {"quasar_source_queue_seconds",     &SourceMetrics::queue_us    },
+            {"quasar_source_send_seconds",      &SourceMetrics::send_us     }
+        };
+
+        for (auto&& [name, member] : histograms)
+        {
+            WriteHeader(out, name, "summary", "Duration in seconds");
+
+            ForEachSource([&](const std::string& topic, const SourceMetrics& m) {
+                const auto& h     = m.*member;
+                const auto  label = EscapeLabel(topic);
+
+                for (double q : {0.5, 0.9, 0.99})
+                {
+                    WriteSample(out, name, fmt::format("topic=\"{}\",quantile=\"{}\"", label, q), h.Percentile(q) / 1e6);
+                }
+
+                WriteSample(out, fmt::format("{}_sum", name), fmt::format("topic=\"{}\"", label), h.Sum() / 1e6);
+                WriteSample(out, fmt::format("{}_count", name), fmt::format("topic=\"{}\"", label), h.Count());
+            });
+        }
+
+        // Provider metrics
+        std::map<std::string, ProviderFunc> provs;
+
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            provs = providers;
+        }
+
+        for (auto&& [key, func] : provs)
+        {
+            jsoncons::json p{jsoncons::json_object_arg};
+            func(p);
+
+            // collect samples per metric name first so each metric gets a single header
+            std::map<std::string, std::vector<std::pair<std::string, const jsoncons::json*>>> samples;
+
+            for (auto&& member : p.object_range())
+            {
+                if (member.value().is_object())
+                {
+                    const auto label = fmt::format("name=\"{}\"", EscapeLabel(std::string{member.key()}));
+
+                    for (auto&& field : member.value().object_range())
+                    {
+                        if (field.value().is_object())
+                        {
+                            // i.e. histograms, flattened to quasar_<key>_<field>_<stat>
+                            for (auto&& stat : field.value().object_range())
+                            {
+                                samples[fmt::format("quasar_{}_{}_{}", key, field.key(), stat.key())].emplace_back(label, &stat.value());
+                            }
+                        }
+                        else
+                        {
+                            samples[fmt::format("quasar_{}_{}", key, field.key())].emplace_back(label, &field.value());
+                        }
+                    }
+                }
+                else
+                {
+                    samples[fmt::format("quasar_{}_{}", key, member.key())].emplace_back(std::string{}, &member.value());
+                }
+            }
+
+            for (auto&& [metric, values] : samples)
+            {
+                fmt::format_to(std::back_inserter(out), "# TYPE {} untyped\n", metric);
+
+                for (auto&& [labels, value] : values)
+                {
+                    WriteProviderValue(out, metric, labels, *value);
+                }
+            }
+        }
+    }
+}  // namespace Metrics
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <jsoncons/json.hpp>
+
+namespace Metrics
+{
+    /*! Fixed size log-linear histogram in the spirit of HdrHistogram.
+
+        Values below 2^SubBucketBits are recorded exactly. Above that, every power of two is
+        split into 2^SubBucketBits linear sub-buckets, giving a worst case relative error of
+        about 6%. Recording is a couple of bit operations and one relaxed atomic increment,
+        so histograms can be updated from any thread on hot paths.
+    */
+    class Histogram
+    {
+    public:
+        static constexpr unsigned SubBucketBits  = 4;
+        static constexpr unsigned SubBucketCount = 1u << SubBucketBits;
+        static constexpr unsigned MaxValueBits   = 40;  //!< Values are clamped below 2^MaxValueBits
+        static constexpr unsigned BucketCount    = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+        //! Records a single value
+        void     Record(uint64_t value);
+
+        //! Number of recorded values
+        uint64_t Count() const { return count.load(std::memory_order_relaxed); }
+
+        //! Sum of all recorded values
+        uint64_t Sum() const { return sum.load(std::memory_order_relaxed); }
+
+        //! Largest recorded value
+        uint64_t Max() const { return max.load(std::memory_order_relaxed); }
+
+        /*! Returns an approximation of the value at quantile q
+            \param[in]  q   Quantile in [0, 1]
+            \return Value at quantile q, 0 if nothing was recorded
+        */
+        uint64_t Percentile(double q) const;
+
+        /*! Writes count, mean, p50, p90, p99 and max into json
+            \param[in,out]  json    JSON object
+        */
+        void     ToJSON(jsoncons::json& json) const;
+
+        //! Returns the bucket index of value
+        static unsigned BucketIndex(uint64_t value);
+
+        //! Returns the smallest value that falls into bucket index
+        static uint64_t BucketLowerBound(unsigned index);
+
+    private:
+        std::array<std::atomic<uint64_t>, BucketCount> buckets{};
+        std::atomic<uint64_t>                          count{};
+        std::atomic<uint64_t>                          sum{};
+        std::atomic<uint64_t>                          max{};
+    };
+
+    //! Metrics for a single Data Source
+    struct SourceMetrics
+    {
+        std::atomic<int64_t>  subscribers{};   //!< Current subscriber count
+        std::atomic<uint64_t> ticks{};         //!< Timer ticks and signals received
+        std::atomic<uint64_t> dropped{};       //!< Timer ticks dropped for missing their deadline
+        std::atomic<uint64_t> errors{};        //!< Failed get_data calls
+        std::atomic<uint64_t> published{};     //!< Messages sent to clients
+        std::atomic<uint64_t> bytes{};         //!< Bytes sent to clients
+        std::atomic<uint64_t> cache_hits{};    //!< Client polls served from cache
+        std::atomic<uint64_t> cache_misses{};  //!< Client polls of cachable sources that called get_data
+
+        Histogram             get_data_us;   //!< get_data duration in microseconds
+        Histogram             serialize_us;  //!< JSON serialization duration in microseconds
+        Histogram             queue_us;      //!< Time from scheduled tick or signal to get_data start in microseconds
+        Histogram             send_us;       //!< Time from serialization end to the server loop sending traced frames in microseconds
+    };
+
+    /*! Trace timestamps of a single published frame
+        All timestamps are wall clock microseconds since the Unix epoch so that they can be
+        compared with client side clocks on the same host.
+    */
+    struct FrameTrace
+    {
+        uint64_t seq;        //!< Per source sequence number
+        int64_t  tick;       //!< Scheduled timer tick or data ready signal
+        int64_t  get_start;  //!< get_data called
+        int64_t  get_end;    //!< get_data returned
+        int64_t  ser_end;    //!< JSON serialization finished
+    };
+
+    //! Current wall clock time in microseconds since the Unix epoch
+    inline int64_t WallClockMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    /*! Converts a steady clock time point to wall clock microseconds since the Unix epoch
+        \param[in]  tp  Time point
+    */
+    inline int64_t ToWallClockMicros(std::chrono::steady_clock::time_point tp)
+    {
+        return WallClockMicros() - std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tp).count();
+    }
+
+    //! Metrics for the WebSocket server
+    struct ServerMetrics
+    {
+        std::atomic<int64_t>  clients{};         //!< Connected clients
+        std::atomic<uint64_t> messages{};        //!< Messages received from clients
+        std::atomic<uint64_t> message_bytes{};   //!< Bytes received from clients
+        std::atomic<uint64_t> publishes{};       //!< Publish calls
+        std::atomic<uint64_t> publish_bytes{};   //!< Bytes published
+    };
+
+    //! Resource usage of the current process
+    struct ProcessStats
+    {
+        uint64_t rss_bytes;  //!< Resident set size
+        uint64_t threads;    //!< Number of OS threads
+    };
+
+    //! Returns resource usage of the current process, zeroed where unsupported
+    ProcessStats GetProcessStats();
+
+    //! Callback adding metrics owned by another component to a JSON object
+    using ProviderFunc = std::function<void(jsoncons::json&)>;
+
+    //! Process wide metrics registry
+    class Registry
+    {
+    public:
+        Registry(const Registry&)             = delete;
+        Registry& operator= (const Registry&) = delete;
+
+        //! Returns the registry instance
+        static Registry& Instance();
+
+        /*! Returns the metrics of a Data Source, creating them if necessary
+            The returned reference stays valid for the lifetime of the process.
+            \param[in]  topic   Topic identifier
+        */
+        SourceMetrics&   GetSource(const std::string& topic);
+
+        //! Returns the server metrics
+        ServerMetrics&   GetServer() { return server; }
+
+        /*! Registers a callback that fills in metrics under key
+            \param[in]  key     Key in the metrics JSON
+            \param[in]  func    Provider callback
+        */
+        void             SetProvider(const std::string& key, ProviderFunc func);
+
+        //! Removes a provider registered with SetProvider()
+        void             RemoveProvider(const std::string& key);
+
+        /*! Visits the metrics of every Data Source
+            \param[in]  func    Callback taking the topic and its SourceMetrics
+        */
+        void             ForEachSource(const std::function<void(const std::string&, const SourceMetrics&)>& func) const;
+
+        /*! Writes a snapshot of all metrics
+            \param[in,out]  json    JSON object
+        */
+        void             ToJSON(jsoncons::json& json) const;
+
+        /*! Writes a snapshot of all metrics in the Prometheus text exposition format
+            Provider metrics are flattened to quasar_<key>_<field>, with nested objects
+            becoming a name label and objects nested below that (i.e. histograms) adding
+            their field names as a suffix.
+            \param[out]    out     Output buffer, appended to
+        */
+        void             ToPrometheus(std::string& out) const;
+
+        //! Seconds since the registry was created
+        double           Uptime() const;
+
+    private:
+        Registry();
+
+        const std::chrono::steady_clock::time_point           started;
+
+        mutable std::mutex                                    mutex;
+        std::map<std::string, std::unique_ptr<SourceMetrics>> sources;
+        std::map<std::string, ProviderFunc>                   providers;
+
+        ServerMetrics                                         server;
+    };
+
+    //! Records the lifetime of the scope into a Histogram in microseconds
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(Histogram& hist) : histogram{hist}, start{std::chrono::steady_clock::now()} {}
+
+        ~ScopedTimer()
+        {
+            histogram.Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+
+    private:
+        Histogram&                            histogram;
+        std::chrono::steady_clock::time_point start;
+    };
+}  // namespace Metrics
@@ -159,10 +159,12 @@ namespace Settings
                     {LogLevel::off, "Off"}}
         };
         Setting<int>         port{"main/port", "WebSocket server port", 13337, 1000, 65535, 1};
+        Setting<std::string> host{"main/host", "WebSocket server listen address", "localhost"};
         Setting<bool>        auth{"main/auth", "Allow only Quasar widgets to connect to the WebSocket server?", false};
         Setting<std::string> cookies{"main/cookies", "cookies.txt", ""};
         Setting<bool>        update_check{"main/updatecheck", "Check for updates?", true};
         Setting<bool>        auto_update{"main/autoupdate", "Automatically download and install updates?", false};
+        Setting<bool>        exthost{"main/exthost", "Run data extensions in isolated host processes?", false};
 
         // Hidden
         Setting<std::string> loaded_widgets{"main/loaded", "Loaded Widgets", ""};
@@ -0,0 +1,211 @@
+#include "startup.h"
+
+#include "qutil.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    using Clock                     = std::chrono::steady_clock;
+
+    constexpr size_t WaterfallWidth = 40;
+
+    struct PhaseEntry
+    {
+        std::string       name;
+        std::string       detail;
+        Clock::time_point begin;
+        Clock::time_point end;
+        int               depth;
+        size_t            thread;
+        bool              done;
+    };
+
+    struct Timeline
+    {
+        std::mutex              mutex;
+        Clock::time_point       origin{Clock::now()};
+        std::vector<PhaseEntry> phases;
+        bool                    finished{};
+        size_t                  nextThread{};
+    };
+
+    Timeline& timeline()
+    {
+        static Timeline t;
+        return t;
+    }
+
+    thread_local int    depth  = 0;
+    thread_local size_t thread = SIZE_MAX;
+
+    double toMs(Clock::duration d)
+    {
+        return std::chrono::duration<double, std::milli>(d).count();
+    }
+
+    std::string label(const PhaseEntry& p)
+    {
+        return p.detail.empty() ? p.name : fmt::format("{}: {}", p.name, p.detail);
+    }
+
+    void writeTrace(const std::vector<PhaseEntry>& phases, Clock::time_point origin)
+    {
+        const char* env = std::getenv("QUASAR_STARTUP_TRACE");
+
+        if (!env or !*env)
+        {
+            return;
+        }
+
+        std::string path{env};
+
+        if (path == "1")
+        {
+            path = QUtil::GetCommonAppDataPath().toStdString() + "startup-trace.json";
+        }
+
+        std::string out{R"({"displayTimeUnit":"ms","traceEvents":[)"};
+
+        for (size_t i = 0; i < phases.size(); i++)
+        {
+            const auto& p = phases[i];
+
+            out.append(i ? ",\n" : "");
+            out.append(R"({"name":")");
+            Util::AppendJSONEscaped(out, label(p));
+            fmt::format_to(std::back_inserter(out),
+                R"(","cat":"startup","ph":"X","pid":1,"tid":{},"ts":{:.1f},"dur":{:.1f},"args":{{"detail":")",
+                p.thread,
+                toMs(p.begin - origin) * 1000.0,
+                toMs(p.end - p.begin) * 1000.0);
+            Util::AppendJSONEscaped(out, p.detail);
+            out.append(R"("}})");
+        }
+
+        out.append("]}\n");
+
+        std::unique_ptr<FILE, decltype(&fclose)> file{fopen(path.c_str(), "wb"), &fclose};
+
+        if (!file or fwrite(out.data(), 1, out.size(), file.get()) != out.size())
+        {
+            SPDLOG_WARN("Failed to write startup trace to {}", path);
+            return;
+        }
+
+        SPDLOG_INFO("Startup trace written to {}", path);
+    }
+}  // namespace
+
+void Startup::Start()
+{
+    auto&                       t = timeline();
+    std::lock_guard<std::mutex> lk(t.mutex);
+
+    t.origin = Clock::now();
+}
+
+void Startup::Finish()
+{
+    auto&                   t = timeline();
+
+    std::vector<PhaseEntry> phases;
+    Clock::time_point       origin;
+
+    {
+        std::lock_guard<std::mutex> lk(t.mutex);
+
+        if (t.finished)
+        {
+            return;
+        }
+
+        t.finished = true;
+        origin     = t.origin;
+        phases     = t.phases;
+    }
+
+    const auto now = Clock::now();
+
+    for (auto&& p : phases)
+    {
+        if (!p.done)
+        {
+            p.end = now;
+        }
+    }
+
+    std::stable_sort(phases.begin(), phases.end(), [](auto& a, auto& b) {
+        return a.begin < b.begin;
+    });
+
+    const auto total = toMs(now - origin);
+
+    SPDLOG_INFO("Startup finished in {:.1f} ms", total);
+
+    for (auto&& p : phases)
+    {
+        const auto start = toMs(p.begin - origin);
+        const auto dur   = toMs(p.end - p.begin);
+
+        // Bar spanning the phase, scaled to the total startup time
+        std::string bar(WaterfallWidth, ' ');
+
+        if (total > 0)
+        {
+            const auto first = std::min<size_t>(static_cast<size_t>(start / total * WaterfallWidth), WaterfallWidth - 1);
+            const auto last  = std::clamp<size_t>(static_cast<size_t>((start + dur) / total * WaterfallWidth), first + 1, WaterfallWidth);
+
+            std::fill(bar.begin() + first, bar.begin() + last, '#');
+        }
+
+        SPDLOG_INFO("  |{}| {:>8.1f} ms {:>8.1f} ms  {:{}}{}", bar, start, dur, "", p.depth * 2, label(p));
+    }
+
+    writeTrace(phases, origin);
+}
+
+Startup::Phase::Phase(std::string name, std::string detail) : index{std::string::npos}
+{
+    auto&                       t = timeline();
+    std::lock_guard<std::mutex> lk(t.mutex);
+
+    if (t.finished)
+    {
+        return;
+    }
+
+    if (thread == SIZE_MAX)
+    {
+        thread = t.nextThread++;
+    }
+
+    index = t.phases.size();
+    t.phases.push_back({std::move(name), std::move(detail), Clock::now(), {}, depth++, thread, false});
+}
+
+Startup::Phase::~Phase()
+{
+    if (index == std::string::npos)
+    {
+        return;
+    }
+
+    depth--;
+
+    auto&                       t = timeline();
+    std::lock_guard<std::mutex> lk(t.mutex);
+
+    t.phases[index].end  = Clock::now();
+    t.phases[index].done = true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/*! Startup timeline profiler.
+
+    Phases of a cold start are timed with scoped Phase objects, which may nest and may be
+    created on any thread. Finish() logs the timeline as a waterfall and, if the
+    QUASAR_STARTUP_TRACE environment variable is set, writes it as a Chrome trace file.
+    QUASAR_STARTUP_TRACE may be a file path, or 1 to write startup-trace.json to the data folder.
+    Phases started after Finish() are not recorded.
+*/
+namespace Startup
+{
+    //! Marks the start of the timeline, should be called first thing in main()
+    void Start();
+
+    //! Logs the startup waterfall, writes the trace file if requested, and stops recording
+    void Finish();
+
+    //! Times the lifetime of the scope as a startup phase
+    class Phase
+    {
+    public:
+        /*! Starts a phase
+            \param[in]  name    Phase name
+            \param[in]  detail  Optional detail, i.e. the extension or widget being loaded
+        */
+        explicit Phase(std::string name, std::string detail = {});
+
+        Phase(const Phase&)             = delete;
+        Phase& operator= (const Phase&) = delete;
+
+        ~Phase();
+
+    private:
+        size_t index;  //!< Index of the phase in the timeline, or npos if not recorded
+    };
+}  // namespace Startup
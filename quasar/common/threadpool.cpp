@@ -0,0 +1,203 @@
+#include "threadpool.h"
+
+#include "flightrecorder.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    constexpr const char* PriorityNames[] = {"realtime", "normal", "background"};
+}  // namespace
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    // worker 0 is reserved for realtime work, and at least one of the others always stays free of background work
+    threads       = std::max<size_t>(threads, 3);
+    maxBackground = std::max<size_t>((threads - 1) / 2, 1);
+
+    workers.reserve(threads);
+
+    for (size_t i = 0; i < threads; i++)
+    {
+        workers.emplace_back([this, i](std::stop_token stoken) {
+            worker(stoken, i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    WaitForTasks();
+
+    for (auto& w : workers)
+    {
+        w.request_stop();
+    }
+
+    taskCv.notify_all();
+    realtimeCv.notify_all();
+
+    workers.clear();
+}
+
+void ThreadPool::Push(TaskType&& task, TaskPriority priority)
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        queues[static_cast<size_t>(priority)].push_back({std::move(task), Clock::now()});
+    }
+
+    if (priority == TaskPriority::Realtime)
+    {
+        realtimeCv.notify_one();
+    }
+
+    taskCv.notify_one();
+}
+
+void ThreadPool::WaitForTasks()
+{
+    std::unique_lock<std::mutex> lk(mutex);
+
+    doneCv.wait(lk, [this] {
+        return running == 0 and std::all_of(queues.begin(), queues.end(), [](auto& q) {
+            return q.empty();
+        });
+    });
+}
+
+TaskQueueStats ThreadPool::GetStats(TaskPriority priority) const
+{
+    const auto& s     = stats[static_cast<size_t>(priority)];
+    const auto  tasks = s.tasks.load(std::memory_order_relaxed);
+
+    size_t      queued;
+
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        queued = queues[static_cast<size_t>(priority)].size();
+    }
+
+    return {
+        .tasks  = tasks,
+        .avg_us = tasks ? s.total_us.load(std::memory_order_relaxed) / tasks : 0,
+        .max_us = s.max_us.load(std::memory_order_relaxed),
+        .queued = queued,
+    };
+}
+
+const char* ThreadPool::PriorityName(TaskPriority priority)
+{
+    return PriorityNames[static_cast<size_t>(priority)];
+}
+
+void ThreadPool::LogStats() const
+{
+    for (size_t i = 0; i < NumClasses; i++)
+    {
+        auto p = static_cast<TaskPriority>(i);
+        auto s = GetStats(p);
+
+        SPDLOG_INFO("Pool queue latency ({}): {} tasks, avg {}us, max {}us, {} queued", PriorityName(p), s.tasks, s.avg_us, s.max_us, s.queued);
+    }
+}
+
+bool ThreadPool::nextTask(size_t index, QueuedTask& out, TaskPriority& priority)
+{
+    for (size_t c = 0; c < NumClasses; c++)
+    {
+        auto p = static_cast<TaskPriority>(c);
+
+        if (queues[c].empty())
+        {
+            continue;
+        }
+
+        // worker 0 is reserved for realtime work
+        if (index == 0 and p != TaskPriority::Realtime)
+        {
+            return false;
+        }
+
+        if (p == TaskPriority::Background and runningBackground >= maxBackground)
+        {
+            return false;
+        }
+
+        out = std::move(queues[c].front());
+        queues[c].pop_front();
+        priority = p;
+
+        return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::worker(std::stop_token stoken, size_t index)
+{
+    FlightRecorder::SetThreadName(fmt::format("pool-{}", index));
+
+    while (true)
+    {
+        QueuedTask   item;
+        TaskPriority priority;
+
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+
+            auto& cv = (index == 0) ? realtimeCv : taskCv;
+
+            if (!cv.wait(lk, stoken, [&] {
+                    return nextTask(index, item, priority);
+                }))
+            {
+                return;
+            }
+
+            running++;
+
+            if (priority == TaskPriority::Background)
+            {
+                runningBackground++;
+            }
+        }
+
+        // Record queue latency
+        auto&      s       = stats[static_cast<size_t>(priority)];
+        const auto latency = (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - item.queued).count();
+
+        s.tasks.fetch_add(1, std::memory_order_relaxed);
+        s.total_us.fetch_add(latency, std::memory_order_relaxed);
+
+        auto prevMax = s.max_us.load(std::memory_order_relaxed);
+        while (latency > prevMax and !s.max_us.compare_exchange_weak(prevMax, latency, std::memory_order_relaxed))
+        {}
+
+        try
+        {
+            item.task();
+        } catch (std::exception& e)
+        {
+            SPDLOG_WARN("Exception in pool task: {}", e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+
+            running--;
+
+            if (priority == TaskPriority::Background)
+            {
+                runningBackground--;
+
+                // a background slot freed up
+                taskCv.notify_one();
+            }
+        }
+
+        doneCv.notify_all();
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! Scheduling class of a task submitted to ThreadPool
+enum class TaskPriority : uint8_t
+{
+    Realtime,    //!< Latency sensitive work, i.e. data for high rate or signaled sources
+    Normal,      //!< Regular work, i.e. client messages and polled data
+    Background,  //!< Work that may be delayed indefinitely, i.e. housekeeping
+    Count
+};
+
+//! Aggregated queue latency for a single TaskPriority
+struct TaskQueueStats
+{
+    uint64_t tasks;   //!< Number of tasks started
+    uint64_t avg_us;  //!< Average time between submission and start
+    uint64_t max_us;  //!< Largest time between submission and start
+    size_t   queued;  //!< Tasks currently waiting
+};
+
+/*! Fixed size worker pool with strict priority classes.
+
+    Workers always take the oldest task of the highest non-empty class. Worker 0
+    only ever runs Realtime tasks so that a burst of Normal or Background work
+    cannot delay them by more than one task duration, and at most half of the
+    remaining workers may run Background tasks at the same time, so at least one
+    worker is always available for Normal tasks.
+
+    Tasks should not block or sleep, as every blocked task holds a worker. Use a
+    Timer or a server loop timer for delayed work instead.
+*/
+class ThreadPool
+{
+public:
+    using TaskType = std::function<void()>;
+
+    /*! Constructs the pool and starts the workers
+        \param[in]  threads     Number of workers, at least 3
+    */
+    explicit ThreadPool(size_t threads = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool&)             = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    /*! Queues a task
+        \param[in]  task        Task to run
+        \param[in]  priority    Scheduling class
+    */
+    void           Push(TaskType&& task, TaskPriority priority = TaskPriority::Normal);
+
+    //! Blocks until all queued and running tasks have completed
+    void           WaitForTasks();
+
+    /*! Returns queue latency statistics for a scheduling class
+        \param[in]  priority    Scheduling class
+        \return Statistics since construction
+    */
+    TaskQueueStats GetStats(TaskPriority priority) const;
+
+    //! Logs queue latency statistics for all scheduling classes
+    void           LogStats() const;
+
+    //! Returns the lowercase name of a scheduling class
+    static const char* PriorityName(TaskPriority priority);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct QueuedTask
+    {
+        TaskType          task;
+        Clock::time_point queued;
+    };
+
+    struct ClassStats
+    {
+        std::atomic<uint64_t> tasks{};
+        std::atomic<uint64_t> total_us{};
+        std::atomic<uint64_t> max_us{};
+    };
+
+    static constexpr size_t NumClasses = static_cast<size_t>(TaskPriority::Count);
+
+    void                    worker(std::stop_token stoken, size_t index);
+
+    //! Picks the next runnable class for a worker, must hold mutex
+    bool                    nextTask(size_t index, QueuedTask& out, TaskPriority& priority);
+
+    std::array<std::deque<QueuedTask>, NumClasses> queues;
+    std::array<ClassStats, NumClasses>             stats;
+
+    mutable std::mutex                             mutex;
+    std::condition_variable_any                    taskCv;      //!< Wakes general workers
+    std::condition_variable_any                    realtimeCv;  //!< Wakes worker 0
+    std::condition_variable                        doneCv;
+
+    size_t                                         running{};            //!< Tasks currently executing
+    size_t                                         runningBackground{};  //!< Background tasks currently executing
+    size_t                                         maxBackground{};      //!< Limit on concurrent Background tasks
+
+    std::vector<std::jthread>                      workers;
+};
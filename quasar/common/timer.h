@@ -7,6 +7,8 @@
 
 #include <spdlog/spdlog.h>
 
+#include "flightrecorder.h"
+
 class Timer
 {
 public:
@@ -14,21 +16,31 @@ public:
 
     ~Timer() { stop(); }
 
+    /*! Starts calling fn every intv microseconds
+        Ticks are scheduled on a fixed grid, so time spent in fn does not cause drift.
+        fn receives the deadline of the tick, which is one interval after its scheduled time.
+        If fn overruns into the next tick, that tick is issued immediately. If it overruns by more than
+        one interval, all missed ticks are issued as a single tick with the deadline of the first one,
+        which has already passed so that the callee counts it as one drop, and the timer resumes at
+        the next tick on the grid that is still in the future.
+        \param[in]  fn      Callback taking a std::chrono::steady_clock::time_point deadline
+        \param[in]  intv    Interval in microseconds
+    */
     void setInterval(auto&& fn, int intv)
     {
         interval = intv;
         // SPDLOG_DEBUG("New timer thread with {}us internal", interval);
         thread = std::jthread{[&, fn](std::stop_token token) {
-            const auto origInterval    = std::chrono::nanoseconds(std::chrono::microseconds(interval));
-            auto       nextSleep       = origInterval;
-            auto       frameTimeBefore = std::chrono::steady_clock::now();
-            auto       frameTimeAfter  = std::chrono::steady_clock::now();
+            FlightRecorder::SetThreadName(name);
+
+            const auto period   = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds(interval));
+            auto       nextTick = std::chrono::steady_clock::now() + period;
 
             while (true)
             {
                 {
                     std::unique_lock lk(mtx);
-                    if (cv.wait_for(lk, token, nextSleep, [&] {
+                    if (cv.wait_until(lk, token, nextTick, [&] {
                             return token.stop_requested();
                         }))
                     {
@@ -36,12 +48,18 @@ public:
                     }
                 }
 
-                frameTimeBefore = std::chrono::steady_clock::now();
+                fn(nextTick + period);
 
-                fn();
+                nextTick += period;
 
-                frameTimeAfter = std::chrono::steady_clock::now();
-                nextSleep      = origInterval - (frameTimeAfter - frameTimeBefore);
+                if (const auto now = std::chrono::steady_clock::now(); now > nextTick + period)
+                {
+                    // more than one tick was missed, replaying each of them would only add lock round trips for ticks
+                    // that are dropped anyways
+                    fn(nextTick + period);
+
+                    nextTick += ((now - nextTick) / period + 1) * period;
+                }
             }
         }};
     }
@@ -1,5 +1,7 @@
 #include "util.h"
 
+#include <charconv>
+
 char* Util::SafeCStrCopy(char* dest, size_t destSize, const char* src, size_t srcSize)
 {
     if (destSize > 0 and srcSize > 0)
@@ -13,3 +15,65 @@ char* Util::SafeCStrCopy(char* dest, size_t destSize, const char* src, size_t sr
     }
     return dest;
 }
+
+void Util::AppendJSONEscaped(std::string& dest, std::string_view str)
+{
+    constexpr char hex[] = "0123456789abcdef";
+
+    for (auto c : str)
+    {
+        const auto u = static_cast<unsigned char>(c);
+
+        if (c == '"' or c == '\\')
+        {
+            dest.push_back('\\');
+            dest.push_back(c);
+        }
+        else if (u < 0x20)
+        {
+            dest.append("\\u00");
+            dest.push_back(hex[u >> 4]);
+            dest.push_back(hex[u & 0xf]);
+        }
+        else
+        {
+            dest.push_back(c);
+        }
+    }
+}
+
+void Util::QuantizeUnit(const double* in, size_t n, uint16_t max, uint16_t* out)
+{
+    const double scale = max;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        // min/max rather than std::clamp, so that NaN falls through to 0 and the loop has no branches
+        const double x = std::max(0.0, std::min(in[i], 1.0));
+
+        out[i]         = (uint16_t) (int32_t) (x * scale + 0.5);
+    }
+}
+
+void Util::AppendIntegers(std::string& dest, const uint16_t* in, size_t n)
+{
+    // at most 5 digits and a comma per integer
+    const size_t offset = dest.size();
+
+    dest.resize(offset + n * 6);
+
+    char* p   = dest.data() + offset;
+    char* end = dest.data() + dest.size();
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (i)
+        {
+            *p++ = ',';
+        }
+
+        p = std::to_chars(p, end, in[i]).ptr;
+    }
+
+    dest.resize(p - dest.data());
+}
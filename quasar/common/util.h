@@ -1,9 +1,11 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <regex>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Util
@@ -23,4 +25,26 @@ namespace Util
     }
 
     char* SafeCStrCopy(char* dest, size_t destSize, const char* src, size_t srcSize);
+
+    /*! Appends a string to a JSON string literal, escaping quotes, backslashes and control characters
+        \param[out] dest    String to append to, i.e. a JSON document after an opening quote
+        \param[in]  str     Unescaped string
+    */
+    void  AppendJSONEscaped(std::string& dest, std::string_view str);
+
+    /*! Clamps values to 0.0 to 1.0 and scales them to rounded integers of 0 to max
+        NaN is treated as 0. The loop is branch free and vectorizes in optimized builds.
+        \param[in]  in      Input values
+        \param[in]  n       Number of values
+        \param[in]  max     Integer 1.0 is scaled to, i.e. 255 for 8 bit output
+        \param[out] out     Output integers, n long
+    */
+    void  QuantizeUnit(const double* in, size_t n, uint16_t max, uint16_t* out);
+
+    /*! Appends integers to a string as a comma separated list, i.e. the body of a JSON array
+        \param[out] dest    String to append to
+        \param[in]  in      Integers
+        \param[in]  n       Number of integers
+    */
+    void  AppendIntegers(std::string& dest, const uint16_t* in, size_t n);
 };  // namespace Util
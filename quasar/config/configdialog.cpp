@@ -30,6 +30,7 @@ ConfigDialog::ConfigDialog(QWidget* parent) : QDialog(parent), ui(new Ui::Config
     ui->cookieEdit->setText(QString::fromStdString(Settings::internal.cookies.GetValue()));
     ui->updateCheckBox->setChecked(Settings::internal.update_check.GetValue());
     ui->autoUpdateCheckBox->setChecked(Settings::internal.auto_update.GetValue());
+    ui->extHostCheckBox->setChecked(Settings::internal.exthost.GetValue());
 
     connect(ui->cookieButton, &QPushButton::clicked, [=, this](bool checked) {
         QString filename = QFileDialog::getOpenFileName(this, tr("Choose cookies.txt"), QString(), tr("cookies.txt (*.txt)"));
@@ -198,6 +199,7 @@ void ConfigDialog::SaveSettings()
     Settings::internal.cookies.SetValue(ui->cookieEdit->text().toStdString());
     Settings::internal.update_check.SetValue(ui->updateCheckBox->isChecked());
     Settings::internal.auto_update.SetValue(ui->autoUpdateCheckBox->isChecked());
+    Settings::internal.exthost.SetValue(ui->extHostCheckBox->isChecked());
 
 #ifdef Q_OS_WIN
     QString   startupFolder = QStandardPaths::writableLocation(QStandardPaths::ApplicationsLocation) + "/Startup";
@@ -6,8 +6,10 @@
 
 #include "extension_support_internal.h"
 
+#include "common/util.h"
 #include "server/server.h"
 
+#include <algorithm>
 #include <ranges>
 
 #include <QLibrary>
@@ -87,10 +89,21 @@ Extension::Extension(quasar_ext_info_t* info, extension_destroy destroyfunc, std
             source.settings.name    = topic;
             source.topic            = topic;
             source.validtime        = extensionInfo->dataSources[i].validtime;
+            source.metrics          = &Metrics::Registry::Instance().GetSource(topic);
+            source.recorderName     = FlightRecorder::RegisterName(topic);
+
+            for (size_t v = 0; v < SubscriptionVariantCount; v++)
+            {
+                source.channels[v] = VariantNames[v].empty() ? topic : fmt::format("{}?{}", topic, VariantNames[v]);
+            }
+
+            QUASAR_LOCKABLE_NAME(source.mutex, fmt::format("DataSource {}", topic));
             source.uid = extensionInfo->dataSources[i].uid = ++Extension::_uid;
 
             cfl->ReadDataSourceSetting(&source.settings);
 
+            source.priority = PriorityForRate(source.settings.rate);
+
             // Initialize type specific fields
             if (source.settings.rate == QUASAR_POLLING_SIGNALED)
             {
@@ -138,6 +151,41 @@ Extension::Extension(quasar_ext_info_t* info, extension_destroy destroyfunc, std
     }
 }
 
+TaskPriority Extension::PriorityForRate(int64_t rate)
+{
+    if (rate == QUASAR_POLLING_SIGNALED or (rate > QUASAR_POLLING_CLIENT and rate <= RealtimeRateThreshold))
+    {
+        return TaskPriority::Realtime;
+    }
+
+    return TaskPriority::Normal;
+}
+
+SubscriptionVariant Extension::ParseVariant(std::string_view name)
+{
+    for (size_t v = 0; v < SubscriptionVariantCount; v++)
+    {
+        if (VariantNames[v] == name)
+        {
+            return (SubscriptionVariant) v;
+        }
+    }
+
+    return SubscriptionVariant::Plain;
+}
+
+std::pair<std::string, std::string> Extension::SplitChannel(const std::string& channel)
+{
+    const auto pos = channel.find('?');
+
+    if (pos == std::string::npos)
+    {
+        return {channel, {}};
+    }
+
+    return {channel.substr(0, pos), channel.substr(pos + 1)};
+}
+
 bool Extension::TopicExists(const std::string& topic) const
 {
     return (datasources.count(topic) > 0);
@@ -150,9 +198,9 @@ bool Extension::TopicAcceptsSubscribers(const std::string& topic)
         return false;
     }
 
-    DataSource&                         dsrc = datasources.at(topic);
+    DataSource&                                 dsrc = datasources.at(topic);
 
-    std::shared_lock<std::shared_mutex> lk(dsrc.mutex);
+    std::shared_lock<LockProfiler::SharedMutex> lk(dsrc.mutex);
 
     if (dsrc.settings.rate == QUASAR_POLLING_CLIENT)
     {
@@ -162,8 +210,10 @@ bool Extension::TopicAcceptsSubscribers(const std::string& topic)
     return true;
 }
 
-bool Extension::AddSubscriber(void* subscriber, const std::string& topic, int count)
+bool Extension::AddSubscriber(void* subscriber, const std::string& channel, int count)
 {
+    const auto [topic, variant] = SplitChannel(channel);
+
     if (!subscriber)
     {
         SPDLOG_CRITICAL("Unknown subscriber.");
@@ -185,9 +235,10 @@ bool Extension::AddSubscriber(void* subscriber, const std::string& topic, int co
     }
 
     {
-        std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
+        std::lock_guard<LockProfiler::SharedMutex> lk(dsrc.mutex);
 
-        dsrc.subscribers = count;
+        dsrc.subscribers[(size_t) ParseVariant(variant)] = count;
+        dsrc.metrics->subscribers.store(dsrc.totalSubscribers(), std::memory_order_relaxed);
 
         if (dsrc.settings.rate > QUASAR_POLLING_CLIENT)
         {
@@ -207,8 +258,10 @@ bool Extension::AddSubscriber(void* subscriber, const std::string& topic, int co
     return true;
 }
 
-void Extension::RemoveSubscriber(void* subscriber, const std::string& topic, int count)
+void Extension::RemoveSubscriber(void* subscriber, const std::string& channel, int count)
 {
+    const auto [topic, variant] = SplitChannel(channel);
+
     if (!subscriber)
     {
         SPDLOG_WARN("Null subscriber.");
@@ -221,16 +274,17 @@ void Extension::RemoveSubscriber(void* subscriber, const std::string& topic, int
         return;
     }
 
-    DataSource&                        dsrc = datasources.at(topic);
+    DataSource&                                dsrc = datasources.at(topic);
 
-    std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
+    std::lock_guard<LockProfiler::SharedMutex> lk(dsrc.mutex);
 
     SPDLOG_INFO("Widget unsubscribed from topic {}", dsrc.topic);
 
-    dsrc.subscribers = count;
+    dsrc.subscribers[(size_t) ParseVariant(variant)] = count;
+    dsrc.metrics->subscribers.store(dsrc.totalSubscribers(), std::memory_order_relaxed);
 
     // Stop timer if no subscribers
-    if (dsrc.subscribers <= 0)
+    if (!dsrc.hasSubscribers())
     {
         if (dsrc.timer)
         {
@@ -262,10 +316,10 @@ void Extension::GetMetadataJSON(jsoncons::json& json, bool settings_only)
 
     for (auto&& [key, src] : datasources)
     {
-        std::shared_lock<std::shared_mutex> lk(src.mutex);
+        std::shared_lock<LockProfiler::SharedMutex> lk(src.mutex);
 
-        jsoncons::json                      source(jsoncons::json_object_arg,
-                                 {
+        jsoncons::json                              source(jsoncons::json_object_arg,
+                                         {
                 {   "name",            src.topic},
                 {"enabled", src.settings.enabled},
                 {   "rate",    src.settings.rate}
@@ -364,72 +418,88 @@ void Extension::GetMetadataJSON(jsoncons::json& json, bool settings_only)
 
 void Extension::HandleDataReady(std::string_view source)
 {
-    server->RunOnPool([source = std::string{source}, this] {
-        const auto topic = fmt::format("{}/{}", name, source);
+    const auto topic = fmt::format("{}/{}", name, source);
 
-        if (!datasources.count(topic))
-        {
-            SPDLOG_WARN("Unknown topic {} requested in extension {}", topic, name);
-            return;
-        }
+    if (!datasources.count(topic))
+    {
+        SPDLOG_WARN("Unknown topic {} requested in extension {}", topic, name);
+        return;
+    }
 
-        DataSource&                        data = datasources.at(topic);
+    DataSource&  data = datasources.at(topic);
+    TaskPriority priority;
 
-        std::lock_guard<std::shared_mutex> lk(data.mutex);
+    const auto   signaled = std::chrono::steady_clock::now();
 
-        if (data.settings.rate == QUASAR_POLLING_CLIENT)
-        {
-            // pop poll queue
-            jsoncons::json j{
-                jsoncons::json_object_arg,
-                {{data.topic, jsoncons::json{jsoncons::json_object_arg}}, {"errors", jsoncons::json{jsoncons::json_array_arg}}}
-            };
-            std::string message{};
+    {
+        std::shared_lock<LockProfiler::SharedMutex> lk(data.mutex);
+        priority = data.priority;
+    }
 
-            auto        result = getDataFromSource(j, data);
+    server->RunOnPool(
+        [&data, topic, signaled, this] {
+            std::lock_guard<LockProfiler::SharedMutex> lk(data.mutex);
 
-            if (j[data.topic].empty())
+            if (data.settings.rate == QUASAR_POLLING_CLIENT)
             {
-                j.erase(data.topic);
-            }
+                // pop poll queue
+                jsoncons::json j{
+                    jsoncons::json_object_arg,
+                    {{data.topic, jsoncons::json{jsoncons::json_object_arg}}, {"errors", jsoncons::json{jsoncons::json_array_arg}}}
+                };
+                std::string message{};
 
-            if (j["errors"].empty())
-            {
-                j.erase("errors");
-            }
+                auto        result = getDataFromSource(j, data);
 
-            switch (result)
-            {
-                case GET_DATA_FAILED:
-                    SPDLOG_WARN("getDataFromSource({}) failed in extension {}", topic, name);
-                    break;
-                case GET_DATA_DELAYED:
-                    SPDLOG_WARN("getDataFromSource({}) returned delayed data on signal ready in extension {}", topic, name);
-                    break;
-                case GET_DATA_SUCCESS:
-                    {
-                        if (!j.empty())
-                        {
-                            j.dump(message);
+                if (j[data.topic].empty())
+                {
+                    j.erase(data.topic);
+                }
 
-                            for (auto&& client : data.pollqueue)
+                if (j["errors"].empty())
+                {
+                    j.erase("errors");
+                }
+
+                switch (result)
+                {
+                    case GET_DATA_FAILED:
+                        SPDLOG_WARN("getDataFromSource({}) failed in extension {}", topic, name);
+                        break;
+                    case GET_DATA_DELAYED:
+                        SPDLOG_WARN("getDataFromSource({}) returned delayed data on signal ready in extension {}", topic, name);
+                        break;
+                    case GET_DATA_SUCCESS:
+                        {
+                            if (!j.empty())
                             {
-                                server->SendDataToClient((PerSocketData*) client, message);
+                                {
+                                    Metrics::ScopedTimer t(data.metrics->serialize_us);
+                                    j.dump(message);
+                                }
+
+                                for (auto&& client : data.pollqueue)
+                                {
+                                    server->SendDataToClient((PerSocketData*) client, message);
+                                }
+
+                                data.metrics->published.fetch_add(data.pollqueue.size(), std::memory_order_relaxed);
+                                data.metrics->bytes.fetch_add(message.size() * data.pollqueue.size(), std::memory_order_relaxed);
+
+                                data.pollqueue.clear();
                             }
 
-                            data.pollqueue.clear();
+                            break;
                         }
-
-                        break;
-                    }
+                }
             }
-        }
-        else if (data.settings.rate == QUASAR_POLLING_SIGNALED)
-        {
-            // send to subscribers
-            sendDataToSubscribers(data);
-        }
-    });
+            else if (data.settings.rate == QUASAR_POLLING_SIGNALED)
+            {
+                // send to subscribers
+                sendDataToSubscribers(data, signaled);
+            }
+        },
+        priority);
 }
 
 void Extension::WaitForDataProcessed(std::string_view source)
@@ -456,11 +526,13 @@ void Extension::WaitForDataProcessed(std::string_view source)
     }
 }
 
-Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& msg, DataSource& src, std::string args)
+Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& msg, DataSource& src, std::string args, bool keepSamples, bool keepFrame)
 {
     using namespace std::chrono;
 
     jsoncons::json& j = msg[src.topic];
+    src.sampled       = false;
+    src.frame.clear();
 
     if (!src.settings.enabled)
     {
@@ -478,15 +550,27 @@ Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& ms
         {
             // If data hasn't expired yet, use the cached data
             j = src.cache.data;
+            src.metrics->cache_hits.fetch_add(1, std::memory_order_relaxed);
             return GET_DATA_SUCCESS;
         }
+
+        src.metrics->cache_misses.fetch_add(1, std::memory_order_relaxed);
     }
 
     quasar_return_data_t rett;
+    bool                 success;
 
     // Poll extension for data source
-    if (!extensionInfo->get_data(src.uid, &rett, args.empty() ? nullptr : args.data()))
     {
+        Metrics::ScopedTimer        t(src.metrics->get_data_us);
+        FlightRecorder::ScopedEvent e(FlightRecorder::EventType::GetData, src.recorderName);
+        success = extensionInfo->get_data(src.uid, &rett, args.empty() ? nullptr : args.data());
+    }
+
+    if (!success)
+    {
+        src.metrics->errors.fetch_add(1, std::memory_order_relaxed);
+
         if (!rett.errors.empty())
         {
             msg["errors"].insert(msg["errors"].array_range().end(), rett.errors);
@@ -501,7 +585,7 @@ Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& ms
         msg["errors"].insert(msg["errors"].array_range().end(), rett.errors);
     }
 
-    if (not rett.val)
+    if (not rett.val and rett.numbers.empty() and rett.frame.empty())
     {
         if (src.settings.rate == QUASAR_POLLING_CLIENT)
         {
@@ -513,6 +597,42 @@ Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& ms
         return GET_DATA_FAILED;
     }
 
+    if (not rett.val and !rett.numbers.empty())
+    {
+        if (keepSamples and src.settings.rate != QUASAR_POLLING_CLIENT)
+        {
+            // Floating point array, left to the caller so that it is only converted to JSON if needed
+            src.samples.swap(rett.numbers);
+            src.sampled = true;
+
+            return GET_DATA_SUCCESS;
+        }
+
+        rett.val = jsoncons::json(rett.numbers);
+    }
+
+    if (not rett.val)
+    {
+        // Serialized by an out-of-process extension. Empty and null values are dropped from the frame, so those are parsed
+        if (keepFrame and src.settings.rate != QUASAR_POLLING_CLIENT and rett.frame.size() > 2 and rett.frame != "null")
+        {
+            src.frame.swap(rett.frame);
+
+            return GET_DATA_SUCCESS;
+        }
+
+        try
+        {
+            rett.val = jsoncons::json::parse(rett.frame);
+        } catch (const std::exception& e)
+        {
+            src.metrics->errors.fetch_add(1, std::memory_order_relaxed);
+
+            SPDLOG_WARN("Invalid data from {}: {}", src.topic, e.what());
+            return GET_DATA_FAILED;
+        }
+    }
+
     if (rett.val.value().is_null())
     {
         // Data is purposely set to a null return
@@ -532,18 +652,45 @@ Extension::DataSourceReturnState Extension::getDataFromSource(jsoncons::json& ms
     return GET_DATA_SUCCESS;
 }
 
-void Extension::sendDataToSubscribers(DataSource& src)
+void Extension::sendDataToSubscribers(DataSource& src, std::chrono::steady_clock::time_point tick, std::chrono::steady_clock::time_point deadline)
 {
 #ifdef TRACY_ENABLE
     ZoneScopedS(30);
 #endif
 
+    const auto waitStart = FlightRecorder::Now();
+
     {
-        std::lock_guard<std::shared_mutex> lk(src.mutex);
+        std::lock_guard<LockProfiler::SharedMutex> lk(src.mutex);
+
+        const auto                                 start = std::chrono::steady_clock::now();
+
+        if (FlightRecorder::ToTimestamp(start) - waitStart > LockWaitThreshold)
+        {
+            FlightRecorder::Record(FlightRecorder::EventType::LockWait, src.recorderName, waitStart, FlightRecorder::ToTimestamp(start) - waitStart);
+        }
+
+        FlightRecorder::Record(FlightRecorder::EventType::Tick,
+            src.recorderName,
+            FlightRecorder::ToTimestamp(tick),
+            std::chrono::duration_cast<std::chrono::nanoseconds>(start - tick).count());
+
+        src.metrics->ticks.fetch_add(1, std::memory_order_relaxed);
 
         // Only send if there are subscribers
-        if (src.subscribers > 0)
+        if (src.hasSubscribers() and start > deadline)
         {
+            // Data would already be stale, drop this tick instead of adding to the backlog
+            FlightRecorder::Record(FlightRecorder::EventType::Dropped, src.recorderName, FlightRecorder::ToTimestamp(start));
+
+            auto dropped = src.metrics->dropped.fetch_add(1, std::memory_order_relaxed) + 1;
+
+            SPDLOG_TRACE("Dropped late tick for {} ({} total)", src.topic, dropped);
+        }
+        else if (src.hasSubscribers())
+        {
+            src.metrics->queue_us.Record(std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(start - tick).count(), 0));
+
             src.buffer.clear();
 
             jsoncons::json j{
@@ -551,7 +698,16 @@ void Extension::sendDataToSubscribers(DataSource& src)
                 {{src.topic, jsoncons::json{jsoncons::json_object_arg}}, {"errors", jsoncons::json{jsoncons::json_array_arg}}}
             };
 
-            getDataFromSource(j, src);
+            // the quantized variants replace a numeric array with integers, anything else is sent to them as is
+            const bool quantize = src.hasSubscribers(SubscriptionVariant::UInt8) or src.hasSubscribers(SubscriptionVariant::UInt16);
+            const bool plain    = src.hasSubscribers(SubscriptionVariant::Plain) or src.hasSubscribers(SubscriptionVariant::Trace);
+
+            const auto get_start = Metrics::WallClockMicros();
+
+            // a serialized frame can be published as is unless it has to be quantized
+            getDataFromSource(j, src, {}, quantize, !quantize);
+
+            const auto get_end = Metrics::WallClockMicros();
 
             if (j[src.topic].empty())
             {
@@ -563,11 +719,90 @@ void Extension::sendDataToSubscribers(DataSource& src)
                 j.erase("errors");
             }
 
-            if (!j.empty())
+            if (!j.empty() or src.sampled or !src.frame.empty())
             {
-                j.dump(src.buffer);
+                const bool numeric   = src.sampled or (quantize and gatherSamples(j, src));
+                const bool serialize = plain or (quantize and !numeric);
+
+                size_t     bytes     = 0;
+
+                if (serialize)
+                {
+                    Metrics::ScopedTimer        t(src.metrics->serialize_us);
+                    FlightRecorder::ScopedEvent e(FlightRecorder::EventType::Serialize, src.recorderName);
+
+                    if (src.sampled)
+                    {
+                        j[src.topic] = jsoncons::json(src.samples);
+                    }
 
-                server->PublishData(src.topic, src.buffer);
+                    if (!src.frame.empty())
+                    {
+                        serializeFrame(j, src);
+                    }
+                    else
+                    {
+                        j.dump(src.buffer);
+                    }
+                }
+
+                src.seq++;
+
+                if (serialize)
+                {
+                    FlightRecorder::Record(FlightRecorder::EventType::Publish, src.recorderName, FlightRecorder::Now(), src.buffer.size());
+                }
+
+                if (src.hasSubscribers(SubscriptionVariant::Plain))
+                {
+                    server->PublishData(src.topic, src.buffer);
+                    bytes += src.buffer.size();
+                }
+
+                if (src.hasSubscribers(SubscriptionVariant::Trace))
+                {
+                    Metrics::FrameTrace trace{
+                        .seq       = src.seq,
+                        .tick      = Metrics::ToWallClockMicros(tick),
+                        .get_start = get_start,
+                        .get_end   = get_end,
+                        .ser_end   = Metrics::WallClockMicros(),
+                    };
+
+                    server->PublishTraced(src.channels[(size_t) SubscriptionVariant::Trace], src.buffer, trace, src.metrics);
+                    bytes += src.buffer.size();
+                }
+
+                for (auto [variant, max] : {std::pair{SubscriptionVariant::UInt8, 255}, std::pair{SubscriptionVariant::UInt16, 65535}})
+                {
+                    if (!src.hasSubscribers(variant))
+                    {
+                        continue;
+                    }
+
+                    const std::string& channel = src.channels[(size_t) variant];
+
+                    if (!numeric)
+                    {
+                        server->PublishData(channel, src.buffer);
+                        bytes += src.buffer.size();
+                        continue;
+                    }
+
+                    {
+                        Metrics::ScopedTimer        t(src.metrics->serialize_us);
+                        FlightRecorder::ScopedEvent e(FlightRecorder::EventType::Serialize, src.recorderName);
+                        serializeQuantized(j, src, (uint16_t) max);
+                    }
+
+                    FlightRecorder::Record(FlightRecorder::EventType::Publish, src.recorderName, FlightRecorder::Now(), src.quantizedBuffer.size());
+
+                    server->PublishData(channel, src.quantizedBuffer);
+                    bytes += src.quantizedBuffer.size();
+                }
+
+                src.metrics->published.fetch_add(1, std::memory_order_relaxed);
+                src.metrics->bytes.fetch_add(bytes, std::memory_order_relaxed);
             }
         }
     }
@@ -584,6 +819,80 @@ void Extension::sendDataToSubscribers(DataSource& src)
     }
 }
 
+bool Extension::gatherSamples(const jsoncons::json& msg, DataSource& src)
+{
+    if (!msg.contains(src.topic))
+    {
+        return false;
+    }
+
+    const auto& data = msg[src.topic];
+
+    if (!data.is_array() or data.empty())
+    {
+        return false;
+    }
+
+    src.samples.clear();
+    src.samples.reserve(data.size());
+
+    for (const auto& x : data.array_range())
+    {
+        if (!x.is_number())
+        {
+            return false;
+        }
+
+        src.samples.push_back(x.as<double>());
+    }
+
+    return true;
+}
+
+void Extension::serializeFrame(const jsoncons::json& msg, DataSource& src)
+{
+    // {"topic":<frame>,"errors":[...]}, the frame is already JSON
+    auto& out = src.buffer;
+
+    out.clear();
+    out += '{';
+    jsoncons::json(src.topic).dump(out);
+    out += ':';
+    out += src.frame;
+
+    if (msg.contains("errors"))
+    {
+        out += ",\"errors\":";
+        msg["errors"].dump(out);
+    }
+
+    out += '}';
+}
+
+void Extension::serializeQuantized(const jsoncons::json& msg, DataSource& src, uint16_t max)
+{
+    src.quantized.resize(src.samples.size());
+    Util::QuantizeUnit(src.samples.data(), src.samples.size(), max, src.quantized.data());
+
+    // {"topic":[...],"errors":[...]}, written directly as the integers dominate the frame
+    auto& out = src.quantizedBuffer;
+
+    out.clear();
+    out += '{';
+    jsoncons::json(src.topic).dump(out);
+    out += ":[";
+    Util::AppendIntegers(out, src.quantized.data(), src.quantized.size());
+    out += ']';
+
+    if (msg.contains("errors"))
+    {
+        out += ",\"errors\":";
+        msg["errors"].dump(out);
+    }
+
+    out += '}';
+}
+
 void Extension::createTimer(DataSource& src)
 {
     if (src.settings.enabled and !src.timer)
@@ -592,12 +901,12 @@ void Extension::createTimer(DataSource& src)
         src.timer = std::make_unique<Timer>(src.topic);
 
         src.timer->setInterval(
-            [this, &src] {
+            [this, &src](std::chrono::steady_clock::time_point deadline) {
 #ifdef TRACY_ENABLE
                 FrameMarkStart(src.topic.data());
 #endif
 
-                sendDataToSubscribers(src);
+                sendDataToSubscribers(src, deadline - std::chrono::microseconds(src.settings.rate), deadline);
 
 #ifdef TRACY_ENABLE
                 FrameMarkEnd(src.topic.data());
@@ -627,7 +936,7 @@ void Extension::WriteDataSourceSettings()
     auto cfl = config.lock();
     for (auto&& [name, source] : datasources)
     {
-        std::shared_lock<std::shared_mutex> lk(source.mutex);
+        std::shared_lock<LockProfiler::SharedMutex> lk(source.mutex);
         cfl->WriteDataSourceSetting(&source.settings);
     }
 }
@@ -648,11 +957,14 @@ void Extension::UpdateExtensionSettings()
             // Send the payload
             for (auto&& [name, source] : datasources)
             {
-                std::shared_lock<std::shared_mutex> lk(source.mutex);
+                std::shared_lock<LockProfiler::SharedMutex> lk(source.mutex);
 
-                if (source.subscribers > 0)
+                for (size_t v = 0; v < SubscriptionVariantCount; v++)
                 {
-                    server->PublishData(source.topic, payload);
+                    if (source.subscribers[v] > 0)
+                    {
+                        server->PublishData(source.channels[v], payload);
+                    }
                 }
             }
         }
@@ -682,9 +994,11 @@ void Extension::refreshDataSources()
 {
     for (auto&& [name, src] : datasources)
     {
-        std::lock_guard<std::shared_mutex> lk(src.mutex);
+        std::lock_guard<LockProfiler::SharedMutex> lk(src.mutex);
+
+        src.priority = PriorityForRate(src.settings.rate);
 
-        if (src.settings.enabled and src.settings.rate > QUASAR_POLLING_CLIENT and src.subscribers > 0)
+        if (src.settings.enabled and src.settings.rate > QUASAR_POLLING_CLIENT and src.hasSubscribers())
         {
             // Create timer if not exist
             createTimer(src);
@@ -719,6 +1033,11 @@ Extension::~Extension()
             src.timer.reset();
         }
 
+        if (auto dropped = src.metrics->dropped.load(); dropped > 0)
+        {
+            SPDLOG_INFO("Topic {} dropped {} late ticks", src.topic, dropped);
+        }
+
         src.locks.reset();
         cfl->WriteDataSourceSetting(&src.settings);
     }
@@ -802,6 +1121,26 @@ Extension* Extension::LoadInternal(std::string_view name, extension_load loadFun
     return nullptr;
 }
 
+Extension* Extension::LoadProxied(std::string_view libpath, quasar_ext_info_t* info, extension_destroy destroyFunc, std::shared_ptr<Config> cfg, Server* srv)
+{
+    if (!info or !destroyFunc)
+    {
+        SPDLOG_WARN("Failed to resolve extension API in {}", libpath);
+        return nullptr;
+    }
+
+    try
+    {
+        Extension* extension = new Extension(info, destroyFunc, libpath, srv, cfg);
+        return extension;
+    } catch (std::exception e)
+    {
+        SPDLOG_WARN("Exception: {} while allocating {}", e.what(), libpath);
+    }
+
+    return nullptr;
+}
+
 void Extension::Initialize()
 {
     if (!initialized)
@@ -833,9 +1172,9 @@ void Extension::PollDataForSending(jsoncons::json& json, const std::vector<std::
             continue;
         }
 
-        DataSource&                        dsrc = datasources.at(topic);
+        DataSource&                                dsrc = datasources.at(topic);
 
-        std::lock_guard<std::shared_mutex> lk(dsrc.mutex);
+        std::lock_guard<LockProfiler::SharedMutex> lk(dsrc.mutex);
 
         json[dsrc.topic] = jsoncons::json{jsoncons::json_object_arg};
 
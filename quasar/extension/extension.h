@@ -1,19 +1,29 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <numeric>
 #include <set>
 #include <shared_mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "api/extension_types.h"
 #include "common/config.h"
+#include "common/flightrecorder.h"
+#include "common/lockprofiler.h"
+#include "common/metrics.h"
 #include "common/settings.h"
+#include "common/threadpool.h"
 #include "common/timer.h"
 
 #include <jsoncons/json.hpp>
@@ -32,6 +42,19 @@ struct DataLock
     bool                    processed = false;  //!< Bool value to trigger conditional variable notification
 };
 
+//! Subscription variant of a Data Source, selected with the params of a subscribe request \sa Extension::VariantNames
+enum class SubscriptionVariant : uint8_t
+{
+    Plain,   //!< Frames as returned by the extension
+    Trace,   //!< Frames with trace timestamps \sa Metrics::FrameTrace
+    UInt8,   //!< Numeric arrays clamped to 0.0 to 1.0 and quantized to 0 to 255
+    UInt16,  //!< Numeric arrays clamped to 0.0 to 1.0 and quantized to 0 to 65535
+    Count
+};
+
+//! Number of subscription variants
+constexpr size_t SubscriptionVariantCount = (size_t) SubscriptionVariant::Count;
+
 //! Struct containing cached data for a Data Source
 struct DataCache
 {
@@ -53,20 +76,41 @@ struct DataSource
     uint64_t    validtime;  //!< Data validity duration for \ref QUASAR_POLLING_CLIENT. \sa quasar_data_source_t.rate, quasar_data_source_t.validtime,
                             //!< quasar_polling_type_t
 
+    TaskPriority priority;  //!< Worker pool scheduling class, derived from the refresh rate \sa Extension::PriorityForRate()
+
     // subscription type source fields
-    std::unique_ptr<Timer> timer;        //!< Timer for timer based subscription sources
-    int                    subscribers;  //!< Number of subscribers currently subscribed to this source
+    std::unique_ptr<Timer>                            timer;        //!< Timer for timer based subscription sources
+    std::array<int, SubscriptionVariantCount>         subscribers;  //!< Number of subscribers currently subscribed to every variant of this source
+    std::array<std::string, SubscriptionVariantCount> channels;     //!< Channel name of every variant of this source, i.e. topic?u8
+    uint64_t                                          seq;          //!< Sequence number of the last published frame
+    std::vector<double>                               samples;      //!< Numeric array of the last frame, input of the quantized variants
+    bool                                              sampled;      //!< Whether the data of the last frame is only in samples, not in its JSON message
+    std::string                                       frame;        //!< Data of the last frame as serialized by an out-of-process extension, if kept as is
+    std::vector<uint16_t>                             quantized;    //!< Quantized samples of the last frame
+
+    Metrics::SourceMetrics* metrics;       //!< Registry entry for this source, includes dropped tick counts \sa Metrics::Registry
+    uint16_t                recorderName;  //!< Flight recorder name id of the topic \sa FlightRecorder::RegisterName()
 
     // poll type
     std::unordered_set<void*> pollqueue;  //!< Queue of widgets (i.e. its WebSocket instance) waiting for polled data
     DataCache                 cache;      //!< Cached data for polled data with a validity duration
 
-    mutable std::shared_mutex mutex;  //!< Data Source level lock
+    mutable QUASAR_SHARED_LOCKABLE(mutex, "DataSource::mutex");  //!< Data Source level lock, renamed to the topic when profiling
 
-    std::string               buffer;
+    std::string               buffer;           //!< Serialized frame of the plain and traced variants
+    std::string               quantizedBuffer;  //!< Serialized frame of the quantized variants
 
     // signaled type source fields
     std::unique_ptr<DataLock> locks;  //!< Mutex/cv for asynchronous or extension signaled sources \sa DataLock
+
+    //! Total number of subscribers to all variants, must hold mutex
+    int                       totalSubscribers() const { return std::accumulate(subscribers.begin(), subscribers.end(), 0); }
+
+    //! Checks whether a variant has subscribers, must hold mutex
+    bool                      hasSubscribers(SubscriptionVariant variant) const { return subscribers[(size_t) variant] > 0; }
+
+    //! Checks whether any variant has subscribers, must hold mutex
+    bool                      hasSubscribers() const { return totalSubscribers() > 0; }
 };
 
 class Extension
@@ -97,6 +141,35 @@ public:
     //! Data Source uid counter
     static size_t _uid;
 
+    //! Names of the subscription variants, as passed in the params of a subscribe request and appended to channel names
+    static constexpr std::array<std::string_view, SubscriptionVariantCount> VariantNames = {"", "trace", "u8", "u16"};
+
+    /*! Looks up a subscription variant by name
+        \param[in]  name    Variant name \sa VariantNames
+        \return The variant, or SubscriptionVariant::Plain for unknown names
+    */
+    static SubscriptionVariant ParseVariant(std::string_view name);
+
+    /*! Splits a subscription channel into its topic and variant
+        i.e. "ext/source?trace" becomes {"ext/source", "trace"}
+        \param[in]  channel     Channel name
+        \return Topic and variant, the variant is empty for plain topics
+    */
+    static std::pair<std::string, std::string> SplitChannel(const std::string& channel);
+
+    //! Data Source lock waits longer than this (in nanoseconds) are recorded in the flight recorder
+    static constexpr int64_t LockWaitThreshold = 1000;
+
+    //! Timer rates at or below this value (in microseconds) are scheduled as TaskPriority::Realtime
+    static constexpr int64_t RealtimeRateThreshold = 100000;
+
+    /*! Derives the worker pool scheduling class of a Data Source from its refresh rate
+        Signaled sources and fast timers are Realtime, everything else is Normal.
+        \param[in]  rate    Refresh rate \sa quasar_data_source_t.rate, quasar_polling_type_t
+        \return Scheduling class
+    */
+    static TaskPriority PriorityForRate(int64_t rate);
+
     //! Load an extension
     /*!
         \param[in]  libpath Path to library file
@@ -113,6 +186,15 @@ public:
     */
     static Extension* LoadInternal(std::string_view name, extension_load loadFunc, extension_destroy destroyFunc, std::shared_ptr<Config> cfg, Server* srv);
 
+    //! Wraps an extension that is loaded elsewhere (i.e. in a quasar-exthost process)
+    /*!
+        \param[in]  libpath     Path to library file
+        \param[in]  info        Extension info struct provided by the proxy
+        \param[in]  destroyFunc Destroy function
+        \return Pointer to a Extension instance if successful, nullptr otherwise
+    */
+    static Extension* LoadProxied(std::string_view libpath, quasar_ext_info_t* info, extension_destroy destroyFunc, std::shared_ptr<Config> cfg, Server* srv);
+
     /*! Initializes the extension
         Throws an exception if failed.
     */
@@ -153,20 +235,20 @@ public:
     //! Adds a subscriber to a Data Source
     /*!
         \param[in]  subscriber  Subscriber's websocket connection instance
-        \param[in]  topic       Topic
+        \param[in]  channel     Topic, optionally followed by a variant \sa SplitChannel()
         \param[in]  count       Current subscriber count
         \param[in]  widgetName  Widget name
         \return true if successful, false otherwise
     */
-    bool AddSubscriber(void* subscriber, const std::string& topic, int count);
+    bool AddSubscriber(void* subscriber, const std::string& channel, int count);
 
     //! Removes a subscriber from a Data Sources
     /*! Invoked when a widget is closed or disconnects
         \param[in]  subscriber  Subscriber's websocket connection instance
-        \param[in]  topic       Topic
+        \param[in]  channel     Topic, optionally followed by a variant \sa SplitChannel()
         \param[in]  count       Current subscriber count
     */
-    void                   RemoveSubscriber(void* subscriber, const std::string& topic, int count);
+    void                   RemoveSubscriber(void* subscriber, const std::string& channel, int count);
 
     SettingsVariantVector& GetSettings() { return settings; };
 
@@ -235,19 +317,48 @@ private:
     Extension(quasar_ext_info_t* info, extension_destroy destroyfunc, std::string_view path, Server* srv, std::shared_ptr<Config> cfg, bool isInternal = false);
 
     /*! Retrieves data from a data source and saves it to the supplied JSON object as JSON data
-        \param[in]  msg     Reference to the JSON object to save data to
-        \param[in]  src     Reference to the Data Source object
-        \param[in]  args    Arguments, if any
+        \param[in]  msg         Reference to the JSON object to save data to
+        \param[in]  src         Reference to the Data Source object
+        \param[in]  args        Arguments, if any
+        \param[in]  keepSamples Leave a floating point array in DataSource.samples instead of msg, see DataSource.sampled
+        \param[in]  keepFrame   Leave data serialized by an out-of-process extension in DataSource.frame instead of parsing it into msg
         \return DataSourceReturnState value determining state of data retrieval
         \sa DataSourceReturnState
     */
-    DataSourceReturnState getDataFromSource(jsoncons::json& msg, DataSource& src, std::string args = {});
+    DataSourceReturnState getDataFromSource(jsoncons::json& msg, DataSource& src, std::string args = {}, bool keepSamples = false, bool keepFrame = false);
 
     //! Retrieves data from the extension and sends it to all subscribers
     /*! Called when extension data is ready to be sent (by both timer and signal)
+        If deadline has already passed by the time get_data would be called, the data is not
+        retrieved and the tick is counted in SourceMetrics.dropped instead.
+        \param[in]  src         Data Source
+        \param[in]  tick        Time the timer tick was scheduled or the data ready signal was received
+        \param[in]  deadline    Time by which get_data has to start
+    */
+    void sendDataToSubscribers(DataSource& src,
+        std::chrono::steady_clock::time_point tick,
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+
+    /*! Copies the data of a source into DataSource.samples if it is an array of numbers, must hold mutex
+        \param[in]  msg     JSON object holding the data of the source
+        \param[in]  src     Data Source
+        \return true if the data is a non-empty array of numbers
+    */
+    bool gatherSamples(const jsoncons::json& msg, DataSource& src);
+
+    /*! Serializes DataSource.frame into DataSource.buffer without parsing it, must hold mutex
+        \param[in]  msg     JSON object holding the data of the source, for its errors
+        \param[in]  src     Data Source
+    */
+    void serializeFrame(const jsoncons::json& msg, DataSource& src);
+
+    /*! Serializes DataSource.samples quantized to 0 to max into DataSource.quantizedBuffer, must hold mutex
+        \param[in]  msg     JSON object holding the data of the source, for its errors
         \param[in]  src     Data Source
+        \param[in]  max     Integer 1.0 is scaled to
+        \sa Util::QuantizeUnit()
     */
-    void sendDataToSubscribers(DataSource& src);
+    void serializeQuantized(const jsoncons::json& msg, DataSource& src, uint16_t max);
 
     /*! Creates and initializes the timer for a timer-based source (if it does not exist)
         \param[in,out]  src     Reference to the Data Source object
@@ -14,11 +14,6 @@
 
 #define EXTKEY(key) fmt::format("{}/{}", ext->GetName(), key)
 
-char* quasar_strcpy(char* dest, size_t destSize, const char* src, size_t srcSize)
-{
-    return Util::SafeCStrCopy(dest, destSize, src, srcSize);
-}
-
 void quasar_log(quasar_log_level_t level, const char* msg)
 {
     switch (level)
@@ -54,155 +49,6 @@ quasar_settings_t* quasar_create_settings(quasar_ext_handle handle)
     return nullptr;
 }
 
-quasar_selection_options_t* quasar_create_selection_setting(void)
-{
-    return (quasar_selection_options_t*) new SelectionOptionsVector{};
-}
-
-void quasar_free_selection_setting(quasar_selection_options_t* handle)
-{
-    SelectionOptionsVector* container = reinterpret_cast<SelectionOptionsVector*>(handle);
-
-    if (container)
-    {
-        delete container;
-    }
-}
-
-quasar_data_handle quasar_set_data_string(quasar_data_handle hData, const char* data)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = std::string{data};
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-template<typename T>
-quasar_data_handle _set_basic_json_type(quasar_data_handle hData, T data)
-    requires std::is_same_v<double, T> || std::is_same_v<int, T> || std::is_same_v<bool, T>
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = data;
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_int(quasar_data_handle hData, int data)
-{
-    return _set_basic_json_type(hData, data);
-}
-
-quasar_data_handle quasar_set_data_double(quasar_data_handle hData, double data)
-{
-    return _set_basic_json_type(hData, data);
-}
-
-quasar_data_handle quasar_set_data_bool(quasar_data_handle hData, bool data)
-{
-    return _set_basic_json_type(hData, data);
-}
-
-quasar_data_handle quasar_set_data_json(quasar_data_handle hData, const char* data)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json::parse(data);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_string_array(quasar_data_handle hData, char** arr, size_t len)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        std::vector<std::string> arrcpy(arr, arr + len);
-        ref->val = jsoncons::json(arrcpy);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-template<typename T>
-quasar_data_handle _copy_basic_array(quasar_data_handle hData, T* arr, size_t len)
-    requires std::is_same_v<double, T> || std::is_same_v<int, T> || std::is_same_v<float, T>
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json{jsoncons::json_array_arg};
-        ref->val.value().insert(ref->val.value().array_range().end(), arr, arr + len);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_int_array(quasar_data_handle hData, int* arr, size_t len)
-{
-    return _copy_basic_array(hData, arr, len);
-}
-
-quasar_data_handle quasar_set_data_float_array(quasar_data_handle hData, float* arr, size_t len)
-{
-    return _copy_basic_array(hData, arr, len);
-}
-
-quasar_data_handle quasar_set_data_double_array(quasar_data_handle hData, double* arr, size_t len)
-{
-    return _copy_basic_array(hData, arr, len);
-}
-
-quasar_data_handle quasar_set_data_null(quasar_data_handle hData)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json::null();
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_append_error(quasar_data_handle hData, const char* err)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->errors.push_back(err);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
 quasar_settings_t*
 quasar_add_int_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name, const char* description, int min, int max, int step, int dflt)
 {
@@ -307,20 +153,6 @@ quasar_settings_t* quasar_add_selection_setting(quasar_ext_handle handle,
     return nullptr;
 }
 
-quasar_selection_options_t* quasar_add_selection_option(quasar_selection_options_t* select, const char* name, const char* value)
-{
-    SelectionOptionsVector* container = reinterpret_cast<SelectionOptionsVector*>(select);
-
-    if (container)
-    {
-        container->push_back(std::make_pair<std::string, std::string>(value, name));
-
-        return select;
-    }
-
-    return nullptr;
-}
-
 intmax_t quasar_get_int_setting(quasar_ext_handle handle, quasar_settings_t* settings, const char* name)
 {
     SettingsVariantVector* container = reinterpret_cast<SettingsVariantVector*>(settings);
@@ -627,90 +459,6 @@ bool quasar_get_storage_bool(quasar_ext_handle handle, const char* name, bool* b
     return _get_basic_storage(handle, name, buf);
 }
 
-quasar_data_handle quasar_set_data_string_hpp(quasar_data_handle hData, std::string_view data)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json(data);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_json_hpp(quasar_data_handle hData, std::string_view data)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json::parse(data);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_string_vector(quasar_data_handle hData, const std::vector<std::string>& vec)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json(vec);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_int_vector(quasar_data_handle hData, const std::vector<int>& vec)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json(vec);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_float_vector(quasar_data_handle hData, const std::vector<float>& vec)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json(vec);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
-quasar_data_handle quasar_set_data_double_vector(quasar_data_handle hData, const std::vector<double>& vec)
-{
-    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
-
-    if (ref)
-    {
-        ref->val = jsoncons::json(vec);
-
-        return ref;
-    }
-
-    return nullptr;
-}
-
 std::string_view quasar_get_string_setting_hpp(quasar_ext_handle handle, quasar_settings_t* settings, std::string_view name)
 {
     SettingsVariantVector* container = reinterpret_cast<SettingsVariantVector*>(settings);
@@ -0,0 +1,271 @@
+/*! \file
+    \brief Extension support functions that do not depend on an Extension instance.
+    Shared by Quasar and quasar-exthost.
+*/
+
+#include "api/extension_support.h"
+
+#include "extension_support.hpp"
+#include "extension_support_internal.h"
+
+#include "common/util.h"
+
+char* quasar_strcpy(char* dest, size_t destSize, const char* src, size_t srcSize)
+{
+    return Util::SafeCStrCopy(dest, destSize, src, srcSize);
+}
+
+quasar_selection_options_t* quasar_create_selection_setting(void)
+{
+    return (quasar_selection_options_t*) new SelectionOptionsVector{};
+}
+
+void quasar_free_selection_setting(quasar_selection_options_t* handle)
+{
+    SelectionOptionsVector* container = reinterpret_cast<SelectionOptionsVector*>(handle);
+
+    if (container)
+    {
+        delete container;
+    }
+}
+
+quasar_data_handle quasar_set_data_string(quasar_data_handle hData, const char* data)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = std::string{data};
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+template<typename T>
+quasar_data_handle _set_basic_json_type(quasar_data_handle hData, T data)
+    requires std::is_same_v<double, T> || std::is_same_v<int, T> || std::is_same_v<bool, T>
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = data;
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_int(quasar_data_handle hData, int data)
+{
+    return _set_basic_json_type(hData, data);
+}
+
+quasar_data_handle quasar_set_data_double(quasar_data_handle hData, double data)
+{
+    return _set_basic_json_type(hData, data);
+}
+
+quasar_data_handle quasar_set_data_bool(quasar_data_handle hData, bool data)
+{
+    return _set_basic_json_type(hData, data);
+}
+
+quasar_data_handle quasar_set_data_json(quasar_data_handle hData, const char* data)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = jsoncons::json::parse(data);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_string_array(quasar_data_handle hData, char** arr, size_t len)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        std::vector<std::string> arrcpy(arr, arr + len);
+        ref->val = jsoncons::json(arrcpy);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+template<typename T>
+quasar_data_handle _copy_basic_array(quasar_data_handle hData, T* arr, size_t len)
+    requires std::is_same_v<int, T>
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = jsoncons::json{jsoncons::json_array_arg};
+        ref->val.value().insert(ref->val.value().array_range().end(), arr, arr + len);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+template<typename T>
+quasar_data_handle _copy_number_array(quasar_data_handle hData, const T* arr, size_t len)
+    requires std::is_same_v<double, T> || std::is_same_v<float, T>
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        // kept as is, Extension only converts it to JSON for the subscribers that need it
+        if (len)
+        {
+            ref->val.reset();
+            ref->numbers.assign(arr, arr + len);
+        }
+        else
+        {
+            ref->val = jsoncons::json{jsoncons::json_array_arg};
+            ref->numbers.clear();
+        }
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_int_array(quasar_data_handle hData, int* arr, size_t len)
+{
+    return _copy_basic_array(hData, arr, len);
+}
+
+quasar_data_handle quasar_set_data_float_array(quasar_data_handle hData, float* arr, size_t len)
+{
+    return _copy_number_array(hData, arr, len);
+}
+
+quasar_data_handle quasar_set_data_double_array(quasar_data_handle hData, double* arr, size_t len)
+{
+    return _copy_number_array(hData, arr, len);
+}
+
+quasar_data_handle quasar_set_data_null(quasar_data_handle hData)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = jsoncons::json::null();
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_append_error(quasar_data_handle hData, const char* err)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->errors.push_back(err);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_selection_options_t* quasar_add_selection_option(quasar_selection_options_t* select, const char* name, const char* value)
+{
+    SelectionOptionsVector* container = reinterpret_cast<SelectionOptionsVector*>(select);
+
+    if (container)
+    {
+        container->push_back(std::make_pair<std::string, std::string>(value, name));
+
+        return select;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_string_hpp(quasar_data_handle hData, std::string_view data)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = jsoncons::json(data);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_json_hpp(quasar_data_handle hData, std::string_view data)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = jsoncons::json::parse(data);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_string_vector(quasar_data_handle hData, const std::vector<std::string>& vec)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = jsoncons::json(vec);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_int_vector(quasar_data_handle hData, const std::vector<int>& vec)
+{
+    quasar_return_data_t* ref = static_cast<quasar_return_data_t*>(hData);
+
+    if (ref)
+    {
+        ref->val = jsoncons::json(vec);
+
+        return ref;
+    }
+
+    return nullptr;
+}
+
+quasar_data_handle quasar_set_data_float_vector(quasar_data_handle hData, const std::vector<float>& vec)
+{
+    return _copy_number_array(hData, vec.data(), vec.size());
+}
+
+quasar_data_handle quasar_set_data_double_vector(quasar_data_handle hData, const std::vector<double>& vec)
+{
+    return _copy_number_array(hData, vec.data(), vec.size());
+}
@@ -19,6 +19,10 @@ using SelectionOptionsVector = std::vector<std::pair<std::string, std::string>>;
 //! Internal struct holding return value and any errors
 struct quasar_return_data_t
 {
-    std::optional<jsoncons::json> val;     //!< Return value
-    std::vector<std::string>      errors;  //!< Array of errors
+    std::optional<jsoncons::json> val;      //!< Return value
+    std::vector<double>           numbers;  //!< Non-empty floating point array return value, kept out of val so that it can be
+                                            //!< quantized without building a JSON array first. val takes precedence if both are set
+    std::string                   frame;    //!< Return value already serialized as JSON, i.e. by quasar-exthost, so that it can be
+                                            //!< published without parsing it. val and numbers take precedence if set
+    std::vector<std::string>      errors;   //!< Array of errors
 };
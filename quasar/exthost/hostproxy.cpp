@@ -0,0 +1,817 @@
+#include "hostproxy.h"
+
+#include "api/extension_support.h"
+
+#include "common/config.h"
+
+#include "extension/extension.h"
+#include "extension/extension_support_internal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <variant>
+
+#include <QCoreApplication>
+
+#include <spdlog/spdlog.h>
+
+#include <fmt/core.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+extern char** environ;
+
+namespace ExtHost
+{
+    namespace
+    {
+        //! Time to wait for the host process to report in
+        constexpr int  HelloTimeoutMs   = 5000;
+
+        //! Time to wait for the host to reply to a request before it is considered hung
+        constexpr auto RequestTimeout   = std::chrono::seconds(10);
+
+        //! Copies a JSON string into a fixed size char array
+        template<size_t N>
+        void copy_field(char (&dest)[N], const jsoncons::json& j, std::string_view key)
+        {
+            auto val = j.get_value_or<std::string>(key, std::string{});
+            quasar_strcpy(dest, N, val.data(), val.size());
+        }
+    }  // namespace
+
+    std::mutex                               HostProxy::registryMutex;
+    std::vector<std::unique_ptr<HostProxy>> HostProxy::proxies;
+
+    HostProxy::HostProxy(const std::string& path) : libpath{path} {}
+
+    HostProxy::~HostProxy()
+    {
+        if (sock >= 0)
+        {
+            ::shutdown(sock, SHUT_RDWR);
+        }
+
+        if (reader.joinable())
+        {
+            reader.join();
+        }
+
+        if (waiter.joinable())
+        {
+            waiter.request_stop();
+            waiter.join();
+        }
+
+        if (sock >= 0)
+        {
+            close(sock);
+            sock = -1;
+        }
+
+        if (pid > 0)
+        {
+            // give the host a moment to exit on its own
+            using namespace std::chrono_literals;
+
+            int  status = 0;
+            bool exited = false;
+
+            for (int i = 0; i < 20 and !exited; i++)
+            {
+                exited = (waitpid(pid, &status, WNOHANG) == pid);
+
+                if (!exited)
+                {
+                    std::this_thread::sleep_for(50ms);
+                }
+            }
+
+            if (!exited)
+            {
+                SPDLOG_WARN("Extension host for {} did not exit, killing pid {}", libpath, pid);
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+            }
+        }
+    }
+
+    Extension* HostProxy::Load(const std::string& libpath, std::shared_ptr<Config> cfg, Server* srv)
+    {
+        HostProxy* proxy = new HostProxy(libpath);
+
+        if (!proxy->spawn(cfg))
+        {
+            delete proxy;
+            return nullptr;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(registryMutex);
+            proxies.emplace_back(proxy);
+        }
+
+        Extension* extension = Extension::LoadProxied(libpath, &proxy->info, &HostProxy::destroy, cfg, srv);
+
+        if (!extension)
+        {
+            destroy(&proxy->info);
+        }
+
+        return extension;
+    }
+
+    bool HostProxy::spawn(std::shared_ptr<Config> cfg)
+    {
+        int fds[2];
+
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+        {
+            SPDLOG_WARN("socketpair() failed for {}: {}", libpath, strerror(errno));
+            return false;
+        }
+
+        // make sure the child end does not already sit on HostSocketFd, as dup2 would then keep FD_CLOEXEC
+        int childfd = fcntl(fds[1], F_DUPFD_CLOEXEC, HostSocketFd + 1);
+        close(fds[1]);
+
+        sock                 = fds[0];
+
+        const auto shmname   = fmt::format("/quasar-exthost-{}-{}", getpid(), (void*) this);
+
+        if (childfd < 0 or !ring.Create(shmname))
+        {
+            SPDLOG_WARN("Failed to create data plane for {}", libpath);
+
+            if (childfd >= 0)
+            {
+                close(childfd);
+            }
+
+            return false;
+        }
+
+        // Per extension resource limits
+        const auto  group    = fmt::format("exthost/{}", std::filesystem::path(libpath).stem().string());
+        const auto  cpus     = cfg->ReadGenericStorage<std::string>(group, "cpus");
+        const auto  nice     = cfg->ReadGenericStorage<int>(group, "nice");
+        const auto  memlimit = cfg->ReadGenericStorage<int>(group, "memlimit");
+
+        const auto  exe      = (QCoreApplication::applicationDirPath() + "/quasar-exthost").toStdString();
+
+        std::vector<std::string> args{exe, "--shm", shmname};
+
+        if (!cpus.empty())
+        {
+            args.insert(args.end(), {"--cpus", cpus});
+        }
+
+        if (nice)
+        {
+            args.insert(args.end(), {"--nice", std::to_string(nice)});
+        }
+
+        if (memlimit > 0)
+        {
+            args.insert(args.end(), {"--memlimit", std::to_string(memlimit)});
+        }
+
+        args.push_back(libpath);
+
+        std::vector<char*> argv;
+
+        for (auto& a : args)
+        {
+            argv.push_back(a.data());
+        }
+
+        argv.push_back(nullptr);
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, childfd, HostSocketFd);
+
+        int result = posix_spawn(&pid, exe.c_str(), &actions, nullptr, argv.data(), environ);
+
+        posix_spawn_file_actions_destroy(&actions);
+        close(childfd);
+
+        if (result != 0)
+        {
+            SPDLOG_WARN("Failed to spawn {} for {}: {}", exe, libpath, strerror(result));
+            pid = -1;
+            return false;
+        }
+
+        // Wait for Hello
+        pollfd pfd{.fd = sock, .events = POLLIN, .revents = 0};
+
+        if (poll(&pfd, 1, HelloTimeoutMs) <= 0)
+        {
+            SPDLOG_WARN("Extension host for {} did not respond", libpath);
+            kill(pid, SIGKILL);
+            return false;
+        }
+
+        MessageHeader header;
+        std::string   payload;
+
+        if (!ReceiveMessage(sock, header, payload) or header.type != MessageType::Hello or !parseHello(payload))
+        {
+            SPDLOG_WARN("Extension host for {} failed to load the extension", libpath);
+            kill(pid, SIGKILL);
+            return false;
+        }
+
+        // The host has the region mapped now, so the name is no longer needed
+        ring.Unlink();
+
+        connected = true;
+
+        reader    = std::jthread([this] {
+            readLoop();
+        });
+
+        waiter    = std::jthread([this](std::stop_token stoken) {
+            waitLoop(stoken);
+        });
+
+        SPDLOG_INFO("Extension host for {} running as pid {}", libpath, pid);
+
+        return true;
+    }
+
+    bool HostProxy::parseHello(const std::string& payload)
+    {
+        try
+        {
+            auto        j   = jsoncons::json::parse(payload);
+            const auto& fld = j.at("fields");
+
+            copy_field(fields.name, fld, "name");
+            copy_field(fields.fullname, fld, "fullname");
+            copy_field(fields.version, fld, "version");
+            copy_field(fields.author, fld, "author");
+            copy_field(fields.description, fld, "description");
+            copy_field(fields.url, fld, "url");
+
+            for (const auto& src : j.at("sources").array_range())
+            {
+                quasar_data_source_t s{};
+
+                copy_field(s.name, src, "name");
+                s.rate      = src.at("rate").as<int64_t>();
+                s.validtime = src.at("validtime").as<uint64_t>();
+
+                sources.push_back(s);
+            }
+
+            settingsDefs             = j.get_value_or<jsoncons::json>("settings", jsoncons::json::null());
+
+            info.api_version         = QUASAR_API_VERSION;
+            info.fields              = &fields;
+            info.numDataSources      = sources.size();
+            info.dataSources         = sources.data();
+            info.init                = &HostProxy::init;
+            info.shutdown            = &HostProxy::shutdown;
+            info.get_data            = &HostProxy::get_data;
+            info.create_settings     = settingsDefs.is_array() ? &HostProxy::create_settings : nullptr;
+            info.update              = j.get_value_or<bool>("update", false) ? &HostProxy::update : nullptr;
+
+        } catch (std::exception& e)
+        {
+            SPDLOG_WARN("Invalid Hello from extension host for {}: {}", libpath, e.what());
+            return false;
+        }
+
+        return true;
+    }
+
+    std::optional<std::string> HostProxy::request(MessageType type, std::string_view payload)
+    {
+        std::future<std::optional<std::string>> result;
+        const uint64_t                           seq = ++nextSeq;
+
+        {
+            std::lock_guard<std::mutex> lk(pendingMutex);
+
+            if (!connected)
+            {
+                return std::nullopt;
+            }
+
+            result = pending[seq].get_future();
+        }
+
+        bool sent = false;
+
+        {
+            std::lock_guard<std::mutex> lk(sendMutex);
+            sent = SendMessage(sock, type, seq, payload);
+        }
+
+        if (!sent)
+        {
+            std::lock_guard<std::mutex> lk(pendingMutex);
+            pending.erase(seq);
+            return std::nullopt;
+        }
+
+        if (result.wait_for(RequestTimeout) == std::future_status::ready)
+        {
+            return result.get();
+        }
+
+        // The host is alive but stuck, i.e. in a get_data that never returns. Callers hold the Data Source lock
+        // around this call, so rather than waiting any longer the host is killed, which fails this and every other
+        // outstanding request. The extension then reports errors until it is reloaded
+        SPDLOG_ERROR("Extension host for {} did not reply to message {} within {}s, killing pid {}",
+            libpath,
+            (uint32_t) type,
+            std::chrono::duration_cast<std::chrono::seconds>(RequestTimeout).count(),
+            pid);
+
+        {
+            std::lock_guard<std::mutex> lk(pendingMutex);
+            pending.erase(seq);
+            connected = false;
+        }
+
+        kill(pid, SIGKILL);
+
+        return std::nullopt;
+    }
+
+    void HostProxy::reply(uint64_t seq, std::string_view payload)
+    {
+        std::lock_guard<std::mutex> lk(sendMutex);
+        SendMessage(sock, MessageType::Reply, seq, payload);
+    }
+
+    void HostProxy::readLoop()
+    {
+        MessageHeader header;
+        std::string   payload;
+
+        while (ReceiveMessage(sock, header, payload))
+        {
+            switch (header.type)
+            {
+                case MessageType::Reply:
+                    {
+                        std::lock_guard<std::mutex> lk(pendingMutex);
+
+                        if (auto it = pending.find(header.seq); it != pending.end())
+                        {
+                            it->second.set_value(std::move(payload));
+                            pending.erase(it);
+                        }
+
+                        break;
+                    }
+                case MessageType::Log:
+                    {
+                        // first byte is the log level
+                        if (!payload.empty())
+                        {
+                            auto msg = fmt::format("[{}] {}", fields.name, std::string_view{payload}.substr(1));
+                            quasar_log((quasar_log_level_t) payload[0], msg.c_str());
+                        }
+
+                        break;
+                    }
+                case MessageType::SignalDataReady:
+                    {
+                        if (extension)
+                        {
+                            extension->HandleDataReady(payload);
+                        }
+
+                        break;
+                    }
+                case MessageType::WaitProcessed:
+                    {
+                        {
+                            std::lock_guard<std::mutex> lk(waitMutex);
+                            waitQueue.emplace_back(header.seq, std::move(payload));
+                        }
+
+                        waitCv.notify_one();
+                        break;
+                    }
+                case MessageType::SetStorage:
+                case MessageType::GetStorage:
+                    handleStorage(header.type, header.seq, payload);
+                    break;
+                default:
+                    SPDLOG_WARN("Unexpected message {} from extension host for {}", (uint32_t) header.type, libpath);
+                    break;
+            }
+        }
+
+        SPDLOG_INFO("Extension host for {} disconnected", libpath);
+
+        // fail all outstanding requests
+        std::lock_guard<std::mutex> lk(pendingMutex);
+
+        connected = false;
+
+        for (auto&& [seq, p] : pending)
+        {
+            p.set_value(std::nullopt);
+        }
+
+        pending.clear();
+    }
+
+    void HostProxy::waitLoop(std::stop_token stoken)
+    {
+        while (!stoken.stop_requested())
+        {
+            std::pair<uint64_t, std::string> item;
+
+            {
+                std::unique_lock<std::mutex> lk(waitMutex);
+
+                if (!waitCv.wait(lk, stoken, [this] {
+                        return !waitQueue.empty();
+                    }))
+                {
+                    return;
+                }
+
+                item = std::move(waitQueue.front());
+                waitQueue.pop_front();
+            }
+
+            if (extension)
+            {
+                extension->WaitForDataProcessed(item.second);
+            }
+
+            reply(item.first, {});
+        }
+    }
+
+    void HostProxy::handleStorage(MessageType type, uint64_t seq, const std::string& payload)
+    {
+        if (!extension)
+        {
+            if (type == MessageType::GetStorage)
+            {
+                reply(seq, "null");
+            }
+
+            return;
+        }
+
+        try
+        {
+            auto j    = jsoncons::json::parse(payload);
+            auto name = j.at("name").as<std::string>();
+            auto kind = j.at("type").as<std::string>();
+
+            if (type == MessageType::SetStorage)
+            {
+                const auto& val = j.at("val");
+
+                if (kind == "string")
+                {
+                    extension->WriteStorage(name, val.as<std::string>());
+                }
+                else if (kind == "int")
+                {
+                    extension->WriteStorage(name, val.as<int>());
+                }
+                else if (kind == "double")
+                {
+                    extension->WriteStorage(name, val.as<double>());
+                }
+                else if (kind == "bool")
+                {
+                    extension->WriteStorage(name, val.as<bool>());
+                }
+
+                return;
+            }
+
+            jsoncons::json result;
+
+            if (kind == "string")
+            {
+                result = extension->ReadStorage<std::string>(name);
+            }
+            else if (kind == "int")
+            {
+                result = extension->ReadStorage<int>(name);
+            }
+            else if (kind == "double")
+            {
+                result = extension->ReadStorage<double>(name);
+            }
+            else if (kind == "bool")
+            {
+                result = extension->ReadStorage<bool>(name);
+            }
+
+            std::string out;
+            result.dump(out);
+
+            reply(seq, out);
+        } catch (std::exception& e)
+        {
+            SPDLOG_WARN("Invalid storage request from extension host for {}: {}", libpath, e.what());
+
+            if (type == MessageType::GetStorage)
+            {
+                reply(seq, "null");
+            }
+        }
+    }
+
+    bool HostProxy::init(quasar_ext_handle handle)
+    {
+        HostProxy* proxy = findByName(handle);
+
+        if (!proxy)
+        {
+            return false;
+        }
+
+        proxy->extension = static_cast<Extension*>(handle);
+
+        jsoncons::json uids{jsoncons::json_array_arg};
+
+        for (auto& src : proxy->sources)
+        {
+            uids.push_back(src.uid);
+        }
+
+        std::string msg;
+        uids.dump(msg);
+
+        auto result = proxy->request(MessageType::Init, msg);
+
+        return result and *result == "true";
+    }
+
+    bool HostProxy::shutdown(quasar_ext_handle handle)
+    {
+        HostProxy* proxy = findByName(handle);
+
+        if (proxy)
+        {
+            proxy->request(MessageType::Shutdown, {});
+            proxy->extension = nullptr;
+        }
+
+        return true;
+    }
+
+    bool HostProxy::get_data(size_t srcUid, quasar_data_handle hData, char* args)
+    {
+        HostProxy*            proxy = findByUid(srcUid);
+        quasar_return_data_t* ref   = static_cast<quasar_return_data_t*>(hData);
+
+        if (!proxy or !ref)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lk(proxy->dataMutex);
+
+        jsoncons::json              req{
+            jsoncons::json_object_arg,
+            {{"uid", srcUid}, {"args", args ? jsoncons::json(args) : jsoncons::json::null()}}
+        };
+
+        std::string msg;
+        req.dump(msg);
+
+        auto result = proxy->request(MessageType::GetData, msg);
+
+        if (!result)
+        {
+            ref->errors.push_back(fmt::format("Extension host for {} is not running", proxy->fields.name));
+            return false;
+        }
+
+        try
+        {
+            auto j = jsoncons::json::parse(*result);
+
+            for (const auto& err : j.at("errors").array_range())
+            {
+                ref->errors.push_back(err.as<std::string>());
+            }
+
+            if (j.contains("pos"))
+            {
+                // Copied out of the shared region as is, Extension only parses it if a subscriber needs the values
+                const auto pos  = j.at("pos").as<uint64_t>();
+                const auto size = j.at("size").as<size_t>();
+                auto       view = proxy->ring.Read(pos, size);
+
+                try
+                {
+                    ref->frame.assign(view);
+                } catch (...)
+                {
+                    // the frame is released regardless, or the ring would never drain past it
+                    proxy->ring.Release(pos + size);
+                    throw;
+                }
+
+                proxy->ring.Release(pos + size);
+            }
+            else if (j.contains("val"))
+            {
+                // Ring was full, data was sent inline
+                ref->val = std::move(j.at("val"));
+            }
+
+            return j.at("ok").as<bool>();
+        } catch (std::exception& e)
+        {
+            SPDLOG_WARN("Invalid get_data reply from extension host for {}: {}", proxy->libpath, e.what());
+        }
+
+        return false;
+    }
+
+    quasar_settings_t* HostProxy::create_settings(quasar_ext_handle handle)
+    {
+        HostProxy* proxy = findByName(handle);
+
+        if (!proxy)
+        {
+            return nullptr;
+        }
+
+        quasar_settings_t* settings = quasar_create_settings(handle);
+
+        // Mirror the definitions made in the host
+        for (const auto& def : proxy->settingsDefs.array_range())
+        {
+            const auto type = def["type"].as<std::string>();
+            const auto name = def["name"].as<std::string>();
+            const auto desc = def["desc"].as<std::string>();
+
+            if (type == "int")
+            {
+                quasar_add_int_setting(handle,
+                    settings,
+                    name.c_str(),
+                    desc.c_str(),
+                    def["min"].as<int>(),
+                    def["max"].as<int>(),
+                    def["step"].as<int>(),
+                    def["def"].as<int>());
+            }
+            else if (type == "double")
+            {
+                quasar_add_double_setting(handle,
+                    settings,
+                    name.c_str(),
+                    desc.c_str(),
+                    def["min"].as<double>(),
+                    def["max"].as<double>(),
+                    def["step"].as<double>(),
+                    def["def"].as<double>());
+            }
+            else if (type == "bool")
+            {
+                quasar_add_bool_setting(handle, settings, name.c_str(), desc.c_str(), def["def"].as<bool>());
+            }
+            else if (type == "string")
+            {
+                quasar_add_string_setting(handle, settings, name.c_str(), desc.c_str(), def["def"].as<std::string>().c_str(), def["password"].as<bool>());
+            }
+            else if (type == "select")
+            {
+                quasar_selection_options_t* select = quasar_create_selection_setting();
+
+                for (const auto& opt : def["list"].array_range())
+                {
+                    quasar_add_selection_option(select, opt["name"].as<std::string>().c_str(), opt["value"].as<std::string>().c_str());
+                }
+
+                quasar_add_selection_setting(handle, settings, name.c_str(), desc.c_str(), select);
+            }
+        }
+
+        proxy->settings = settings;
+
+        return settings;
+    }
+
+    void HostProxy::update(quasar_settings_t* settings)
+    {
+        HostProxy* proxy = findBySettings(settings);
+
+        if (!proxy)
+        {
+            return;
+        }
+
+        // Send current values keyed by full setting label
+        jsoncons::json vals{jsoncons::json_object_arg};
+
+        for (auto&& def : *reinterpret_cast<SettingsVariantVector*>(settings))
+        {
+            std::visit(
+                [&](auto&& arg) {
+                    vals[arg.GetLabel()] = arg.GetValue();
+                },
+                def);
+        }
+
+        std::string msg;
+        vals.dump(msg);
+
+        proxy->request(MessageType::Update, msg);
+    }
+
+    void HostProxy::destroy(quasar_ext_info_t* info)
+    {
+        std::unique_ptr<HostProxy> proxy;
+
+        {
+            std::lock_guard<std::mutex> lk(registryMutex);
+
+            auto it = std::find_if(proxies.begin(), proxies.end(), [info](auto& p) {
+                return &p->info == info;
+            });
+
+            if (it != proxies.end())
+            {
+                proxy = std::move(*it);
+                proxies.erase(it);
+            }
+        }
+
+        // ~HostProxy runs outside of the registry lock
+    }
+
+    HostProxy* HostProxy::findByName(quasar_ext_handle handle)
+    {
+        Extension* ext = static_cast<Extension*>(handle);
+
+        if (!ext)
+        {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lk(registryMutex);
+
+        for (auto& p : proxies)
+        {
+            if (p->extension == ext or (!p->extension and ext->GetName() == p->fields.name))
+            {
+                return p.get();
+            }
+        }
+
+        return nullptr;
+    }
+
+    HostProxy* HostProxy::findByUid(size_t uid)
+    {
+        std::lock_guard<std::mutex> lk(registryMutex);
+
+        for (auto& p : proxies)
+        {
+            for (auto& src : p->sources)
+            {
+                if (src.uid == uid)
+                {
+                    return p.get();
+                }
+            }
+        }
+
+        return nullptr;
+    }
+
+    HostProxy* HostProxy::findBySettings(quasar_settings_t* settings)
+    {
+        std::lock_guard<std::mutex> lk(registryMutex);
+
+        for (auto& p : proxies)
+        {
+            if (p->settings == settings)
+            {
+                return p.get();
+            }
+        }
+
+        return nullptr;
+    }
+}  // namespace ExtHost
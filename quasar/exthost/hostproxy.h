@@ -0,0 +1,141 @@
+/*! \file
+    \brief Quasar side proxy for extensions running inside a quasar-exthost process.
+    This file is **NOT** a part of the Extension API.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "api/extension_types.h"
+
+#include "protocol.h"
+#include "shmring.h"
+
+#include <jsoncons/json.hpp>
+
+#include <sys/types.h>
+
+class Config;
+class Extension;
+class Server;
+
+namespace ExtHost
+{
+    /*! Runs a data extension library in an isolated quasar-exthost process.
+
+        HostProxy presents the remote extension to Quasar as a regular quasar_ext_info_t,
+        so the Extension class and everything above it are unaware of the process boundary.
+        Control calls travel over a Unix socket using the messages in protocol.h, while
+        get_data results are written by the host into a shared memory ShmRing and parsed
+        in place by Quasar.
+
+        A crashing or misbehaving extension only takes down its host process.
+    */
+    class HostProxy
+    {
+    public:
+        HostProxy(const HostProxy&)             = delete;
+        HostProxy& operator= (const HostProxy&) = delete;
+
+        ~HostProxy();
+
+        //! Spawns a host process for an extension library and loads it
+        /*!
+            \param[in]  libpath Path to library file
+            \param[in]  cfg     Config instance
+            \param[in]  srv     Server instance
+            \return Pointer to a Extension instance if successful, nullptr otherwise
+        */
+        static Extension* Load(const std::string& libpath, std::shared_ptr<Config> cfg, Server* srv);
+
+    private:
+        explicit HostProxy(const std::string& libpath);
+
+        /*! Spawns the host process and waits for its Hello message
+            \param[in]  cfg     Config instance
+            \return true if successful, false otherwise
+        */
+        bool spawn(std::shared_ptr<Config> cfg);
+
+        //! Populates quasar_ext_info_t from the host's Hello message
+        bool parseHello(const std::string& payload);
+
+        /*! Sends a request to the host and waits for its reply
+            If the host does not reply in time it is considered hung and killed.
+            \param[in]  type    Message type
+            \param[in]  payload Message payload
+            \return Reply payload if successful, empty if the host went away or timed out
+        */
+        std::optional<std::string> request(MessageType type, std::string_view payload);
+
+        //! Sends a reply to a host originated request
+        void                       reply(uint64_t seq, std::string_view payload);
+
+        //! Reads and dispatches messages from the host
+        void                       readLoop();
+
+        //! Services quasar_signal_wait_processed() calls from the host
+        void                       waitLoop(std::stop_token stoken);
+
+        //! Handles quasar_set_storage_*() and quasar_get_storage_*() calls from the host
+        void                       handleStorage(MessageType type, uint64_t seq, const std::string& payload);
+
+        // quasar_ext_info_t callbacks
+        static bool                init(quasar_ext_handle handle);
+        static bool                shutdown(quasar_ext_handle handle);
+        static bool                get_data(size_t srcUid, quasar_data_handle hData, char* args);
+        static quasar_settings_t*  create_settings(quasar_ext_handle handle);
+        static void                update(quasar_settings_t* settings);
+        static void                destroy(quasar_ext_info_t* info);
+
+        // Registry lookups
+        static HostProxy* findByName(quasar_ext_handle handle);
+        static HostProxy* findByUid(size_t uid);
+        static HostProxy* findBySettings(quasar_settings_t* settings);
+
+        using PendingMapType = std::unordered_map<uint64_t, std::promise<std::optional<std::string>>>;
+
+        static std::mutex                               registryMutex;  //!< Guards proxies
+        static std::vector<std::unique_ptr<HostProxy>> proxies;        //!< All live proxies
+
+        const std::string                               libpath;  //!< Path to library file
+
+        pid_t                                           pid{-1};   //!< Host process id
+        int                                             sock{-1};  //!< Control socket
+        ShmRing                                         ring;      //!< Data plane
+
+        Extension*                                      extension{};  //!< Owning Extension instance
+        quasar_settings_t*                              settings{};   //!< Extension settings handle
+
+        quasar_ext_info_fields_t                        fields{};
+        std::vector<quasar_data_source_t>               sources;
+        quasar_ext_info_t                               info{};
+        jsoncons::json                                  settingsDefs;  //!< Settings definitions sent by the host
+
+        std::mutex                                      sendMutex;  //!< Serializes writes to sock
+        std::mutex                                      dataMutex;  //!< Serializes get_data, and therefore ring usage
+        std::atomic<uint64_t>                           nextSeq{};
+
+        std::mutex                                      pendingMutex;
+        PendingMapType                                  pending;  //!< Outstanding requests
+        bool                                            connected{};
+
+        std::mutex                                      waitMutex;
+        std::condition_variable_any                     waitCv;
+        std::deque<std::pair<uint64_t, std::string>>    waitQueue;  //!< Pending wait_processed calls
+
+        std::jthread                                    reader;
+        std::jthread                                    waiter;
+    };
+}  // namespace ExtHost
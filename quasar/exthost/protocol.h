@@ -0,0 +1,158 @@
+/*! \file
+    \brief Control protocol between Quasar and the quasar-exthost helper process.
+    This file is **NOT** a part of the Extension API. Shared by Quasar and quasar-exthost only.
+*/
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace ExtHost
+{
+    //! Control message types exchanged over the host's Unix socket
+    enum class MessageType : uint32_t
+    {
+        Hello,            //!< host -> quasar: extension fields, data sources and settings definitions
+        Init,             //!< quasar -> host: assigned data source uids, calls quasar_ext_info_t.init
+        Update,           //!< quasar -> host: current settings values, calls quasar_ext_info_t.update
+        GetData,          //!< quasar -> host: calls quasar_ext_info_t.get_data, data is returned through the ShmRing
+        Shutdown,         //!< quasar -> host: calls quasar_ext_info_t.shutdown
+        Reply,            //!< Reply to the request with the same sequence number
+        Log,              //!< host -> quasar: quasar_log(), payload is the level byte followed by the message
+        SignalDataReady,  //!< host -> quasar: quasar_signal_data_ready()
+        WaitProcessed,    //!< host -> quasar: quasar_signal_wait_processed()
+        SetStorage,       //!< host -> quasar: quasar_set_storage_*()
+        GetStorage        //!< host -> quasar: quasar_get_storage_*()
+    };
+
+    //! Fixed size header preceding every control message
+    struct MessageHeader
+    {
+        MessageType type;  //!< Message type
+        uint32_t    size;  //!< Payload size in bytes
+        uint64_t    seq;   //!< Request sequence number, echoed back in the Reply
+    };
+
+    //! File descriptor of the control socket in the host process
+    constexpr int      HostSocketFd   = 3;
+
+    //! Largest accepted control message payload
+    constexpr uint32_t MaxMessageSize = 64 * 1024 * 1024;
+
+    //! Writes a complete control message to fd
+    /*!
+        \param[in]  fd      Socket file descriptor
+        \param[in]  type    Message type
+        \param[in]  seq     Sequence number
+        \param[in]  payload Message payload
+        \return true if successful, false otherwise
+    */
+    inline bool SendMessage(int fd, MessageType type, uint64_t seq, std::string_view payload)
+    {
+        MessageHeader header{.type = type, .size = (uint32_t) payload.size(), .seq = seq};
+
+        iovec         iov[2] = {
+            {       .iov_base = &header,  .iov_len = sizeof(header)},
+            {.iov_base = (void*) payload.data(), .iov_len = payload.size()}
+        };
+
+        msghdr msg{};
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = payload.empty() ? 1 : 2;
+
+        size_t remaining = sizeof(header) + payload.size();
+
+        while (remaining > 0)
+        {
+            ssize_t written = sendmsg(fd, &msg, MSG_NOSIGNAL);
+
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                return false;
+            }
+
+            remaining -= written;
+
+            // advance over partially written buffers
+            while (written > 0 and msg.msg_iovlen > 0)
+            {
+                if ((size_t) written >= msg.msg_iov->iov_len)
+                {
+                    written -= msg.msg_iov->iov_len;
+                    msg.msg_iov++;
+                    msg.msg_iovlen--;
+                }
+                else
+                {
+                    msg.msg_iov->iov_base = (char*) msg.msg_iov->iov_base + written;
+                    msg.msg_iov->iov_len -= written;
+                    written = 0;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    //! Reads exactly size bytes from fd
+    inline bool ReadExact(int fd, void* buf, size_t size)
+    {
+        char* p = static_cast<char*>(buf);
+
+        while (size > 0)
+        {
+            ssize_t rd = read(fd, p, size);
+
+            if (rd < 0 and errno == EINTR)
+            {
+                continue;
+            }
+
+            if (rd <= 0)
+            {
+                return false;
+            }
+
+            p += rd;
+            size -= rd;
+        }
+
+        return true;
+    }
+
+    //! Reads a complete control message from fd
+    /*!
+        \param[in]  fd      Socket file descriptor
+        \param[out] header  Message header
+        \param[out] payload Message payload
+        \return true if successful, false if the connection was closed or errored
+    */
+    inline bool ReceiveMessage(int fd, MessageHeader& header, std::string& payload)
+    {
+        if (!ReadExact(fd, &header, sizeof(header)))
+        {
+            return false;
+        }
+
+        if (header.size > MaxMessageSize)
+        {
+            return false;
+        }
+
+        payload.resize(header.size);
+
+        return header.size == 0 or ReadExact(fd, payload.data(), header.size);
+    }
+}  // namespace ExtHost
@@ -0,0 +1,221 @@
+/*! \file
+    \brief Shared memory ring used as the data plane between Quasar and quasar-exthost.
+    This file is **NOT** a part of the Extension API. Shared by Quasar and quasar-exthost only.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ExtHost
+{
+    //! Header placed at the start of the shared memory region
+    struct ShmRingHeader
+    {
+        std::atomic<uint64_t> head;      //!< Producer position (monotonic byte count)
+        std::atomic<uint64_t> tail;      //!< Consumer position (monotonic byte count)
+        uint64_t              capacity;  //!< Size of the data region in bytes
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ShmRing requires lock-free 64-bit atomics");
+
+    /*! Single producer, single consumer byte ring in POSIX shared memory.
+
+        The host process writes serialized frames with Write() and sends the returned position
+        over the control socket. Quasar reads the frame in place with Read() and copies it out
+        once before calling Release(). The frame is then published to subscribers as is, and
+        only parsed if a subscriber needs its values. Records never wrap; the producer skips
+        the remainder of the region instead.
+    */
+    class ShmRing
+    {
+    public:
+        //! Default size of the data region
+        static constexpr size_t DefaultCapacity = 4 * 1024 * 1024;
+
+        ShmRing()                           = default;
+        ShmRing(const ShmRing&)             = delete;
+        ShmRing& operator= (const ShmRing&) = delete;
+
+        ~ShmRing()
+        {
+            if (region)
+            {
+                munmap(region, mapsize);
+            }
+
+            if (owner)
+            {
+                Unlink();
+            }
+        }
+
+        //! Creates and maps a new shared memory region (Quasar side)
+        /*!
+            \param[in]  shmname     Shared memory object name, must begin with '/'
+            \param[in]  capacity    Size of the data region
+            \return true if successful, false otherwise
+        */
+        bool Create(const std::string& shmname, size_t capacity = DefaultCapacity)
+        {
+            int fd = shm_open(shmname.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+
+            if (fd < 0)
+            {
+                return false;
+            }
+
+            name  = shmname;
+            owner = true;
+
+            if (ftruncate(fd, sizeof(ShmRingHeader) + capacity) != 0 or !mapRegion(fd, sizeof(ShmRingHeader) + capacity))
+            {
+                close(fd);
+                return false;
+            }
+
+            close(fd);
+
+            new (header()) ShmRingHeader{};
+            header()->capacity = capacity;
+
+            return true;
+        }
+
+        //! Maps an existing shared memory region (host side)
+        /*!
+            \param[in]  shmname     Shared memory object name
+            \return true if successful, false otherwise
+        */
+        bool Open(const std::string& shmname)
+        {
+            int fd = shm_open(shmname.c_str(), O_RDWR, 0);
+
+            if (fd < 0)
+            {
+                return false;
+            }
+
+            struct stat st
+            {};
+
+            if (fstat(fd, &st) != 0 or (size_t) st.st_size <= sizeof(ShmRingHeader) or !mapRegion(fd, st.st_size))
+            {
+                close(fd);
+                return false;
+            }
+
+            close(fd);
+
+            name = shmname;
+
+            return header()->capacity == mapsize - sizeof(ShmRingHeader);
+        }
+
+        //! Removes the shared memory object name. Existing mappings stay valid.
+        void Unlink()
+        {
+            if (!name.empty())
+            {
+                shm_unlink(name.c_str());
+                name.clear();
+            }
+        }
+
+        //! Copies a frame into the ring (producer)
+        /*!
+            \param[in]  data    Frame data
+            \return Position of the frame if successful, empty if there is not enough free space
+        */
+        std::optional<uint64_t> Write(std::string_view data)
+        {
+            if (!region or data.empty())
+            {
+                return std::nullopt;
+            }
+
+            auto           hdr  = header();
+            const uint64_t cap  = hdr->capacity;
+            uint64_t       head = hdr->head.load(std::memory_order_relaxed);
+            const uint64_t tail = hdr->tail.load(std::memory_order_acquire);
+
+            // records are contiguous, skip the remainder of the region if the frame does not fit
+            const uint64_t offset = head % cap;
+            const uint64_t skip   = (offset + data.size() > cap) ? cap - offset : 0;
+
+            if (data.size() > cap or (head + skip + data.size()) - tail > cap)
+            {
+                return std::nullopt;
+            }
+
+            head += skip;
+
+            std::memcpy(this->data() + (head % cap), data.data(), data.size());
+
+            hdr->head.store(head + data.size(), std::memory_order_release);
+
+            return head;
+        }
+
+        //! Returns a view of a frame written at pos (consumer)
+        /*!
+            \param[in]  pos     Position returned by Write()
+            \param[in]  size    Size of the frame
+            \return View into the shared region, valid until Release()
+        */
+        std::string_view Read(uint64_t pos, size_t size) const
+        {
+            auto hdr = header();
+
+            if (!region or size > hdr->capacity or pos + size > hdr->head.load(std::memory_order_acquire))
+            {
+                return {};
+            }
+
+            return std::string_view{data() + (pos % hdr->capacity), size};
+        }
+
+        //! Releases all frames up to end (consumer)
+        /*!
+            \param[in]  end     Position one past the last consumed frame
+        */
+        void Release(uint64_t end) { header()->tail.store(end, std::memory_order_release); }
+
+        const std::string& GetName() const { return name; }
+
+    private:
+        bool mapRegion(int fd, size_t size)
+        {
+            void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+            if (ptr == MAP_FAILED)
+            {
+                return false;
+            }
+
+            region  = ptr;
+            mapsize = size;
+
+            return true;
+        }
+
+        ShmRingHeader* header() const { return static_cast<ShmRingHeader*>(region); }
+
+        char*          data() const { return static_cast<char*>(region) + sizeof(ShmRingHeader); }
+
+        void*          region{};
+        size_t         mapsize{};
+        std::string    name{};
+        bool           owner{};
+    };
+}  // namespace ExtHost
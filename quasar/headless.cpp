@@ -0,0 +1,168 @@
+/*! \file
+    \brief Entry point of quasar-server, the headless Data Server
+
+    Runs the WebSocket server and data extensions without any widget UI, reading the same
+    settings file as the full Quasar application. Logs go to the console and, if enabled,
+    to a log file next to the application data. SIGINT/SIGTERM (or Ctrl+C on Windows)
+    shut the server down cleanly, and SIGUSR1 dumps the flight recorder to the data folder.
+*/
+
+#include "common/config.h"
+#include "common/flightrecorder.h"
+#include "common/log.h"
+#include "common/qutil.h"
+#include "common/startup.h"
+#include "server/server.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSettings>
+#include <QStandardPaths>
+
+#include <spdlog/sinks/rotating_file_sink.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <thread>
+
+#if defined(_WIN32)
+#  define WIN32_LEAN_AND_MEAN
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <signal.h>
+#endif
+
+namespace
+{
+    void initializeLogger()
+    {
+        QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        path.append("-server.log");
+
+        constexpr auto                max_size{1048576 * 5};
+        constexpr auto                max_files{3};
+
+        std::vector<spdlog::sink_ptr> sinks{std::make_shared<spdlog::sinks::stdout_color_sink_mt>()};
+
+        if (Settings::internal.log_file.GetValue())
+        {
+            sinks.push_back(std::make_shared<spdlog::sinks::rotating_file_sink_mt>(path.toStdString(), max_size, max_files));
+        }
+
+        auto logger = Log::setup_logger(sinks);
+
+        spdlog::set_default_logger(logger);
+
+        spdlog::set_level((spdlog::level::level_enum) Settings::internal.log_level.GetValue());
+        spdlog::set_pattern("[%Y-%m-%d %H:%M:%S] [thread %t] [%^%l%$] %v - %s:L%#");
+
+        if (Settings::internal.log_file.GetValue())
+        {
+            SPDLOG_DEBUG("Logging to: {}", path.toStdString());
+        }
+    }
+
+    void requestQuit()
+    {
+        QMetaObject::invokeMethod(QCoreApplication::instance(), &QCoreApplication::quit, Qt::QueuedConnection);
+    }
+
+#if defined(_WIN32)
+    BOOL WINAPI consoleHandler(DWORD type)
+    {
+        switch (type)
+        {
+            case CTRL_C_EVENT:
+            case CTRL_BREAK_EVENT:
+            case CTRL_CLOSE_EVENT:
+            case CTRL_SHUTDOWN_EVENT:
+                requestQuit();
+                return TRUE;
+            default:
+                return FALSE;
+        }
+    }
+#endif
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Startup::Start();
+
+#if !defined(_WIN32)
+    // Block termination signals before any thread is started, so that all threads inherit
+    // the mask and only the dedicated signal thread below ever receives them
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+#endif
+
+    // Same settings type/path as the full application
+    QCoreApplication::setOrganizationName("quasar");
+    QCoreApplication::setApplicationName("quasar");
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+
+    QCoreApplication app(argc, argv);
+
+#if defined(_WIN32)
+    SetConsoleCtrlHandler(consoleHandler, TRUE);
+#else
+    std::jthread signalThread{[signals](std::stop_token token) {
+        int sig = 0;
+
+        while (sigwait(&signals, &sig) == 0)
+        {
+            if (token.stop_requested())
+            {
+                return;
+            }
+
+            if (sig == SIGUSR1)
+            {
+                FlightRecorder::DumpToDataFolder();
+                continue;
+            }
+
+            SPDLOG_INFO("Received signal {}, shutting down", sig);
+            requestQuit();
+        }
+    }};
+#endif
+
+    auto config = std::make_shared<Config>();
+
+    initializeLogger();
+
+    QDir extdir(QUtil::GetCommonAppDataPath() + "extensions/");
+
+    if (!extdir.exists())
+    {
+        extdir.mkpath(".");
+    }
+
+    int result = 0;
+
+    {
+        auto server = std::make_shared<Server>(config);
+
+        Startup::Finish();
+
+        SPDLOG_INFO("Quasar server running");
+
+        result = app.exec();
+    }
+
+    config->Save();
+
+#if !defined(_WIN32)
+    // Wake the signal thread so it can exit
+    signalThread.request_stop();
+    pthread_kill(signalThread.native_handle(), SIGTERM);
+#endif
+
+    return result;
+}
@@ -7,6 +7,7 @@
 
 #include <QDesktopServices>
 #include <QFileInfo>
+#include <QGuiApplication>
 #include <QProcess>
 #include <QString>
 #include <QUrl>
@@ -98,6 +99,15 @@ namespace
             if (cmd.contains("://"))
             {
                 // treat as url
+                if (!qobject_cast<QGuiApplication*>(QCoreApplication::instance()))
+                {
+                    // QDesktopServices needs a GUI application, i.e. not available in quasar-server
+                    auto m = fmt::format("Cannot open URL '{}' without a desktop session", d.file);
+                    SPDLOG_WARN(m);
+                    quasar_append_error(hData, m.c_str());
+                    return false;
+                }
+
                 SPDLOG_INFO("Launching URL {}", cmd.toStdString());
                 QDesktopServices::openUrl(QUrl(cmd));
             }
@@ -0,0 +1,117 @@
+#include "metrics.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+#include "api/extension_support.hpp"
+#include "common/metrics.h"
+
+#include <jsoncons/json.hpp>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+    struct RateSample
+    {
+        uint64_t published;
+        uint64_t bytes;
+    };
+
+    quasar_data_source_t sources[] = {
+        {"metrics", 1000000, 0, 0}
+    };
+
+    // Previous counters for computing rates, only touched by get_data
+    std::unordered_map<std::string, RateSample> previous;
+    RateSample                                  previousServer{};
+    std::chrono::steady_clock::time_point       previousTime{};
+
+    bool metrics_init(quasar_ext_handle handle)
+    {
+        previousTime = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    bool metrics_shutdown(quasar_ext_handle handle)
+    {
+        return true;
+    }
+
+    bool metrics_get_data(size_t srcUid, quasar_data_handle hData, char* args)
+    {
+        if (srcUid != sources[0].uid)
+        {
+            SPDLOG_WARN("Unknown source {}", srcUid);
+            return false;
+        }
+
+        auto&          registry = Metrics::Registry::Instance();
+
+        jsoncons::json j{jsoncons::json_object_arg};
+        registry.ToJSON(j);
+
+        const auto now     = std::chrono::steady_clock::now();
+        const auto elapsed = std::chrono::duration<double>(now - previousTime).count();
+        previousTime       = now;
+
+        auto rate          = [elapsed](uint64_t cur, uint64_t prev) {
+            return (elapsed > 0.0 and cur >= prev) ? (cur - prev) / elapsed : 0.0;
+        };
+
+        // Per source publish rates
+        registry.ForEachSource([&](const std::string& topic, const Metrics::SourceMetrics& m) {
+            RateSample cur{m.published.load(std::memory_order_relaxed), m.bytes.load(std::memory_order_relaxed)};
+            auto&      prev = previous[topic];
+
+            if (j["sources"].contains(topic))
+            {
+                auto& s                = j["sources"][topic];
+                s["published_per_sec"] = rate(cur.published, prev.published);
+                s["bytes_per_sec"]     = rate(cur.bytes, prev.bytes);
+            }
+
+            prev = cur;
+        });
+
+        // Server wide publish rates
+        auto&      srv = registry.GetServer();
+        RateSample cur{srv.publishes.load(std::memory_order_relaxed), srv.publish_bytes.load(std::memory_order_relaxed)};
+
+        j["server"]["publishes_per_sec"] = rate(cur.published, previousServer.published);
+        j["server"]["bytes_per_sec"]     = rate(cur.bytes, previousServer.bytes);
+
+        previousServer                   = cur;
+
+        std::string res{};
+        j.dump(res);
+
+        quasar_set_data_json_hpp(hData, res);
+
+        return true;
+    }
+
+    quasar_ext_info_fields_t fields =
+        {"quasar", "Quasar Metrics", "3.0", "r52", "Runtime metrics internal extension for Quasar", "https://github.com/r52/quasar"};
+
+    quasar_ext_info_t info = {
+        QUASAR_API_VERSION,
+        &fields,
+
+        std::size(sources),
+        sources,
+
+        metrics_init,      // init
+        metrics_shutdown,  // shutdown
+        metrics_get_data,  // data
+        nullptr,           // create setting
+        nullptr            // update setting
+    };
+}  // namespace
+
+quasar_ext_info_t* metrics_load(void)
+{
+    return &info;
+}
+
+void metrics_destroy(quasar_ext_info_t* info) {}
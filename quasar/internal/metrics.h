@@ -0,0 +1,7 @@
+#pragma once
+
+#include "api/extension_types.h"
+
+quasar_ext_info_t* metrics_load(void);
+
+void               metrics_destroy(quasar_ext_info_t* info);
@@ -1,13 +1,18 @@
 #include "quasar.h"
 
+#include "common/startup.h"
 #include "common/update.h"
 
 #include <QApplication>
 #include <QSettings>
 #include <QSplashScreen>
 
+#include <optional>
+
 int main(int argc, char* argv[])
 {
+    Startup::Start();
+
     if (Update::GetUpdateStatus() == Update::HasUpdate)
     {
         Update::RunUpdate();
@@ -21,9 +26,13 @@ int main(int argc, char* argv[])
     QCoreApplication::setApplicationName("quasar");
     QSettings::setDefaultFormat(QSettings::IniFormat);
 
-    QApplication a(argc, argv);
+    std::optional<Startup::Phase> phase{std::in_place, "QApplication"};
+
+    QApplication                  a(argc, argv);
     a.setQuitOnLastWindowClosed(false);
 
+    phase.emplace("Splash");
+
     QPixmap       pixmap(":/Resources/splash.png");
     QSplashScreen splash(pixmap);
     const auto    align = Qt::AlignHCenter | Qt::AlignBottom;
@@ -32,10 +41,16 @@ int main(int argc, char* argv[])
 
     splash.showMessage("Loading...", align, color);
 
+    phase.emplace("Quasar");
+
     Quasar w;
     w.hide();
 
+    phase.reset();
+
     splash.finish(&w);
 
+    Startup::Finish();
+
     return a.exec();
 }
@@ -2,8 +2,10 @@
 #include "version.h"
 
 #include "common/config.h"
+#include "common/flightrecorder.h"
 #include "common/log.h"
 #include "common/qutil.h"
+#include "common/startup.h"
 #include "common/update.h"
 #include "common/util.h"
 #include "config/configdialog.h"
@@ -67,21 +69,30 @@ Quasar::Quasar(QWidget* parent) : QMainWindow(parent), updateManager(new QNetwor
         throw std::runtime_error("System Tray is not supported on the current desktop manager");
     }
 
-    ui.setupUi(this);
+    {
+        Startup::Phase phase("UI setup");
+        ui.setupUi(this);
+    }
 
     connect(updateManager, &QNetworkAccessManager::finished, this, &Quasar::handleUpdateRequest);
 
     // Setup logger
-    ui.logEdit->document()->setMaximumBlockCount(200);
-    initializeLogger(ui.logEdit);
+    {
+        Startup::Phase phase("Logger");
+        ui.logEdit->document()->setMaximumBlockCount(200);
+        initializeLogger(ui.logEdit);
+    }
 
     // Initialize late components
     server  = std::make_shared<Server>(config);
     manager = std::make_shared<WidgetManager>(server, config);
 
     // Setup system tray
-    createTrayMenu();
-    createTrayIcon();
+    {
+        Startup::Phase phase("Tray");
+        createTrayMenu();
+        createTrayIcon();
+    }
 
     manager->SetWidgetChangedCallback([this](const std::vector<QuasarWidget*>& widgets) {
         if (widgetListMenu)
@@ -208,6 +219,19 @@ void Quasar::createTrayMenu()
     logAction = new QAction(tr("L&og"), this);
     connect(logAction, &QAction::triggered, this, &QWidget::showNormal);
 
+    recorderAction = new QAction(tr("Dump &Flight Recorder"), this);
+    connect(recorderAction, &QAction::triggered, [&] {
+        auto path = FlightRecorder::DumpToDataFolder();
+
+        if (path.empty())
+        {
+            QMessageBox::warning(this, tr("Flight Recorder"), tr("Failed to write flight recorder dump."));
+            return;
+        }
+
+        trayIcon->showMessage(tr("Flight Recorder"), tr("Recent events written to %1").arg(QString::fromStdString(path)));
+    });
+
     aboutAction = new QAction(tr("&About Quasar"), this);
 
     connect(aboutAction, &QAction::triggered, [&] {
@@ -281,6 +305,7 @@ void Quasar::createTrayIcon()
     trayIconMenu->addAction(dataFolderAction);
     trayIconMenu->addSeparator();
     trayIconMenu->addAction(logAction);
+    trayIconMenu->addAction(recorderAction);
     trayIconMenu->addSeparator();
     trayIconMenu->addAction(aboutAction);
     trayIconMenu->addAction(aboutQtAction);
@@ -49,6 +49,7 @@ private:
     QAction*               settingsAction{};
     QAction*               dataFolderAction{};
     QAction*               logAction{};
+    QAction*               recorderAction{};
     QAction*               aboutAction{};
     QAction*               aboutQtAction{};
     QAction*               docAction{};
@@ -12,3 +12,23 @@ function quasar_authenticate(socket) {
 function quasar_create_websocket() {
   return new WebSocket("ws://localhost:%1");
 }
+
+function quasar_trace_stages(msg) {
+  // Splits the trace timestamps of a traced frame into per stage durations in microseconds
+  if (!("trace" in msg)) {
+    return null;
+  }
+
+  var t = msg.trace;
+  var received = Math.round((performance.timeOrigin + performance.now()) * 1000);
+
+  return {
+    seq: t.seq,
+    queue: t.get_start - t.tick,
+    get_data: t.get_end - t.get_start,
+    serialize: t.ser_end - t.get_end,
+    loop: t.sent - t.ser_end,
+    network: received - t.sent,
+    total: received - t.tick,
+  };
+}
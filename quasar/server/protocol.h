@@ -5,6 +5,8 @@
 #include <tuple>
 #include <vector>
 
+#include <jsoncons/json.hpp>
+
 struct ClientMsgParams
 {
     std::optional<std::vector<std::string>> topics;
@@ -24,3 +26,7 @@ struct ErrorOnlyMessage
 {
     std::vector<std::string> errors;
 };
+
+JSONCONS_N_MEMBER_TRAITS(ClientMsgParams, 0, topics, params, code, args);
+JSONCONS_ALL_MEMBER_TRAITS(ClientMessage, method, params);
+JSONCONS_ALL_MEMBER_TRAITS(ErrorOnlyMessage, errors);
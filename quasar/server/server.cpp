@@ -1,17 +1,29 @@
 #include "server.h"
 
+#include <algorithm>
 #include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <optional>
 
 #include "uwebsockets/App.h"
 
 #include "common/config.h"
+#include "common/flightrecorder.h"
+#include "common/metrics.h"
 #include "common/qutil.h"
 #include "common/settings.h"
+#include "common/startup.h"
 
 #include "extension/extension.h"
 
+#if defined(__linux__)
+#  include "exthost/hostproxy.h"
+#endif
+
 #include "internal/ajax.h"
 #include "internal/applauncher.h"
+#include "internal/metrics.h"
 
 #include <QCoreApplication>
 #include <QDir>
@@ -26,10 +38,6 @@
     sendErrorToClient(d, fmt::format(__VA_ARGS__)); \
     SPDLOG_WARN(__VA_ARGS__);
 
-JSONCONS_N_MEMBER_TRAITS(ClientMsgParams, 0, topics, params, code, args);
-JSONCONS_ALL_MEMBER_TRAITS(ClientMessage, method, params);
-JSONCONS_ALL_MEMBER_TRAITS(ErrorOnlyMessage, errors);
-
 using UWSSocket = uWS::WebSocket<false, true, PerSocketData>;
 
 namespace
@@ -44,6 +52,57 @@ namespace
 
     std::set<std::string>   authcodes;
     std::mutex              authMutex;
+
+    // Unauthenticated clients and the time they are dropped at, oldest first. Only touched on the server loop
+    constexpr auto                                                               AuthTimeout   = std::chrono::seconds(10);
+    std::deque<std::pair<std::chrono::steady_clock::time_point, PerSocketData*>> authDeadlines;
+    us_timer_t*                                                                  authTimer     = nullptr;
+
+    // The HTTP endpoints have no way to authenticate, so with authentication enabled they are only served to the
+    // local machine, as the server may be listening on other interfaces. addr is the binary IPv4 or IPv6 address
+    bool allowUnauthenticatedHttp(std::string_view addr)
+    {
+        if (!Settings::internal.auth.GetValue())
+        {
+            return true;
+        }
+
+        const auto* a = reinterpret_cast<const uint8_t*>(addr.data());
+
+        if (addr.size() == 4)
+        {
+            return a[0] == 127;
+        }
+
+        if (addr.size() == 16)
+        {
+            // ::1, or an IPv4 mapped ::ffff:127.x.x.x
+            constexpr uint8_t loopback[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+            constexpr uint8_t mapped[12]   = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+
+            return std::equal(a, a + 16, loopback) or (std::equal(a, a + 12, mapped) and a[12] == 127);
+        }
+
+        return false;
+    }
+
+    // Drops clients that did not authenticate before their deadline, runs on the server loop once a second
+    void checkAuthDeadlines(us_timer_t*)
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        while (!authDeadlines.empty() and authDeadlines.front().first <= now)
+        {
+            auto data = authDeadlines.front().second;
+            authDeadlines.pop_front();
+
+            if (!data->authenticated)
+            {
+                // closing runs the close handler, which no longer finds this client in authDeadlines
+                static_cast<UWSSocket*>(data->socket)->end(0, "Unauthenticated client");
+            }
+        }
+    }
 }  // namespace
 
 Server::Server(std::shared_ptr<Config> cfg) :
@@ -55,9 +114,21 @@ Server::Server(std::shared_ptr<Config> cfg) :
     config{cfg}
 {
     using namespace std::literals;
+
+    Startup::Phase                phase("Server");
+
+    // Covers server thread startup until listen succeeded
+    std::optional<Startup::Phase> listenPhase{std::in_place, "WebSocket listen"};
+
     websocketServer = std::jthread{[this]() {
-        loop = uWS::Loop::get();
-        app  = new uWS::App();
+        FlightRecorder::SetThreadName("server");
+
+        loop      = uWS::Loop::get();
+        app       = new uWS::App();
+
+        // fallthrough, so that the timer does not keep the loop alive once the app is closed
+        authTimer = us_create_timer((us_loop_t*) loop, 1, 0);
+        us_timer_set(authTimer, checkAuthDeadlines, 1000, 1000);
 
         app->ws<PerSocketData>("/*",
                {/* Settings */
@@ -79,25 +150,22 @@ Server::Server(std::shared_ptr<Config> cfg) :
                            auto data    = ws->getUserData();
                            data->socket = ws;
 
+                           Metrics::Registry::Instance().GetServer().clients.fetch_add(1, std::memory_order_relaxed);
+
                            SPDLOG_INFO("New client connected!");
 
                            if (Settings::internal.auth.GetValue())
                            {
-                               RunOnPool([data, this] {
-                                   // Check for auth status after 10s
-                                   std::this_thread::sleep_for(10s);
-                                   if (!data->authenticated)
-                                   {
-                                       RunOnServer([=]() {
-                                           auto socket = static_cast<UWSSocket*>(data->socket);
-                                           socket->end(0, "Unauthenticated client");
-                                       });
-                                   }
-                               });
+                               // Checked by checkAuthDeadlines() instead of a sleeping task, which would hold a pool worker per client
+                               authDeadlines.emplace_back(std::chrono::steady_clock::now() + AuthTimeout, data);
                            }
                        },
                    .message =
                        [this](UWSSocket* ws, std::string_view message, uWS::OpCode opCode) {
+                           auto& m = Metrics::Registry::Instance().GetServer();
+                           m.messages.fetch_add(1, std::memory_order_relaxed);
+                           m.message_bytes.fetch_add(message.size(), std::memory_order_relaxed);
+
                            RunOnPool([data = ws->getUserData(), this, msg = std::string{message}] {
                                this->processMessage(data, msg);
                            });
@@ -110,16 +178,45 @@ Server::Server(std::shared_ptr<Config> cfg) :
                        [this](UWSSocket* ws, int code, std::string_view message) {
                            auto data = ws->getUserData();
 
+                           std::erase_if(authDeadlines, [data](auto& d) {
+                               return d.second == data;
+                           });
+
                            this->processClose(data);
 
+                           Metrics::Registry::Instance().GetServer().clients.fetch_sub(1, std::memory_order_relaxed);
+
                            SPDLOG_INFO("Client disconnected.");
                        }})
-            .listen("localhost",
+            .get("/metrics",
+                [](auto* res, auto* req) {
+                    if (!allowUnauthenticatedHttp(res->getRemoteAddress()))
+                    {
+                        res->writeStatus("403 Forbidden")->end();
+                        return;
+                    }
+
+                    std::string body;
+                    Metrics::Registry::Instance().ToPrometheus(body);
+
+                    res->writeHeader("Content-Type", "text/plain; version=0.0.4; charset=utf-8")->end(body);
+                })
+            .get("/healthz",
+                [](auto* res, auto* req) {
+                    if (!allowUnauthenticatedHttp(res->getRemoteAddress()))
+                    {
+                        res->writeStatus("403 Forbidden")->end();
+                        return;
+                    }
+
+                    res->writeHeader("Content-Type", "text/plain; charset=utf-8")->end("ok");
+                })
+            .listen(Settings::internal.host.GetValue(),
                 Settings::internal.port.GetValue(),
                 [](auto* socket) {
                     if (socket)
                     {
-                        SPDLOG_INFO("WebSocket Thread listening on port {}", Settings::internal.port.GetValue());
+                        SPDLOG_INFO("WebSocket Thread listening on {}:{}", Settings::internal.host.GetValue(), Settings::internal.port.GetValue());
 
                         {
                             std::lock_guard lk(serverMutex);
@@ -129,11 +226,14 @@ Server::Server(std::shared_ptr<Config> cfg) :
                     }
                     else
                     {
-                        SPDLOG_ERROR("WebSocket Thread failed to listen on port {}", Settings::internal.port.GetValue());
+                        SPDLOG_ERROR("WebSocket Thread failed to listen on {}:{}", Settings::internal.host.GetValue(), Settings::internal.port.GetValue());
                     }
                 })
             .run();
 
+        us_timer_close(authTimer);
+        authDeadlines.clear();
+
         delete app;
         loop->free();
     }};
@@ -145,6 +245,26 @@ Server::Server(std::shared_ptr<Config> cfg) :
         });
     }
 
+    listenPhase.reset();
+
+    Metrics::Registry::Instance().SetProvider("pool", [this](jsoncons::json& j) {
+        for (size_t i = 0; i < static_cast<size_t>(TaskPriority::Count); i++)
+        {
+            auto p = static_cast<TaskPriority>(i);
+            auto s = pool.GetStats(p);
+
+            j[ThreadPool::PriorityName(p)] = jsoncons::json{
+                jsoncons::json_object_arg,
+                {{"tasks", s.tasks}, {"avg_us", s.avg_us}, {"max_us", s.max_us}, {"queued", s.queued}}
+            };
+        }
+    });
+
+    if constexpr (LockProfiler::Enabled())
+    {
+        Metrics::Registry::Instance().SetProvider("locks", LockProfiler::ToJSON);
+    }
+
     this->loadExtensions();
 
     // Force QtNetworkAuth linkage
@@ -153,20 +273,30 @@ Server::Server(std::shared_ptr<Config> cfg) :
 
 Server::~Server()
 {
+    Metrics::Registry::Instance().RemoveProvider("pool");
+
+    if constexpr (LockProfiler::Enabled())
+    {
+        Metrics::Registry::Instance().RemoveProvider("locks");
+    }
+
     loop->defer([]() {
         app->close();
     });
 
-    pool.wait_for_tasks();
+    pool.WaitForTasks();
+    pool.LogStats();
 
     websocketServer.join();
 
     extensions.clear();
+
+    LockProfiler::LogReport();
 }
 
 bool Server::FindExtension(const std::string& extcode)
 {
-    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+    std::shared_lock<LockProfiler::SharedMutex> lk(extensionMutex);
     return (extensions.count(extcode) > 0);
 }
 
@@ -181,11 +311,41 @@ void Server::SendDataToClient(PerSocketData* client, const std::string& msg)
 
 void Server::PublishData(std::string_view topic, const std::string& data)
 {
+    auto& m = Metrics::Registry::Instance().GetServer();
+    m.publishes.fetch_add(1, std::memory_order_relaxed);
+    m.publish_bytes.fetch_add(data.size(), std::memory_order_relaxed);
+
     RunOnServer([=]() {
         app->publish(topic, data, uWS::TEXT);
     });
 }
 
+void Server::PublishTraced(std::string_view topic, const std::string& data, const Metrics::FrameTrace& trace, Metrics::SourceMetrics* metrics)
+{
+    auto& m = Metrics::Registry::Instance().GetServer();
+    m.publishes.fetch_add(1, std::memory_order_relaxed);
+    m.publish_bytes.fetch_add(data.size(), std::memory_order_relaxed);
+
+    RunOnServer([=]() {
+        const auto sent = Metrics::WallClockMicros();
+
+        // Splice the trace object into the serialized frame
+        std::string msg{data, 0, data.rfind('}')};
+        fmt::format_to(std::back_inserter(msg),
+            R"(,"trace":{{"seq":{},"tick":{},"get_start":{},"get_end":{},"ser_end":{},"sent":{}}}}})",
+            trace.seq,
+            trace.tick,
+            trace.get_start,
+            trace.get_end,
+            trace.ser_end,
+            sent);
+
+        metrics->send_us.Record(std::max<int64_t>(sent - trace.ser_end, 0));
+
+        app->publish(topic, msg, uWS::TEXT);
+    });
+}
+
 void Server::RunOnServer(auto&& cb)
 {
     loop->defer(cb);
@@ -194,7 +354,7 @@ void Server::RunOnServer(auto&& cb)
 void Server::UpdateSettings()
 {
     RunOnServer([=, this] {
-        std::lock_guard<std::shared_mutex> lk(extensionMutex);
+        std::lock_guard<LockProfiler::SharedMutex> lk(extensionMutex);
         for (auto&& [name, ext] : extensions)
         {
             ext->UpdateExtensionSettings();
@@ -224,6 +384,8 @@ std::string Server::GenerateAuthCode()
 
 void Server::loadExtensions()
 {
+    Startup::Phase phase("Load extensions");
+
     const auto libTypes = QStringList() << "*.dll"
                                         << "*.so"
                                         << "*.dylib";
@@ -245,126 +407,72 @@ void Server::loadExtensions()
     // just lock the whole thing while initializing extensions at startup
     // to prevent out of order reads
     {
-        std::lock_guard<std::shared_mutex> lk(extensionMutex);
+        std::lock_guard<LockProfiler::SharedMutex> lk(extensionMutex);
 
         // First load internal extensions
-        {
-            // App Launcher
-            std::string name = "applauncher";
-            Extension*  extn = Extension::LoadInternal(name, applauncher_load, applauncher_destroy, config.lock(), this);
-
-            if (!extn)
-            {
-                SPDLOG_WARN("Failed to load extension {}", name);
-            }
-            else if (extensions.count(extn->GetName()))
-            {
-                SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", extn->GetName(), name);
-            }
-            else
-            {
-                try
-                {
-                    extn->Initialize();
-                } catch (std::exception e)
-                {
-                    SPDLOG_WARN("Exception: {} while initializing {}", e.what(), name);
-                    delete extn;
-                    extn = nullptr;
-                }
-
-                SPDLOG_INFO("Extension {} loaded.", extn->GetName());
-                extensions[extn->GetName()].reset(extn);
-                extn = nullptr;
-            }
-
-            if (extn != nullptr)
-            {
-                delete extn;
-            }
-        }
-
-        {
-            // AJAX
-            std::string name = "ajax";
-            Extension*  extn = Extension::LoadInternal(name, ajax_load, ajax_destroy, config.lock(), this);
-
-            if (!extn)
-            {
-                SPDLOG_WARN("Failed to load extension {}", name);
-            }
-            else if (extensions.count(extn->GetName()))
-            {
-                SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", extn->GetName(), name);
-            }
-            else
-            {
-                try
-                {
-                    extn->Initialize();
-                } catch (std::exception e)
-                {
-                    SPDLOG_WARN("Exception: {} while initializing {}", e.what(), name);
-                    delete extn;
-                    extn = nullptr;
-                }
-
-                SPDLOG_INFO("Extension {} loaded.", extn->GetName());
-                extensions[extn->GetName()].reset(extn);
-                extn = nullptr;
-            }
-
-            if (extn != nullptr)
-            {
-                delete extn;
-            }
-        }
+        loadInternalExtension("applauncher", applauncher_load, applauncher_destroy);
+        loadInternalExtension("ajax", ajax_load, ajax_destroy);
+        loadInternalExtension("metrics", metrics_load, metrics_destroy);
 
         // Load Extension libraries
         for (QFileInfo& file : list)
         {
-            auto libpath = (file.path() + "/" + file.fileName()).toStdString();
+            auto           libpath = (file.path() + "/" + file.fileName()).toStdString();
+
+            Startup::Phase extPhase("Extension", file.fileName().toStdString());
 
             SPDLOG_INFO("Loading data extension {}", libpath);
 
+#if defined(__linux__)
+            Extension* extn = Settings::internal.exthost.GetValue() ? ExtHost::HostProxy::Load(libpath, config.lock(), this)
+                                                                     : Extension::Load(libpath, config.lock(), this);
+#else
             Extension* extn = Extension::Load(libpath, config.lock(), this);
+#endif
 
-            if (!extn)
-            {
-                SPDLOG_WARN("Failed to load extension {}", libpath);
-            }
-            else if (extensions.count(extn->GetName()))
-            {
-                SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", extn->GetName(), libpath);
-            }
-            else
-            {
-                try
-                {
-                    extn->Initialize();
-                } catch (std::exception e)
-                {
-                    SPDLOG_WARN("Exception: {} while initializing {}", e.what(), libpath);
-                    delete extn;
-                    extn = nullptr;
-                    continue;
-                }
-
-                SPDLOG_INFO("Extension {} loaded.", extn->GetName());
-                extensions[extn->GetName()].reset(extn);
-                extn = nullptr;
-            }
-
-            if (extn != nullptr)
-            {
-                delete extn;
-            }
+            addExtension(extn, libpath);
         }
 
         SPDLOG_INFO("Extensions loaded!");
     }
 }
 
+void Server::loadInternalExtension(const std::string& name, quasar_ext_info_t* (*load)(), void (*destroy)(quasar_ext_info_t*))
+{
+    Startup::Phase extPhase("Extension", name);
+
+    addExtension(Extension::LoadInternal(name, load, destroy, config.lock(), this), name);
+}
+
+void Server::addExtension(Extension* extn, const std::string& source)
+{
+    std::unique_ptr<Extension> ext{extn};
+
+    if (!ext)
+    {
+        SPDLOG_WARN("Failed to load extension {}", source);
+        return;
+    }
+
+    if (extensions.count(ext->GetName()))
+    {
+        SPDLOG_WARN("Extension with code {} already loaded. Unloading {}", ext->GetName(), source);
+        return;
+    }
+
+    try
+    {
+        ext->Initialize();
+    } catch (const std::exception& e)
+    {
+        SPDLOG_WARN("Exception: {} while initializing {}", e.what(), source);
+        return;
+    }
+
+    SPDLOG_INFO("Extension {} loaded.", ext->GetName());
+    extensions[ext->GetName()] = std::move(ext);
+}
+
 void Server::handleMethodSubscribe(PerSocketData* client, const ClientMessage& msg)
 {
     if (Settings::internal.auth.GetValue() and !client->authenticated)
@@ -387,9 +495,25 @@ void Server::handleMethodSubscribe(PerSocketData* client, const ClientMessage& m
         return;
     }
 
-    auto&                               topics = parms.topics.value();
+    auto& topics = parms.topics.value();
+
+    // Optional subscription variant, i.e. frame tracing or quantized output. The first known one is used
+    std::string variant{};
+
+    if (parms.params)
+    {
+        auto& p  = parms.params.value();
+        auto  it = std::find_if(p.begin(), p.end(), [](const std::string& v) {
+            return !v.empty() and Extension::ParseVariant(v) != SubscriptionVariant::Plain;
+        });
+
+        if (it != p.end())
+        {
+            variant = *it;
+        }
+    }
 
-    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+    std::shared_lock<LockProfiler::SharedMutex> lk(extensionMutex);
 
     for (auto&& topic : topics)
     {
@@ -415,18 +539,19 @@ void Server::handleMethodSubscribe(PerSocketData* client, const ClientMessage& m
             continue;
         }
 
-        auto socket = static_cast<UWSSocket*>(client->socket);
+        auto socket  = static_cast<UWSSocket*>(client->socket);
+        auto channel = variant.empty() ? topic : fmt::format("{}?{}", topic, variant);
 
         RunOnServer([=, this]() {
-            auto res = socket->subscribe(topic);
+            auto res = socket->subscribe(channel);
 
             if (res)
             {
-                SPDLOG_INFO("Widget subscribed to topic {}", topic);
+                SPDLOG_INFO("Widget subscribed to topic {}", channel);
             }
             else
             {
-                SEND_CLIENT_ERROR(client, "Failed to subscribed to topic {}", topic);
+                SEND_CLIENT_ERROR(client, "Failed to subscribed to topic {}", channel);
             }
         });
     }
@@ -466,10 +591,10 @@ void Server::handleMethodQuery(PerSocketData* client, const ClientMessage& msg)
         extns[target].push_back(topic);
     }
 
-    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+    std::shared_lock<LockProfiler::SharedMutex> lk(extensionMutex);
 
-    jsoncons::json                      j{jsoncons::json_object_arg, {{"errors", jsoncons::json{jsoncons::json_array_arg}}}};
-    std::string                         message{};
+    jsoncons::json                              j{jsoncons::json_object_arg, {{"errors", jsoncons::json{jsoncons::json_array_arg}}}};
+    std::string                                 message{};
 
     for (auto&& [target, tpcs] : extns)
     {
@@ -588,9 +713,9 @@ void Server::processClose(PerSocketData* client)
 
 void Server::processSubscription(PerSocketData* client, const std::string& topic, int nSize, int oSize)
 {
-    std::shared_lock<std::shared_mutex> lk(extensionMutex);
+    std::shared_lock<LockProfiler::SharedMutex> lk(extensionMutex);
 
-    auto                                target = topic.substr(0, topic.find_first_of("/"));
+    auto                                        target = topic.substr(0, topic.find_first_of("/"));
 
     if (!extensions.count(target))
     {
@@ -8,11 +8,20 @@
 
 #include "protocol.h"
 
-#include <BS_thread_pool.hpp>
+#include "common/lockprofiler.h"
+#include "common/threadpool.h"
 
 class Extension;
 class Config;
 
+struct quasar_ext_info_t;
+
+namespace Metrics
+{
+    struct FrameTrace;
+    struct SourceMetrics;
+}  // namespace Metrics
+
 struct PerSocketData
 {
     void* socket        = nullptr;
@@ -38,9 +47,11 @@ public:
 
     void        PublishData(std::string_view topic, const std::string& data);
 
+    void        PublishTraced(std::string_view topic, const std::string& data, const Metrics::FrameTrace& trace, Metrics::SourceMetrics* metrics);
+
     void        RunOnServer(auto&& cb);
 
-    void        RunOnPool(auto&& cb) { pool.push_task(cb); }
+    void        RunOnPool(auto&& cb, TaskPriority priority = TaskPriority::Normal) { pool.Push(std::forward<decltype(cb)>(cb), priority); }
 
     void        UpdateSettings();
 
@@ -49,6 +60,19 @@ public:
 private:
     void loadExtensions();
 
+    /*! Loads, initializes and registers an extension built into Quasar, must hold extensionMutex
+        \param[in]  name    Extension name
+        \param[in]  load    quasar_ext_load() of the extension
+        \param[in]  destroy quasar_ext_destroy() of the extension
+    */
+    void loadInternalExtension(const std::string& name, quasar_ext_info_t* (*load)(), void (*destroy)(quasar_ext_info_t*));
+
+    /*! Initializes and registers a loaded extension, or destroys it on failure, must hold extensionMutex
+        \param[in]  extn    Loaded extension, may be nullptr if loading failed
+        \param[in]  source  Library path or name of the extension, for logging
+    */
+    void addExtension(Extension* extn, const std::string& source);
+
     // Method handling
     void         handleMethodSubscribe(PerSocketData* client, const ClientMessage& msg);
     void         handleMethodQuery(PerSocketData* client, const ClientMessage& msg);
@@ -65,9 +89,9 @@ private:
     const MethodCallMapType   methods;
 
     ExtensionsMapType         extensions;
-    mutable std::shared_mutex extensionMutex;
+    mutable QUASAR_SHARED_LOCKABLE(extensionMutex, "Server::extensionMutex");
 
     std::weak_ptr<Config>     config{};
 
-    BS::thread_pool           pool;
+    ThreadPool                pool;
 };
@@ -4,6 +4,7 @@
 
 #include "common/config.h"
 #include "common/settings.h"
+#include "common/startup.h"
 #include "common/util.h"
 #include "server/server.h"
 
@@ -48,7 +49,9 @@ namespace
 
 WidgetManager::WidgetManager(std::shared_ptr<Server> serv, std::shared_ptr<Config> cfg) : server{serv}, config{cfg}
 {
-    auto cookiesfile = Settings::internal.cookies.GetValue();
+    Startup::Phase phase("Cookies");
+
+    auto           cookiesfile = Settings::internal.cookies.GetValue();
 
     if (cookiesfile.empty())
     {
@@ -282,10 +285,14 @@ void WidgetManager::CloseWidget(QuasarWidget* widget)
 
 void WidgetManager::LoadStartupWidgets()
 {
-    auto loaded = getLoadedWidgetsList();
+    Startup::Phase phase("Startup widgets");
+
+    auto           loaded = getLoadedWidgetsList();
 
     for (auto&& file : loaded)
     {
+        Startup::Phase widgetPhase("Widget", file);
+
         LoadWidget(file, false);
     }
 }
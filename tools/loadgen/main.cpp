@@ -0,0 +1,749 @@
+/*! \file
+    \brief Headless WebSocket load client for Quasar
+
+    Opens a number of WebSocket connections to a Quasar Data Server over loopback, subscribes
+    each of them to a set of synthetic_load topics and reports end-to-end latency percentiles,
+    throughput and server resource usage. All connections are serviced by a single epoll thread
+    so the client itself stays cheap compared to the server under test.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <fmt/core.h>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::string host        = "127.0.0.1";
+        int         port        = 13337;
+        int         connections = 10;
+        int         topics      = 4;
+        int         duration    = 10;  //!< Measurement time in seconds
+        int         warmup      = 2;   //!< Seconds of traffic ignored before measuring
+        std::string extension   = "synthetic_load";
+        std::string auth        = "";
+        bool        json        = false;
+    };
+
+    struct Connection
+    {
+        int         fd = -1;
+        std::string in;       //!< Unparsed bytes
+        std::string message;  //!< Fragmented message being assembled
+        bool        open = false;
+    };
+
+    struct Stats
+    {
+        uint64_t              messages = 0;
+        uint64_t              bytes    = 0;
+        uint64_t              errors   = 0;
+        std::vector<uint32_t> latencies;  //!< Microseconds
+    };
+
+    struct ServerStats
+    {
+        double rss     = 0;
+        double threads = 0;
+        double dropped = 0;
+    };
+
+    std::mt19937 rng{std::random_device{}()};
+
+    void Usage(const char* argv0)
+    {
+        fmt::print(stderr,
+            "Usage: {} [options]\n"
+            "  --host ADDR          Server address (default 127.0.0.1)\n"
+            "  --port N             Server port (default 13337)\n"
+            "  --connections N      Number of WebSocket connections (default 10)\n"
+            "  --topics M           Topics subscribed per connection (default 4)\n"
+            "  --duration S         Measurement duration in seconds (default 10)\n"
+            "  --warmup S           Warmup duration in seconds (default 2)\n"
+            "  --extension NAME     Extension providing t0..tN topics (default synthetic_load)\n"
+            "  --auth CODE          Authentication code, if server auth is enabled\n"
+            "  --json               Print results as JSON\n",
+            argv0);
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& opt)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string_view arg{argv[i]};
+
+            auto             next = [&]() -> const char* {
+                return (i + 1 < argc) ? argv[++i] : nullptr;
+            };
+
+            auto nextInt = [&](int& out) {
+                const char* v = next();
+                return v and std::from_chars(v, v + std::strlen(v), out).ec == std::errc{};
+            };
+
+            bool ok = true;
+
+            if (arg == "--host")
+            {
+                const char* v = next();
+                ok            = v != nullptr;
+                opt.host      = ok ? v : "";
+            }
+            else if (arg == "--port")
+            {
+                ok = nextInt(opt.port);
+            }
+            else if (arg == "--connections")
+            {
+                ok = nextInt(opt.connections);
+            }
+            else if (arg == "--topics")
+            {
+                ok = nextInt(opt.topics);
+            }
+            else if (arg == "--duration")
+            {
+                ok = nextInt(opt.duration);
+            }
+            else if (arg == "--warmup")
+            {
+                ok = nextInt(opt.warmup);
+            }
+            else if (arg == "--extension")
+            {
+                const char* v = next();
+                ok            = v != nullptr;
+                opt.extension = ok ? v : "";
+            }
+            else if (arg == "--auth")
+            {
+                const char* v = next();
+                ok            = v != nullptr;
+                opt.auth      = ok ? v : "";
+            }
+            else if (arg == "--json")
+            {
+                opt.json = true;
+            }
+            else
+            {
+                ok = false;
+            }
+
+            if (!ok)
+            {
+                return false;
+            }
+        }
+
+        return opt.connections > 0 and opt.topics > 0 and opt.duration > 0 and opt.warmup >= 0;
+    }
+
+    int64_t WallClockMicros()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int Connect(const Options& opt)
+    {
+        addrinfo  hints{.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+        addrinfo* res  = nullptr;
+
+        auto      port = std::to_string(opt.port);
+
+        if (getaddrinfo(opt.host.c_str(), port.c_str(), &hints, &res) != 0)
+        {
+            return -1;
+        }
+
+        int fd = -1;
+
+        for (auto* ai = res; ai; ai = ai->ai_next)
+        {
+            fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+
+            if (fd < 0)
+            {
+                continue;
+            }
+
+            if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            {
+                break;
+            }
+
+            close(fd);
+            fd = -1;
+        }
+
+        freeaddrinfo(res);
+
+        if (fd >= 0)
+        {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        return fd;
+    }
+
+    bool SendAll(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+            auto n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+
+            if (n <= 0)
+            {
+                return false;
+            }
+
+            data.remove_prefix(n);
+        }
+
+        return true;
+    }
+
+    //! Reads an HTTP response header, leaving any bytes after it in rest
+    bool ReadHttpHeader(int fd, std::string& header, std::string& rest)
+    {
+        char buf[4096];
+
+        while (true)
+        {
+            auto pos = rest.find("\r\n\r\n");
+
+            if (pos != std::string::npos)
+            {
+                header = rest.substr(0, pos);
+                rest.erase(0, pos + 4);
+                return true;
+            }
+
+            auto n = recv(fd, buf, sizeof(buf), 0);
+
+            if (n <= 0)
+            {
+                return false;
+            }
+
+            rest.append(buf, n);
+        }
+    }
+
+    std::string Base64(const unsigned char* data, size_t len)
+    {
+        constexpr char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        std::string    out;
+
+        for (size_t i = 0; i < len; i += 3)
+        {
+            uint32_t v = data[i] << 16;
+
+            if (i + 1 < len)
+                v |= data[i + 1] << 8;
+            if (i + 2 < len)
+                v |= data[i + 2];
+
+            out += table[(v >> 18) & 63];
+            out += table[(v >> 12) & 63];
+            out += (i + 1 < len) ? table[(v >> 6) & 63] : '=';
+            out += (i + 2 < len) ? table[v & 63] : '=';
+        }
+
+        return out;
+    }
+
+    bool Handshake(Connection& c, const Options& opt)
+    {
+        unsigned char key[16];
+
+        for (auto& k : key)
+        {
+            k = (unsigned char) rng();
+        }
+
+        auto request = fmt::format("GET / HTTP/1.1\r\n"
+                                   "Host: {}:{}\r\n"
+                                   "Upgrade: websocket\r\n"
+                                   "Connection: Upgrade\r\n"
+                                   "Sec-WebSocket-Key: {}\r\n"
+                                   "Sec-WebSocket-Version: 13\r\n\r\n",
+            opt.host,
+            opt.port,
+            Base64(key, sizeof(key)));
+
+        std::string header;
+
+        if (!SendAll(c.fd, request) or !ReadHttpHeader(c.fd, header, c.in))
+        {
+            return false;
+        }
+
+        return header.starts_with("HTTP/1.1 101");
+    }
+
+    //! Sends a masked text frame, as required for clients
+    bool SendText(Connection& c, std::string_view payload, uint8_t opcode = 0x1)
+    {
+        std::string frame;
+        frame.reserve(payload.size() + 14);
+
+        frame += (char) (0x80 | opcode);
+
+        if (payload.size() < 126)
+        {
+            frame += (char) (0x80 | payload.size());
+        }
+        else if (payload.size() <= 0xFFFF)
+        {
+            frame += (char) (0x80 | 126);
+            frame += (char) ((payload.size() >> 8) & 0xFF);
+            frame += (char) (payload.size() & 0xFF);
+        }
+        else
+        {
+            frame += (char) (0x80 | 127);
+
+            for (int i = 7; i >= 0; i--)
+            {
+                frame += (char) ((uint64_t(payload.size()) >> (i * 8)) & 0xFF);
+            }
+        }
+
+        uint32_t mask = rng();
+        char     m[4];
+        std::memcpy(m, &mask, 4);
+        frame.append(m, 4);
+
+        for (size_t i = 0; i < payload.size(); i++)
+        {
+            frame += (char) (payload[i] ^ m[i % 4]);
+        }
+
+        return SendAll(c.fd, frame);
+    }
+
+    void HandleMessage(std::string_view msg, Stats& stats, bool measuring)
+    {
+        if (!measuring)
+        {
+            return;
+        }
+
+        stats.messages++;
+        stats.bytes += msg.size();
+
+        if (msg.find("\"errors\"") != std::string_view::npos)
+        {
+            stats.errors++;
+        }
+
+        auto pos = msg.find("\"ts\":");
+
+        if (pos == std::string_view::npos)
+        {
+            return;
+        }
+
+        int64_t     ts    = 0;
+        const char* begin = msg.data() + pos + 5;
+        const char* last  = msg.data() + msg.size();
+
+        while (begin < last and *begin == ' ')
+        {
+            begin++;
+        }
+
+        if (std::from_chars(begin, last, ts).ec == std::errc{})
+        {
+            const auto latency = std::max<int64_t>(WallClockMicros() - ts, 0);
+            stats.latencies.push_back((uint32_t) std::min<int64_t>(latency, UINT32_MAX));
+        }
+    }
+
+    //! Parses all complete frames in c.in
+    void ProcessFrames(Connection& c, Stats& stats, bool measuring)
+    {
+        size_t offset = 0;
+
+        while (c.in.size() - offset >= 2)
+        {
+            const auto* p      = reinterpret_cast<const unsigned char*>(c.in.data() + offset);
+            const auto  avail  = c.in.size() - offset;
+
+            const bool  fin    = p[0] & 0x80;
+            const int   opcode = p[0] & 0x0F;
+            const bool  masked = p[1] & 0x80;
+            uint64_t    len    = p[1] & 0x7F;
+            size_t      hdr    = 2;
+
+            if (len == 126)
+            {
+                if (avail < 4)
+                    break;
+
+                len = (uint64_t(p[2]) << 8) | p[3];
+                hdr = 4;
+            }
+            else if (len == 127)
+            {
+                if (avail < 10)
+                    break;
+
+                len = 0;
+
+                for (int i = 0; i < 8; i++)
+                {
+                    len = (len << 8) | p[2 + i];
+                }
+
+                hdr = 10;
+            }
+
+            if (masked)
+            {
+                hdr += 4;
+            }
+
+            if (avail < hdr + len)
+            {
+                break;
+            }
+
+            std::string_view payload{c.in.data() + offset + hdr, (size_t) len};
+
+            switch (opcode)
+            {
+                case 0x0:  // continuation
+                case 0x1:  // text
+                case 0x2:  // binary
+                    if (fin and c.message.empty())
+                    {
+                        HandleMessage(payload, stats, measuring);
+                    }
+                    else
+                    {
+                        c.message.append(payload);
+
+                        if (fin)
+                        {
+                            HandleMessage(c.message, stats, measuring);
+                            c.message.clear();
+                        }
+                    }
+                    break;
+                case 0x8:  // close
+                    c.open = false;
+                    break;
+                case 0x9:  // ping
+                    SendText(c, payload, 0xA);
+                    break;
+                default:
+                    break;
+            }
+
+            offset += hdr + len;
+        }
+
+        c.in.erase(0, offset);
+    }
+
+    //! Fetches selected values from the server's Prometheus endpoint
+    bool FetchServerStats(const Options& opt, const std::vector<std::string>& topics, ServerStats& out)
+    {
+        int fd = Connect(opt);
+
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        auto request = fmt::format("GET /metrics HTTP/1.1\r\nHost: {}:{}\r\nConnection: close\r\n\r\n", opt.host, opt.port);
+
+        if (!SendAll(fd, request))
+        {
+            close(fd);
+            return false;
+        }
+
+        std::string body;
+        char        buf[16384];
+
+        while (true)
+        {
+            auto n = recv(fd, buf, sizeof(buf), 0);
+
+            if (n <= 0)
+            {
+                break;
+            }
+
+            body.append(buf, n);
+        }
+
+        close(fd);
+
+        auto value = [&](std::string_view line, std::string_view prefix, double& v) {
+            if (line.starts_with(prefix))
+            {
+                auto rest = line.substr(prefix.size());
+                std::from_chars(rest.data(), rest.data() + rest.size(), v);
+                return true;
+            }
+
+            return false;
+        };
+
+        out = {};
+
+        size_t pos = 0;
+
+        while (pos < body.size())
+        {
+            auto             end  = body.find('\n', pos);
+            std::string_view line = std::string_view{body}.substr(pos, (end == std::string::npos ? body.size() : end) - pos);
+            pos                   = (end == std::string::npos) ? body.size() : end + 1;
+
+            double v;
+
+            if (value(line, "quasar_process_resident_memory_bytes ", v))
+            {
+                out.rss = v;
+            }
+            else if (value(line, "quasar_process_threads ", v))
+            {
+                out.threads = v;
+            }
+            else if (line.starts_with("quasar_source_dropped_total{"))
+            {
+                for (auto&& t : topics)
+                {
+                    if (value(line, fmt::format("quasar_source_dropped_total{{topic=\"{}\"}} ", t), v))
+                    {
+                        out.dropped += v;
+                    }
+                }
+            }
+        }
+
+        return body.starts_with("HTTP/1.1 200");
+    }
+
+    uint32_t Percentile(const std::vector<uint32_t>& sorted, double q)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+
+        auto idx = (size_t) std::ceil(q * sorted.size());
+        return sorted[std::clamp<size_t>(idx, 1, sorted.size()) - 1];
+    }
+}  // namespace
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+
+    if (!ParseOptions(argc, argv, opt))
+    {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> topics;
+
+    for (int i = 0; i < opt.topics; i++)
+    {
+        topics.push_back(fmt::format("{}/t{}", opt.extension, i));
+    }
+
+    std::string subscribe = R"({"method":"subscribe","params":{"topics":[)";
+
+    for (size_t i = 0; i < topics.size(); i++)
+    {
+        subscribe += fmt::format("{}\"{}\"", i ? "," : "", topics[i]);
+    }
+
+    subscribe += "]}}";
+
+    ServerStats before{};
+    FetchServerStats(opt, topics, before);
+
+    // Open connections
+    int                     ep = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Connection> conns(opt.connections);
+    Stats                   stats;
+
+    for (int i = 0; i < opt.connections; i++)
+    {
+        auto& c = conns[i];
+        c.fd    = Connect(opt);
+
+        if (c.fd < 0 or !Handshake(c, opt))
+        {
+            fmt::print(stderr, "Failed to open connection {} to {}:{}\n", i, opt.host, opt.port);
+            return 1;
+        }
+
+        c.open = true;
+
+        if (!opt.auth.empty())
+        {
+            SendText(c, fmt::format(R"({{"method":"auth","params":{{"code":"{}"}}}})", opt.auth));
+        }
+
+        SendText(c, subscribe);
+
+        epoll_event ev{.events = EPOLLIN, .data = {.u32 = (uint32_t) i}};
+        epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+
+    // Run
+    const auto  start        = Clock::now();
+    const auto  measureStart = start + std::chrono::seconds(opt.warmup);
+    const auto  end          = measureStart + std::chrono::seconds(opt.duration);
+
+    epoll_event events[256];
+    char        buf[65536];
+
+    while (Clock::now() < end)
+    {
+        const auto timeout   = std::chrono::duration_cast<std::chrono::milliseconds>(end - Clock::now()).count();
+        int        n         = epoll_wait(ep, events, std::size(events), (int) std::max<int64_t>(timeout, 1));
+
+        const bool measuring = Clock::now() >= measureStart;
+
+        for (int e = 0; e < n; e++)
+        {
+            auto& c = conns[events[e].data.u32];
+
+            while (true)
+            {
+                auto r = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT);
+
+                if (r > 0)
+                {
+                    c.in.append(buf, r);
+                    continue;
+                }
+
+                if (r == 0 or (errno != EAGAIN and errno != EWOULDBLOCK))
+                {
+                    c.open = false;
+                }
+
+                break;
+            }
+
+            ProcessFrames(c, stats, measuring);
+
+            if (!c.open)
+            {
+                epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+            }
+        }
+    }
+
+    const int open = (int) std::count_if(conns.begin(), conns.end(), [](auto& c) {
+        return c.open;
+    });
+
+    ServerStats after{};
+    const bool  haveStats = FetchServerStats(opt, topics, after);
+
+    for (auto& c : conns)
+    {
+        if (c.open)
+        {
+            SendText(c, {}, 0x8);
+        }
+
+        close(c.fd);
+    }
+
+    close(ep);
+
+    // Report
+    std::sort(stats.latencies.begin(), stats.latencies.end());
+
+    const double secs    = opt.duration;
+    const double p50     = Percentile(stats.latencies, 0.50) / 1000.0;
+    const double p90     = Percentile(stats.latencies, 0.90) / 1000.0;
+    const double p99     = Percentile(stats.latencies, 0.99) / 1000.0;
+    const double p999    = Percentile(stats.latencies, 0.999) / 1000.0;
+    const double maxLat  = stats.latencies.empty() ? 0.0 : stats.latencies.back() / 1000.0;
+    const double rate    = stats.messages / secs;
+    const double mbps    = stats.bytes / secs / (1024.0 * 1024.0);
+    const double dropped = after.dropped - before.dropped;
+
+    if (opt.json)
+    {
+        fmt::print("{{\"connections\":{},\"connections_open\":{},\"topics\":{},\"duration_s\":{},\"messages\":{},\"errors\":{},"
+                   "\"messages_per_sec\":{:.1f},\"mib_per_sec\":{:.3f},"
+                   "\"latency_ms\":{{\"p50\":{:.3f},\"p90\":{:.3f},\"p99\":{:.3f},\"p999\":{:.3f},\"max\":{:.3f}}},"
+                   "\"server\":{{\"rss_bytes_before\":{},\"rss_bytes_after\":{},\"threads\":{},\"dropped_ticks\":{}}}}}\n",
+            opt.connections,
+            open,
+            opt.topics,
+            opt.duration,
+            stats.messages,
+            stats.errors,
+            rate,
+            mbps,
+            p50,
+            p90,
+            p99,
+            p999,
+            maxLat,
+            before.rss,
+            after.rss,
+            after.threads,
+            dropped);
+    }
+    else
+    {
+        fmt::print("Connections:  {} ({} still open), {} topics each\n", opt.connections, open, opt.topics);
+        fmt::print("Duration:     {}s after {}s warmup\n", opt.duration, opt.warmup);
+        fmt::print("Messages:     {} ({:.1f}/s, {:.3f} MiB/s), {} with errors\n", stats.messages, rate, mbps, stats.errors);
+        fmt::print("Latency (ms): p50 {:.3f}  p90 {:.3f}  p99 {:.3f}  p99.9 {:.3f}  max {:.3f}\n", p50, p90, p99, p999, maxLat);
+
+        if (haveStats)
+        {
+            fmt::print("Server:       RSS {:.1f} MiB -> {:.1f} MiB, {} threads, {} dropped ticks\n",
+                before.rss / (1024.0 * 1024.0),
+                after.rss / (1024.0 * 1024.0),
+                after.threads,
+                dropped);
+        }
+        else
+        {
+            fmt::print("Server:       /metrics unavailable\n");
+        }
+    }
+
+    return open == opt.connections ? 0 : 2;
+}
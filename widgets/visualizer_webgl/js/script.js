@@ -97,6 +97,7 @@ function subscribe() {
     method: "subscribe",
     params: {
       topics: [source],
+      params: ["u8"],
     },
   };
 
@@ -182,7 +183,8 @@ function parseMsg(msg) {
   const data = JSON.parse(msg);
 
   if (source in data) {
-    sound_data.set(Uint8Array.from(data[source], (x) => Math.floor(x * 255)));
+    // levels arrive quantized to 0 to 255 by the u8 subscription, rounded to the nearest step
+    sound_data.set(data[source]);
     render();
     return;
   }